@@ -37,6 +37,7 @@
 #include <string.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <dirent.h>
@@ -45,6 +46,7 @@
 #include <stdarg.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
 #include "xinit.h"
 #include "../types.h"
 #include "../proedit.h"
@@ -60,6 +62,20 @@ typedef struct exitMessages_t
 	struct exitMessages_t*prev;
 }EXIT_MESSAGE;
 
+typedef struct unixThread_t
+{
+	pthread_t thread;
+	OS_THREAD_PFN*pfn;
+	void*arg;
+}UNIX_THREAD;
+
+typedef struct unixSemaphore_t
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+}UNIX_SEMAPHORE;
+
 extern void InitX11Clipboard(void);
 extern void SetupClipboard(XSelectionRequestEvent*reqevent);
 
@@ -71,13 +87,14 @@ static int screenXD, screenYD;
 static void OS_Paint_Line(char*buffer, int line);
 static int ProcessEvent(int*mode, XEvent*ev, OS_MOUSE*mouse);
 static int WildcardMatch(char*mask, char*filename);
-static void DrawFontString(int x, int y, char*str, int len);
+static void DrawFontString(GC gc, int x, int y, char*str, int len);
 static int CheckWildcard(char*filename);
 static void DisplayMessages(void);
 static void AddMessage(EXIT_MESSAGE*msg);
 static int X11ErrorHandler(Display*display, XErrorEvent*error);
 static int XNextEventTimeout(Display*display, XEvent*ev, struct timeval*tm);
 static int ValidFile(char*pathname);
+static void*ThreadEntry(void*arg);
 
 static int OS_SaveScreenPos(int xp, int yp);
 static int OS_LoadScreenPos(int*xp, int*yp);
@@ -90,7 +107,11 @@ static int OptimizeScreen(char*new, char*prev, int*y1, int*y2);
 static char*original;
 static int lastError;
 
-static void DrawSpecialChar(char ch, int x, int y);
+static void DrawSpecialChar(GC gc, char ch, int x, int y);
+static GC AttrGC(unsigned char attr);
+static void FreeAttrGCs(void);
+static void FlushBacking(void);
+static void MarkBacking(int x1, int y1, int x2, int y2);
 
 #define UP_ARROW   0x10
 #define DOWN_ARROW 0x14
@@ -113,7 +134,18 @@ static int screen_yd = 0;
 
 static int screen_x = 0;
 static int screen_y = 0;
-static int need_redraw = 0;
+
+/* Rows are drawn into the backing pixmap and copied to the window once */
+/* per paint. The box is the cells drawn since the last copy.           */
+static Pixmap backing;
+static GC backingGC;
+static GC attrGC[256];
+static int backX1, backY1, backX2 = -1, backY2 = -1;
+
+/* An event read by OS_InputPending that OS_GetKey has not returned yet */
+static XEvent aheadEvent;
+static int ahead;
+
 static void show_cursor(void);
 static void hide_cursor(void);
 
@@ -344,6 +376,7 @@ int OS_InitScreen(int xd, int yd)
 	int err;
 
 	XSetWindowAttributes xsw;
+	XGCValues xgcv;
 
 	GetFontSize(&font_size_x, &font_size_y, FONT_STRING);
 
@@ -384,6 +417,19 @@ int OS_InitScreen(int xd, int yd)
 	    CWBackPixel | CWBorderPixel | CWWinGravity, &xsw);
 	XClearWindow(xw->display, xw->window);
 
+	/* The window is a fixed size, so the backing pixmap never changes */
+	backing = XCreatePixmap(xw->display, xw->window, screen_xd, screen_yd,
+	    xw->depth);
+
+	xgcv.foreground = BlackPixel(xw->display, xw->screennum);
+	xgcv.graphics_exposures = False;
+
+	backingGC = XCreateGC(xw->display, backing, GCForeground |
+	    GCGraphicsExposures, &xgcv);
+
+	XFillRectangle(xw->display, backing, backingGC, 0, 0, screen_xd,
+	    screen_yd);
+
 	/* Disable the WM_DELETE_WINDOW protocol. We don't want to be shutdown */
 	xw->protocols = XInternAtom(xw->display, "WM_DELETE_WINDOW", 0);
 	XSetWMProtocols(xw->display, xw->window, &xw->protocols, True);
@@ -582,6 +628,21 @@ void OS_Time(char*string)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Milliseconds from an arbitrary start, for timing paints.                #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+unsigned long OS_Clock(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+
+	return ((unsigned long)tv.tv_sec*1000 + tv.tv_usec / 1000);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -603,6 +664,7 @@ int OS_GetFileInfo(char*path, OS_FILE_INFO*info)
 				return (0);
 
 		info->fileSize = filestat.st_size;
+		info->modTime = filestat.st_mtime;
 
 		ptr = ctime(&filestat.st_ctime);
 
@@ -942,6 +1004,189 @@ void OS_DosFindEnd(void)
 	}
 }
 
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_DIR*OS_OpenDir(char*path)
+{
+	int fd;
+	DIR*dirp;
+
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (fd < 0)
+		return (0);
+
+	dirp = fdopendir(fd);
+
+	if (!dirp) {
+		close(fd);
+		return (0);
+	}
+
+	return ((OS_DIR*)dirp);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_ReadDir(OS_DIR*dir, OS_DIR_ENTRY*entry)
+{
+	struct dirent*dp;
+	struct stat filestat;
+	int file_type, link;
+
+	for (; ; ) {
+		dp = readdir((DIR*)dir);
+
+		if (!dp)
+			return (0);
+
+		if (!strcmp(dp->d_name, ".") || !strcmp(dp->d_name, ".."))
+			continue;
+
+		if (strlen(dp->d_name) >= OS_MAX_DIR_ENTRY)
+			continue;
+
+		file_type = 0;
+		link = 0;
+
+		switch (dp->d_type) {
+			case DT_DIR :
+				file_type = FILE_TYPE_DIR;
+				break;
+
+			case DT_REG :
+				file_type = FILE_TYPE_FILE;
+				break;
+
+			case DT_LNK :
+				link = 1;
+				break;
+
+			case DT_UNKNOWN :
+				/* Filesystem doesn't report types, fall back to a stat. */
+				if (!fstatat(dirfd((DIR*)dir), dp->d_name, &filestat,
+				    AT_SYMLINK_NOFOLLOW)) {
+					if (S_ISDIR(filestat.st_mode))
+						file_type = FILE_TYPE_DIR;
+					else
+						if (S_ISREG(filestat.st_mode))
+							file_type = FILE_TYPE_FILE;
+						else
+							if (S_ISLNK(filestat.st_mode))
+								link = 1;
+				}
+				break;
+		}
+
+		/* A link takes the type of its target. Dangling links, devices, */
+		/* sockets and fifos are never reported.                         */
+		if (link && !fstatat(dirfd((DIR*)dir), dp->d_name, &filestat, 0)) {
+			if (S_ISDIR(filestat.st_mode))
+				file_type = FILE_TYPE_DIR;
+			else
+				if (S_ISREG(filestat.st_mode))
+					file_type = FILE_TYPE_FILE;
+		}
+
+		if (!file_type)
+			continue;
+
+		strcpy(entry->name, dp->d_name);
+		entry->file_type = file_type;
+		entry->link = link;
+		entry->fileSize = -1;
+		entry->modTime = 0;
+
+		/* The target was just stat'd, and OS_DirEntryInfo() would only */
+		/* see the link itself.                                         */
+		if (link) {
+			entry->fileSize = filestat.st_size;
+			entry->modTime = filestat.st_mtime;
+		}
+
+		return (1);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_CloseDir(OS_DIR*dir)
+{
+	if (dir)
+		closedir((DIR*)dir);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_DirEntryInfo(OS_DIR*dir, OS_DIR_ENTRY*entry)
+{
+	struct stat filestat;
+
+	if (entry->fileSize != -1)
+		return (1);
+
+	if (fstatat(dirfd((DIR*)dir), entry->name, &filestat,
+	    AT_SYMLINK_NOFOLLOW))
+		return (0);
+
+	entry->fileSize = filestat.st_size;
+	entry->modTime = filestat.st_mtime;
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_DirIdentity(OS_DIR*dir, OS_DIR_ID*id)
+{
+	struct stat filestat;
+
+	if (fstat(dirfd((DIR*)dir), &filestat))
+		return (0);
+
+	id->volume = (unsigned long long)filestat.st_dev;
+	id->file = (unsigned long long)filestat.st_ino;
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_WildcardMatch(char*mask, char*filename)
+{
+	return (WildcardMatch(mask, filename));
+}
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -950,21 +1195,15 @@ void OS_DosFindEnd(void)
 /*###########################################################################*/
 void OS_PaintScreen(char*buffer)
 {
-	int y, draw = 0, newYPos = 12345, newBottom = 56789;
+	int y, newYPos = 12345, newBottom = 56789;
 
 	old_buffer = buffer;
 
 	if (OptimizeScreen(buffer, original, &newYPos, &newBottom)) {
-		if (cursor_visible) {
-			hide_cursor();
-			draw = 1;
-		}
-
 		for (y = newYPos; y <= newBottom; y++)
 			OS_Paint_Line(buffer, y);
 
-		if (draw)
-			show_cursor();
+		FlushBacking();
 	}
 
 	XFlush(xw->display);
@@ -978,17 +1217,9 @@ void OS_PaintScreen(char*buffer)
 /*###########################################################################*/
 void OS_PaintStatus(char*buffer)
 {
-	int draw = 0;
-
-	if (cursor_visible) {
-		hide_cursor();
-		draw = 1;
-	}
-
 	OS_Paint_Line(buffer, screenYD - 1);
 
-	if (draw)
-		show_cursor();
+	FlushBacking();
 
 	XFlush(xw->display);
 }
@@ -996,8 +1227,28 @@ void OS_PaintStatus(char*buffer)
 
 /*###########################################################################*/
 /*#                                                                         #*/
+/*# Paint just the rows the editor says have changed.                       #*/
 /*#                                                                         #*/
+/*###########################################################################*/
+void OS_PaintRows(char*buffer, int*rows, int numRows)
+{
+	int i;
+
+	old_buffer = buffer;
+
+	for (i = 0; i < numRows; i++)
+		OS_Paint_Line(buffer, rows[i]);
+
+	FlushBacking();
+
+	XFlush(xw->display);
+}
+
+
+/*###########################################################################*/
 /*#                                                                         #*/
+/*# Draw the cells of a row that differ from original into the backing      #*/
+/*# pixmap, one string per run of the same attribute.                       #*/
 /*#                                                                         #*/
 /*###########################################################################*/
 static void OS_Paint_Line(char*buffer, int line)
@@ -1016,6 +1267,9 @@ static void OS_Paint_Line(char*buffer, int line)
 		lineAddr += SCR_PTR_SIZE;
 	}
 
+	if (optimizedX1 == screenXD)
+		return ;
+
 	lineAddr = line*screenXD*SCR_PTR_SIZE + (screenXD - 1)*SCR_PTR_SIZE;
 
 	for (optimizedX2 = screenXD - 1; optimizedX2 > optimizedX1; optimizedX2--) {
@@ -1032,40 +1286,114 @@ static void OS_Paint_Line(char*buffer, int line)
 	memcpy(&original[lineAddr], &buffer[lineAddr],
 	    ((optimizedX2 - optimizedX1) + 1)*SCR_PTR_SIZE);
 
-	prev = buffer[lineAddr + 1];
+	MarkBacking(optimizedX1, line, optimizedX2, line);
 
-	XSetForeground(xw->display, xw->gc, xw->palette[FG_COLOR(prev)]);
-	XSetBackground(xw->display, xw->gc, xw->palette[BG_COLOR(prev)]);
+	draw_y = (line + 1)*font_size_y - font_descent;
 
+	prev = buffer[lineAddr + 1];
 	counter = 0;
 	xPos = optimizedX1;
 
 	for (x = optimizedX1; x <= optimizedX2; x++, lineAddr += SCR_PTR_SIZE) {
-		line_text[counter] = buffer[lineAddr];
-
 		attr = buffer[lineAddr + 1];
 
 		if (attr != prev) {
 			draw_x = xPos*font_size_x;
-			draw_y = (line + 1)*font_size_y - font_descent;
-			DrawFontString(draw_x, draw_y, line_text, counter);
+			DrawFontString(AttrGC(prev), draw_x, draw_y, line_text, counter);
 			counter = 0;
 			xPos = x;
 			prev = attr;
-			XSetForeground(xw->display, xw->gc, xw->palette[FG_COLOR(attr)]);
-			XSetBackground(xw->display, xw->gc, xw->palette[BG_COLOR(attr)]);
-			x--;
-			lineAddr -= SCR_PTR_SIZE;
-			continue;
 		}
-		counter++;
+
+		line_text[counter++] = buffer[lineAddr];
 	}
 
 	if (counter) {
 		draw_x = xPos*font_size_x;
-		draw_y = (line + 1)*font_size_y - font_descent;
-		DrawFontString(draw_x, draw_y, line_text, counter);
+		DrawFontString(AttrGC(prev), draw_x, draw_y, line_text, counter);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Move a block of rows by shift rows (up if positive) inside the backing  #*/
+/*# pixmap, so a scroll copies pixels on the server rather than drawing the #*/
+/*# text again. Only the rows it uncovers are left for the editor to paint. #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_ScrollRows(char*buffer, int x, int y, int columns, int rows, int shift)
+{
+	int i, from, to, top, count;
+
+	old_buffer = buffer;
+
+	/* Where the rows that stay in the block land */
+	top = shift > 0 ? y : y - shift;
+	count = rows - abs(shift);
+
+	XCopyArea(xw->display, backing, backing, backingGC, x*font_size_x, (top +
+	    shift)*font_size_y, columns*font_size_x, count*font_size_y, x*
+	    font_size_x, top*font_size_y);
+
+	/* Work away from the edge the rows are moving towards */
+	for (i = 0; i < count; i++) {
+		to = shift > 0 ? y + i : y + rows - 1 - i;
+		from = to + shift;
+
+		memcpy(&original[(x + to*screenXD)*SCR_PTR_SIZE], &original[(x + from*
+		    screenXD)*SCR_PTR_SIZE], columns*SCR_PTR_SIZE);
+	}
+
+	MarkBacking(x, top, x + columns - 1, top + count - 1);
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Add a box of cells to the ones FlushBacking copies to the window.       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void MarkBacking(int x1, int y1, int x2, int y2)
+{
+	if (backX2 < 0) {
+		backX1 = x1;
+		backY1 = y1;
+		backX2 = x2;
+		backY2 = y2;
+	} else {
+		backX1 = MIN(backX1, x1);
+		backY1 = MIN(backY1, y1);
+		backX2 = MAX(backX2, x2);
+		backY2 = MAX(backY2, y2);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The GC that draws attr, made the first time the attribute is seen so a  #*/
+/*# color change costs no request to the server.                            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static GC AttrGC(unsigned char attr)
+{
+	XGCValues values;
+
+	if (!attrGC[attr]) {
+		values.foreground = xw->palette[FG_COLOR(attr)];
+		values.background = xw->palette[BG_COLOR(attr)];
+		values.graphics_exposures = False;
+
+		attrGC[attr] = XCreateGC(xw->display, backing, GCForeground |
+		    GCBackground | GCGraphicsExposures, &values);
+
+		XCopyGC(xw->display, xw->gc, GCFont, attrGC[attr]);
 	}
+
+	return (attrGC[attr]);
 }
 
 
@@ -1075,7 +1403,48 @@ static void OS_Paint_Line(char*buffer, int line)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void DrawFontString(int x, int y, char*str, int len)
+static void FreeAttrGCs(void)
+{
+	int i;
+
+	for (i = 0; i < 256; i++) {
+		if (attrGC[i]) {
+			XFreeGC(xw->display, attrGC[i]);
+			attrGC[i] = 0;
+		}
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Copy the cells drawn since the last call from the backing pixmap to the #*/
+/*# window in one request, then put the cursor back over them.              #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FlushBacking(void)
+{
+	if (backX2 < 0)
+		return ;
+
+	XCopyArea(xw->display, backing, xw->window, backingGC, backX1*font_size_x,
+	    backY1*font_size_y, (backX2 - backX1 + 1)*font_size_x, (backY2 -
+	    backY1 + 1)*font_size_y, backX1*font_size_x, backY1*font_size_y);
+
+	backX2 = backY2 = -1;
+
+	if (cursor_visible)
+		show_cursor();
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void DrawFontString(GC gc, int x, int y, char*str, int len)
 {
 	int i;
 	int newlen = 0;
@@ -1084,13 +1453,13 @@ static void DrawFontString(int x, int y, char*str, int len)
 	for (i = 0; i < len; i++) {
 		if (str[i] == UP_ARROW || str[i] == DOWN_ARROW) {
 			if (newlen) {
-				XDrawImageString(xw->display, xw->window, xw->gc, x, y, &str[
-				    index], newlen);
+				XDrawImageString(xw->display, backing, gc, x, y, &str[index],
+				    newlen);
 				index += newlen;
 			}
 			x += (font_size_x*newlen);
-			XDrawImageString(xw->display, xw->window, xw->gc, x, y, " ", 1);
-			DrawSpecialChar(str[i], x, (y - font_size_y) + font_descent);
+			XDrawImageString(xw->display, backing, gc, x, y, " ", 1);
+			DrawSpecialChar(gc, str[i], x, (y - font_size_y) + font_descent);
 			x += font_size_x;
 			index = i + 1;
 			newlen = 0;
@@ -1099,55 +1468,52 @@ static void DrawFontString(int x, int y, char*str, int len)
 	}
 
 	if (newlen)
-		XDrawImageString(xw->display, xw->window, xw->gc, x, y, &str[index],
-		    newlen);
+		XDrawImageString(xw->display, backing, gc, x, y, &str[index], newlen);
 }
 
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# The arrow glyphs the font lacks, drawn as one request of segments.      #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void DrawSpecialChar(char ch, int x, int y)
+static void DrawSpecialChar(GC gc, char ch, int x, int y)
 {
-	int xp, yp;
-
-	XDrawLine(xw->display, xw->window, xw->gc, x + font_size_x / 2 - 1, y + 4,
-	    x + font_size_x / 2 - 1, y + font_size_y - 5);
-
-	XDrawLine(xw->display, xw->window, xw->gc, x + font_size_x / 2, y + 3, x +
-	    font_size_x / 2, y + font_size_y - 4);
+	XSegment seg[9];
+	int i, xp, yp, dy, count = 3;
 
-	XDrawLine(xw->display, xw->window, xw->gc, x + font_size_x / 2 + 1, y + 4,
-	    x + font_size_x / 2 + 1, y + font_size_y - 5);
+	xp = x + font_size_x / 2;
 
-	if (ch == UP_ARROW) {
-		xp = x + font_size_x / 2;
-		yp = y + 3;
-
-		XDrawLine(xw->display, xw->window, xw->gc, xp - 1, yp, xp - 4, yp + 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp, yp, xp - 3, yp + 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp + 1, yp, xp - 2, yp + 2);
-
-		XDrawLine(xw->display, xw->window, xw->gc, xp - 1, yp, xp + 2, yp + 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp, yp, xp + 3, yp + 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp + 1, yp, xp + 4, yp + 2);
+	/* The shaft, three pixels wide */
+	for (i = 0; i < 3; i++) {
+		seg[i].x1 = seg[i].x2 = (short)(xp + i - 1);
+		seg[i].y1 = (short)(y + (i == 1 ? 3 : 4));
+		seg[i].y2 = (short)(y + font_size_y - (i == 1 ? 4 : 5));
 	}
 
-	if (ch == DOWN_ARROW) {
-		xp = x + font_size_x / 2;
-		yp = y + font_size_y - 4;
+	if (ch == UP_ARROW || ch == DOWN_ARROW) {
+		if (ch == UP_ARROW) {
+			yp = y + 3;
+			dy = 2;
+		} else {
+			yp = y + font_size_y - 4;
+			dy = -2;
+		}
 
-		XDrawLine(xw->display, xw->window, xw->gc, xp - 1, yp, xp - 4, yp - 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp, yp, xp - 3, yp - 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp + 1, yp, xp - 2, yp - 2);
+		/* Both sides of the head, three pixels thick */
+		for (i = 0; i < 3; i++) {
+			seg[count].x1 = seg[count + 3].x1 = (short)(xp + i - 1);
+			seg[count].y1 = seg[count + 3].y1 = (short)yp;
+			seg[count].x2 = (short)(xp + i - 4);
+			seg[count + 3].x2 = (short)(xp + i + 2);
+			seg[count].y2 = seg[count + 3].y2 = (short)(yp + dy);
+			count++;
+		}
 
-		XDrawLine(xw->display, xw->window, xw->gc, xp - 1, yp, xp + 2, yp - 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp, yp, xp + 3, yp - 2);
-		XDrawLine(xw->display, xw->window, xw->gc, xp + 1, yp, xp + 4, yp - 2);
+		count += 3;
 	}
+
+	XDrawSegments(xw->display, backing, gc, seg, count);
 }
 
 
@@ -1193,7 +1559,7 @@ static int OptimizeScreen(char*new, char*prev, int*y1, int*y2)
 /*###########################################################################*/
 static void show_cursor(void)
 {
-	int draw_x, draw_y, y;
+	int draw_x, draw_y;
 	char attr;
 
 	if (!old_buffer)
@@ -1205,15 +1571,12 @@ static void show_cursor(void)
 		attr = old_buffer[((cursor_x - 1)*SCR_PTR_SIZE) +
 		((cursor_y - 1)*(screenXD*SCR_PTR_SIZE)) + 1];
 
-		XSetForeground(xw->display, xw->gc, xw->palette[FG_COLOR(attr)]);
-
 		draw_x = (cursor_x - 1)*font_size_x;
 		draw_y = (font_size_y*cursor_y) - font_descent;
 
-		for (y = 0; y < cursor_height; y++) {
-			XDrawLine(xw->display, xw->window, xw->gc, draw_x, draw_y - y,
-			    draw_x + font_size_x - 1, draw_y - y);
-		}
+		XFillRectangle(xw->display, xw->window, AttrGC((unsigned char)attr),
+		    draw_x, draw_y - cursor_height + 1, font_size_x, cursor_height);
+
 		XFlush(xw->display);
 	}
 }
@@ -1221,37 +1584,18 @@ static void show_cursor(void)
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# The cell under the cursor is still in the backing pixmap, so copy it    #*/
+/*# back rather than draw it again.                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
 static void hide_cursor(void)
 {
-	char byte[2], attr;
-	int draw_x, draw_y;
-
 	if (!old_buffer)
 		return ;
 
-	byte[0] = old_buffer[((cursor_x - 1)*SCR_PTR_SIZE) +
-	((cursor_y - 1)*(screenXD*SCR_PTR_SIZE))];
-
-	attr = old_buffer[((cursor_x - 1)*SCR_PTR_SIZE) +
-	((cursor_y - 1)*(screenXD*SCR_PTR_SIZE)) + 1];
-
-	XSetForeground(xw->display, xw->gc, xw->palette[FG_COLOR(attr)]);
-	XSetBackground(xw->display, xw->gc, xw->palette[BG_COLOR(attr)]);
-
-	draw_x = (cursor_x - 1)*font_size_x;
-	draw_y = (font_size_y*cursor_y) - font_descent;
-
-	if (byte[0] == UP_ARROW || byte[0] == DOWN_ARROW) {
-		XDrawImageString(xw->display, xw->window, xw->gc, draw_x, draw_y, " ",
-		    1);
-		DrawSpecialChar(byte[0], draw_x, (cursor_y - 1)*font_size_y);
-	} else
-		XDrawImageString(xw->display, xw->window, xw->gc, draw_x, draw_y, byte,
-		    1);
+	XCopyArea(xw->display, backing, xw->window, backingGC, (cursor_x - 1)*
+	    font_size_x, (cursor_y - 1)*font_size_y, font_size_x, font_size_y,
+	    (cursor_x - 1)*font_size_x, (cursor_y - 1)*font_size_y);
 
 	cursor_visible = 0;
 	XFlush(xw->display);
@@ -1321,6 +1665,9 @@ void OS_Exit()
 		XGetWindowAttributes(xw->display, xw->window, &xgw);
 		//   	if (xgw.x != screen_x || xgw.y != screen_y)
 		OS_SaveScreenPos(screen_x, screen_y);
+		FreeAttrGCs();
+		XFreeGC(xw->display, backingGC);
+		XFreePixmap(xw->display, backing);
 		TrashXWindow(xw);
 		OS_Free(xw);
 	}
@@ -1490,6 +1837,11 @@ int OS_GetKey(int*mode, OS_MOUSE*mouse)
 	mouse->buttonStatus = 0;
 	mouse->moveStatus = 0;
 
+	if (ahead) {
+		ahead = 0;
+		return (ProcessEvent(mode, &aheadEvent, mouse));
+	}
+
 	blink = GetCursorBlink();
 
 	for (; ; ) {
@@ -1511,14 +1863,6 @@ int OS_GetKey(int*mode, OS_MOUSE*mouse)
 				if (clock_pfn)
 					clock_pfn();
 			}
-
-			if (need_redraw) {
-				need_redraw = 0;
-				if (old_buffer) {
-					memset(original, 0, screenXD*screenYD*SCR_PTR_SIZE);
-					OS_PaintScreen(old_buffer);
-				}
-			}
 		}
 	}
 }
@@ -1623,6 +1967,10 @@ int OS_PeekKey(int*mode, OS_MOUSE*mouse)
 {
 	XEvent ev;
 
+	/* An event read ahead comes first; leave it for OS_GetKey */
+	if (ahead)
+		return (0);
+
 	if (XCheckWindowEvent(xw->display, xw->window,
 	    KeyPressMask | KeyReleaseMask | ExposureMask, &ev))
 		return (ProcessEvent(mode, &ev, mouse));
@@ -1631,6 +1979,29 @@ int OS_PeekKey(int*mode, OS_MOUSE*mouse)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Read ahead through queued events until one of them gives a key. The     #*/
+/*# event is kept for OS_GetKey, so the caller can skip painting while      #*/
+/*# more input is waiting.                                                  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_InputPending(void)
+{
+	OS_MOUSE mouse;
+	int mode;
+
+	while (!ahead && XPending(xw->display)) {
+		XNextEvent(xw->display, &aheadEvent);
+
+		memset(&mouse, 0, sizeof(OS_MOUSE));
+		ahead = ProcessEvent(&mode, &aheadEvent, &mouse) != 0;
+	}
+
+	return (ahead);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -1640,6 +2011,7 @@ int OS_PeekKey(int*mode, OS_MOUSE*mouse)
 static int ProcessEvent(int*mode, XEvent*ev, OS_MOUSE*mouse)
 {
 	static int alt = 0, ctrl = 0, shift = 0;
+	XEvent next;
 	long KEY;
 
 	if (ev->type == ClientMessage)
@@ -1708,6 +2080,16 @@ static int ProcessEvent(int*mode, XEvent*ev, OS_MOUSE*mouse)
 	}
 
 	if (ev->type == MotionNotify) {
+		/* Only the last of a run of motion events matters */
+		while (XPending(xw->display)) {
+			XPeekEvent(xw->display, &next);
+
+			if (next.type != MotionNotify)
+				break;
+
+			XNextEvent(xw->display, ev);
+		}
+
 		mouse->xpos = ev->xmotion.x / font_size_x;
 		mouse->ypos = ev->xmotion.y / font_size_y;
 		mouse->moveStatus = 1;
@@ -1861,8 +2243,14 @@ static int ProcessEvent(int*mode, XEvent*ev, OS_MOUSE*mouse)
 		}
 	}
 
+	/* Everything painted is still in the backing pixmap */
 	if (ev->type == Expose) {
-		need_redraw = 1;
+		XCopyArea(xw->display, backing, xw->window, backingGC, ev->xexpose.x,
+		    ev->xexpose.y, ev->xexpose.width, ev->xexpose.height, ev->xexpose.
+		    x, ev->xexpose.y);
+
+		if (cursor_visible)
+			show_cursor();
 	}
 
 	return (0);
@@ -2121,6 +2509,8 @@ static void change_font_window(char*fontName)
 	if (!font_struct)
 		goto font_error;
 
+	FreeAttrGCs();
+
 	if (old_buffer) {
 		memset(original, 0, screenXD*screenYD*SCR_PTR_SIZE);
 		OS_PaintScreen(old_buffer);
@@ -2206,6 +2596,230 @@ long OS_Filesize(FILE_HANDLE*fp)
 	return (size);
 }
 
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void*OS_MapFile(FILE_HANDLE*fp, long size)
+{
+	void*data;
+
+	if (size <= 0)
+		return (0);
+
+	data = mmap(0, size, PROT_READ, MAP_PRIVATE, fileno((FILE*)fp), 0);
+
+	if (data == MAP_FAILED)
+		return (0);
+
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	return (data);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_UnmapFile(void*data, long size)
+{
+	if (data)
+		munmap(data, size);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void*ThreadEntry(void*arg)
+{
+	UNIX_THREAD*thread = (UNIX_THREAD*)arg;
+
+	thread->pfn(thread->arg);
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_THREAD*OS_CreateThread(OS_THREAD_PFN*pfn, void*arg)
+{
+	UNIX_THREAD*thread;
+
+	thread = OS_Malloc(sizeof(UNIX_THREAD));
+
+	thread->pfn = pfn;
+	thread->arg = arg;
+
+	if (pthread_create(&thread->thread, 0, ThreadEntry, thread)) {
+		OS_Free(thread);
+		return (0);
+	}
+
+	return (thread);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_JoinThread(OS_THREAD*thread)
+{
+	pthread_join(((UNIX_THREAD*)thread)->thread, 0);
+
+	OS_Free(thread);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_MUTEX*OS_CreateMutex(void)
+{
+	pthread_mutex_t*mutex;
+
+	mutex = OS_Malloc(sizeof(pthread_mutex_t));
+
+	pthread_mutex_init(mutex, 0);
+
+	return (mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_DestroyMutex(OS_MUTEX*mutex)
+{
+	pthread_mutex_destroy((pthread_mutex_t*)mutex);
+
+	OS_Free(mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_LockMutex(OS_MUTEX*mutex)
+{
+	pthread_mutex_lock((pthread_mutex_t*)mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_UnlockMutex(OS_MUTEX*mutex)
+{
+	pthread_mutex_unlock((pthread_mutex_t*)mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_NumProcessors(void)
+{
+	long count;
+
+	count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (count > 0 ? (int)count : 1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_SEMAPHORE*OS_CreateSemaphore(void)
+{
+	UNIX_SEMAPHORE*semaphore;
+
+	semaphore = OS_Malloc(sizeof(UNIX_SEMAPHORE));
+
+	pthread_mutex_init(&semaphore->mutex, 0);
+	pthread_cond_init(&semaphore->cond, 0);
+	semaphore->count = 0;
+
+	return (semaphore);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_DestroySemaphore(OS_SEMAPHORE*semaphore)
+{
+	UNIX_SEMAPHORE*unixSemaphore = (UNIX_SEMAPHORE*)semaphore;
+
+	pthread_cond_destroy(&unixSemaphore->cond);
+	pthread_mutex_destroy(&unixSemaphore->mutex);
+
+	OS_Free(semaphore);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PostSemaphore(OS_SEMAPHORE*semaphore)
+{
+	UNIX_SEMAPHORE*unixSemaphore = (UNIX_SEMAPHORE*)semaphore;
+
+	pthread_mutex_lock(&unixSemaphore->mutex);
+	unixSemaphore->count++;
+	pthread_cond_signal(&unixSemaphore->cond);
+	pthread_mutex_unlock(&unixSemaphore->mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_WaitSemaphore(OS_SEMAPHORE*semaphore)
+{
+	UNIX_SEMAPHORE*unixSemaphore = (UNIX_SEMAPHORE*)semaphore;
+
+	pthread_mutex_lock(&unixSemaphore->mutex);
+
+	while (!unixSemaphore->count)
+		pthread_cond_wait(&unixSemaphore->cond, &unixSemaphore->mutex);
+
+	unixSemaphore->count--;
+	pthread_mutex_unlock(&unixSemaphore->mutex);
+}
+
 /*##########################################################################*/
 /*#                                                                        #*/
 /*#                                                                        #*/
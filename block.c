@@ -539,12 +539,15 @@ void CopyRegionUpdate(EDIT_FILE*file)
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# The columns of line y that the selection covers, as the span from up    #*/
+/*# to but not including to, so a row is worked out once rather than once   #*/
+/*# per character. Returns 0 if none are. A span that runs past the end of  #*/
+/*# the line ends at COPY_TO_END.                                           #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-int CopyCheck(EDIT_FILE*file, EDIT_LINE*line, int x, int y)
+int CopySpan(EDIT_FILE*file, EDIT_LINE*line, int y, int*from, int*to)
 {
+	COPY_SAVE*first, *last;
 	int start, stop, x1, x2;
 
 	x1 = MIN(file->copyFrom.offset, file->copyTo.offset);
@@ -552,73 +555,52 @@ int CopyCheck(EDIT_FILE*file, EDIT_LINE*line, int x, int y)
 	start = MIN(file->copyFrom.line, file->copyTo.line);
 	stop = MAX(file->copyFrom.line, file->copyTo.line);
 
-	if (file->copyStatus&COPY_BLOCK) {
-		if (y >= start && y <= stop) {
-			/* Is the rightmost select anchor sitting on a TAB? If so, lets */
-			/* Include all of the tab padding in the display selection.     */
-			if (x2 < line->len && line->line[x2] == ED_KEY_TAB)
-				while (((x2 + 1) < line->len) && (line->line[x2 + 1] ==
-				    ED_KEY_TABPAD))
-					x2++;
-
-			if (x >= x1 && x <= x2)
-				return (1);
-			return (0);
-		}
-	}
+	if (!(file->copyStatus&COPY_ON) || y < start || y > stop)
+		return (0);
 
-	if (file->copyStatus&COPY_SELECT) {
-		if (y >= start && y <= stop) {
-			if (y > start && y < stop)
-				return (1);
-
-			if (start == stop) {
-				if (x >= x1 && x < x2)
-					return (1);
-				return (0);
-			}
+	*from = 0;
+	*to = COPY_TO_END;
 
+	if (file->copyStatus&COPY_BLOCK) {
+		/* Is the rightmost select anchor sitting on a TAB? If so, lets */
+		/* Include all of the tab padding in the display selection.     */
+		if (x2 < line->len && line->line[x2] == ED_KEY_TAB)
+			while (((x2 + 1) < line->len) && (line->line[x2 + 1] ==
+			    ED_KEY_TABPAD))
+				x2++;
+
+		*from = x1;
+		*to = x2 + 1;
+	} else
+		if (file->copyStatus&COPY_SELECT) {
 			if (file->copyFrom.line < file->copyTo.line) {
-				if (y == file->copyTo.line)
-					if (x < file->copyTo.offset)
-						return (1);
-
-				if (y == file->copyFrom.line)
-					if (x >= file->copyFrom.offset)
-						return (1);
+				first = &file->copyFrom;
+				last = &file->copyTo;
 			} else {
-				if (y == file->copyFrom.line)
-					if (x < file->copyFrom.offset)
-						return (1);
-
-				if (y == file->copyTo.line)
-					if (x >= file->copyTo.offset)
-						return (1);
+				first = &file->copyTo;
+				last = &file->copyFrom;
 			}
-		}
-	}
-
-	if (file->copyStatus&COPY_LINE) {
-		if (y >= start && y <= stop) {
-			if (y > start && y < stop)
-				return (1);
 
-			if (start == stop)
-				return (1);
-
-			if (file->copyFrom.line < file->copyTo.line) {
-				if (y == file->copyFrom.line)
-					return (1);
+			if (start == stop) {
+				*from = x1;
+				*to = x2;
 			} else {
-				if (y == file->copyTo.line)
-					return (1);
-				if (y == file->copyFrom.line)
-					return (1);
+				if (y == first->line)
+					*from = first->offset;
+
+				if (y == last->line)
+					*to = last->offset;
 			}
-		}
-	}
+		} else
+			if (file->copyStatus&COPY_LINE) {
+				/* A line selection made downwards stops short of its end */
+				if (start != stop && y == file->copyTo.line && file->copyFrom.
+				    line < file->copyTo.line)
+					return (0);
+			} else
+				return (0);
 
-	return (0);
+	return (*from < *to);
 }
 
 
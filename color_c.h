@@ -31,14 +31,6 @@
 #ifndef __COLOR_C_H__
 #define __COLOR_C_H__
 
-void SetupColors_C(void);
-void ColorLines_C(EDIT_LINE*lines);
-void Colorize_C(EDIT_LINE*line, int pan, int len, SCR_PTR*screen, int address,
-    char defaultAttr);
-int Colorize_C_LinePfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+extern LEX_LANGUAGE language_C;
 
 #endif /* __COLOR_C_H__ */
-
-
-
-
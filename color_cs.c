@@ -29,751 +29,125 @@
 
 
 #include "osdep.h" /* Platform dependent interface */
-#include <string.h>
-#include <stdio.h>
-#include <errno.h>
-#include <stdlib.h>
 #include "proedit.h"
+#include "lexer.h"
 #include "color_cs.h"
 
-#define MAX_FIND 256
-
-static SCR_PTR color_operator;
-static SCR_PTR color_number;
-static SCR_PTR color_char;
-static SCR_PTR color_string;
-static SCR_PTR color_comment;
-static SCR_PTR color_xml_comment;
-static SCR_PTR color_keyword;
-static SCR_PTR color_preprocessor;
-
-#define LINE_FLAG_HEAD  (LINE_FLAG_CUSTOM<<1)
-#define LINE_FLAG_TAIL  (LINE_FLAG_CUSTOM<<2)
-#define LINE_FLAG_MID   (LINE_FLAG_CUSTOM<<3)
-
-#define LINE_FLAG_OPENS (LINE_FLAG_CUSTOM<<4)
-#define LINE_FLAG_OPENQ (LINE_FLAG_CUSTOM<<5)
-
-#define LINE_FLAG_MASK (LINE_FLAG_HEAD|LINE_FLAG_TAIL|LINE_FLAG_MID)
-
-static void ClearMidTail(EDIT_LINE*line);
-
-static int GetLineFlags(EDIT_LINE*line);
-static void ProcessEdit(EDIT_LINE*line);
-static void ProcessInsert(EDIT_LINE*line);
-static void ProcessDelete(EDIT_LINE*line);
-static int ProcessComments(EDIT_LINE*line, int*index, int*state);
-static int SymbolCheck(int index, EDIT_LINE*line, int column);
-static int NotAChar(char ch);
-static void FindNewTail(EDIT_LINE*line);
-
-/* Macro used for colorizing algorythim */
-#define NOTANUM(ch)  ((ch>='0'&&ch<='9')?(0):(1))
-
-static char operatorLUT[] = {"|&,.><=!()[]{}%^:;~-+*/"};
-
-static struct textBlockColorLUT
+static LEX_BLOCK blocks[] =
 {
-	char*start, *end;
-	char escape, len1, len2;
-	SCR_PTR*color;
-}blockLUT[] =
-{
-	{"'", "'", '\\', 1, 1, &color_char},
-	{"\"", "\"", '\\', 1, 1, &color_string},
-	{"/*", "*/", 0, 2, 2, &color_comment},
-	{"///", "\r", 0, 3, 1, &color_xml_comment},
-	{"//", "\r", 0, 2, 1, &color_comment},
+	{"'", "'", '\\', 1, 1, 0, LEX_COLOR_CHAR},
+	{"\"", "\"", '\\', 1, 1, 0, LEX_COLOR_STRING},
+	{"/*", "*/", 0, 2, 2, LEX_BLOCK_LINES, LEX_COLOR_COMMENT},
+	{"///", 0, 0, 3, 0, 0, LEX_COLOR_XML_COMMENT},
+	{"//", 0, 0, 2, 0, 0, LEX_COLOR_COMMENT},
 };
 
-#define BLOCK_TYPE_SQUOTE      1
-#define BLOCK_TYPE_DQUOTE      2
-#define BLOCK_TYPE_C_COMMENT   3
-#define BLOCK_TYPE_CPP_COMMENT 4
-
-static char*numberLUT = {"0123456789"};
-static char*numberLUT2 = {"0123456789xX.lLfFabcdefABCDEF"};
-
-#define NUMBER_BLOCK_ENTRIES (sizeof(blockLUT) / sizeof(struct textBlockColorLUT))
-
-static struct textColorLUT
-{
-	char*text;
-	int len;
-	SCR_PTR*color;
-}colorLUT[] =
-{
-	{"stackalloc", 10, &color_keyword},
-	{"protected", 9, &color_keyword},
-	{"unchecked", 9, &color_keyword},
-	{"interface", 9, &color_keyword},
-	{"namespace", 9, &color_keyword},
-	{"abstract", 8, &color_keyword},
-	{"continue", 8, &color_keyword},
-	{"delegate", 8, &color_keyword},
-	{"explicit", 8, &color_keyword},
-	{"internal", 8, &color_keyword},
-	{"implicit", 8, &color_keyword},
-	{"operator", 8, &color_keyword},
-	{"override", 8, &color_keyword},
-	{"readonly", 8, &color_keyword},
-	{"volatile", 8, &color_keyword},
-	{"decimal", 7, &color_keyword},
-	{"default", 7, &color_keyword},
-	{"checked", 7, &color_keyword},
-	{"finally", 7, &color_keyword},
-	{"foreach", 7, &color_keyword},
-	{"partial", 7, &color_keyword},
-	{"private", 7, &color_keyword},
-	{"virtual", 7, &color_keyword},
-	{"extern", 6, &color_keyword},
-	{"double", 6, &color_keyword},
-	{"return", 6, &color_keyword},
-	{"sealed", 6, &color_keyword},
-	{"sizeof", 6, &color_keyword},
-	{"static", 6, &color_keyword},
-	{"string", 6, &color_keyword},
-	{"unsafe", 6, &color_keyword},
-	{"ushort", 6, &color_keyword},
-	{"struct", 6, &color_keyword},
-	{"switch", 6, &color_keyword},
-	{"typeof", 6, &color_keyword},
-	{"params", 6, &color_keyword},
-	{"public", 6, &color_keyword},
-	{"object", 6, &color_keyword},
-	{"catch", 5, &color_keyword},
-	{"class", 5, &color_keyword},
-	{"using", 5, &color_keyword},
-	{"throw", 5, &color_keyword},
-	{"value", 5, &color_keyword},
-	{"where", 5, &color_keyword},
-	{"while", 5, &color_keyword},
-	{"yield", 5, &color_keyword},
-	{"const", 5, &color_keyword},
-	{"event", 5, &color_keyword},
-	{"fixed", 5, &color_keyword},
-	{"float", 5, &color_keyword},
-	{"false", 5, &color_keyword},
-	{"break", 5, &color_keyword},
-	{"sbyte", 5, &color_keyword},
-	{"short", 5, &color_keyword},
-	{"ulong", 5, &color_keyword},
-	{"base", 4, &color_keyword},
-	{"bool", 4, &color_keyword},
-	{"void", 4, &color_keyword},
-	{"uint", 4, &color_keyword},
-	{"true", 4, &color_keyword},
-	{"byte", 4, &color_keyword},
-	{"case", 4, &color_keyword},
-	{"char", 4, &color_keyword},
-	{"else", 4, &color_keyword},
-	{"enum", 4, &color_keyword},
-	{"goto", 4, &color_keyword},
-	{"lock", 4, &color_keyword},
-	{"long", 4, &color_keyword},
-	{"null", 4, &color_keyword},
-	{"this", 4, &color_keyword},
-	{"try", 3, &color_keyword},
-	{"for", 3, &color_keyword},
-	{"new", 3, &color_keyword},
-	{"get", 3, &color_keyword},
-	{"int", 3, &color_keyword},
-	{"set", 3, &color_keyword},
-	{"out", 3, &color_keyword},
-	{"ref", 3, &color_keyword},
-	{"as", 2, &color_keyword},
-	{"do", 2, &color_keyword},
-	{"if", 2, &color_keyword},
-	{"in", 2, &color_keyword},
-	{"is", 2, &color_keyword},
-	{"#if", 3, &color_preprocessor},
-	{"#line", 5, &color_preprocessor},
-	{"#else", 5, &color_preprocessor},
-	{"#elif", 5, &color_preprocessor},
-	{"#endif", 6, &color_preprocessor},
-	{"#undef", 6, &color_preprocessor},
-	{"#error", 6, &color_preprocessor},
-	{"#define", 7, &color_preprocessor},
-	{"#pragma", 7, &color_preprocessor},
-	{"#region", 7, &color_preprocessor},
-	{"#warning", 8, &color_preprocessor},
-	{"#endregion", 10, &color_preprocessor},
+static LEX_KEYWORD keywords[] =
+{
+	{"stackalloc", 10, LEX_COLOR_KEYWORD},
+	{"protected", 9, LEX_COLOR_KEYWORD},
+	{"unchecked", 9, LEX_COLOR_KEYWORD},
+	{"interface", 9, LEX_COLOR_KEYWORD},
+	{"namespace", 9, LEX_COLOR_KEYWORD},
+	{"abstract", 8, LEX_COLOR_KEYWORD},
+	{"continue", 8, LEX_COLOR_KEYWORD},
+	{"delegate", 8, LEX_COLOR_KEYWORD},
+	{"explicit", 8, LEX_COLOR_KEYWORD},
+	{"internal", 8, LEX_COLOR_KEYWORD},
+	{"implicit", 8, LEX_COLOR_KEYWORD},
+	{"operator", 8, LEX_COLOR_KEYWORD},
+	{"override", 8, LEX_COLOR_KEYWORD},
+	{"readonly", 8, LEX_COLOR_KEYWORD},
+	{"volatile", 8, LEX_COLOR_KEYWORD},
+	{"decimal", 7, LEX_COLOR_KEYWORD},
+	{"default", 7, LEX_COLOR_KEYWORD},
+	{"checked", 7, LEX_COLOR_KEYWORD},
+	{"finally", 7, LEX_COLOR_KEYWORD},
+	{"foreach", 7, LEX_COLOR_KEYWORD},
+	{"partial", 7, LEX_COLOR_KEYWORD},
+	{"private", 7, LEX_COLOR_KEYWORD},
+	{"virtual", 7, LEX_COLOR_KEYWORD},
+	{"extern", 6, LEX_COLOR_KEYWORD},
+	{"double", 6, LEX_COLOR_KEYWORD},
+	{"return", 6, LEX_COLOR_KEYWORD},
+	{"sealed", 6, LEX_COLOR_KEYWORD},
+	{"sizeof", 6, LEX_COLOR_KEYWORD},
+	{"static", 6, LEX_COLOR_KEYWORD},
+	{"string", 6, LEX_COLOR_KEYWORD},
+	{"unsafe", 6, LEX_COLOR_KEYWORD},
+	{"ushort", 6, LEX_COLOR_KEYWORD},
+	{"struct", 6, LEX_COLOR_KEYWORD},
+	{"switch", 6, LEX_COLOR_KEYWORD},
+	{"typeof", 6, LEX_COLOR_KEYWORD},
+	{"params", 6, LEX_COLOR_KEYWORD},
+	{"public", 6, LEX_COLOR_KEYWORD},
+	{"object", 6, LEX_COLOR_KEYWORD},
+	{"catch", 5, LEX_COLOR_KEYWORD},
+	{"class", 5, LEX_COLOR_KEYWORD},
+	{"using", 5, LEX_COLOR_KEYWORD},
+	{"throw", 5, LEX_COLOR_KEYWORD},
+	{"value", 5, LEX_COLOR_KEYWORD},
+	{"where", 5, LEX_COLOR_KEYWORD},
+	{"while", 5, LEX_COLOR_KEYWORD},
+	{"yield", 5, LEX_COLOR_KEYWORD},
+	{"const", 5, LEX_COLOR_KEYWORD},
+	{"event", 5, LEX_COLOR_KEYWORD},
+	{"fixed", 5, LEX_COLOR_KEYWORD},
+	{"float", 5, LEX_COLOR_KEYWORD},
+	{"false", 5, LEX_COLOR_KEYWORD},
+	{"break", 5, LEX_COLOR_KEYWORD},
+	{"sbyte", 5, LEX_COLOR_KEYWORD},
+	{"short", 5, LEX_COLOR_KEYWORD},
+	{"ulong", 5, LEX_COLOR_KEYWORD},
+	{"base", 4, LEX_COLOR_KEYWORD},
+	{"bool", 4, LEX_COLOR_KEYWORD},
+	{"void", 4, LEX_COLOR_KEYWORD},
+	{"uint", 4, LEX_COLOR_KEYWORD},
+	{"true", 4, LEX_COLOR_KEYWORD},
+	{"byte", 4, LEX_COLOR_KEYWORD},
+	{"case", 4, LEX_COLOR_KEYWORD},
+	{"char", 4, LEX_COLOR_KEYWORD},
+	{"else", 4, LEX_COLOR_KEYWORD},
+	{"enum", 4, LEX_COLOR_KEYWORD},
+	{"goto", 4, LEX_COLOR_KEYWORD},
+	{"lock", 4, LEX_COLOR_KEYWORD},
+	{"long", 4, LEX_COLOR_KEYWORD},
+	{"null", 4, LEX_COLOR_KEYWORD},
+	{"this", 4, LEX_COLOR_KEYWORD},
+	{"try", 3, LEX_COLOR_KEYWORD},
+	{"for", 3, LEX_COLOR_KEYWORD},
+	{"new", 3, LEX_COLOR_KEYWORD},
+	{"get", 3, LEX_COLOR_KEYWORD},
+	{"int", 3, LEX_COLOR_KEYWORD},
+	{"set", 3, LEX_COLOR_KEYWORD},
+	{"out", 3, LEX_COLOR_KEYWORD},
+	{"ref", 3, LEX_COLOR_KEYWORD},
+	{"as", 2, LEX_COLOR_KEYWORD},
+	{"do", 2, LEX_COLOR_KEYWORD},
+	{"if", 2, LEX_COLOR_KEYWORD},
+	{"in", 2, LEX_COLOR_KEYWORD},
+	{"is", 2, LEX_COLOR_KEYWORD},
+	{"#if", 3, LEX_COLOR_PREPROCESSOR},
+	{"#line", 5, LEX_COLOR_PREPROCESSOR},
+	{"#else", 5, LEX_COLOR_PREPROCESSOR},
+	{"#elif", 5, LEX_COLOR_PREPROCESSOR},
+	{"#endif", 6, LEX_COLOR_PREPROCESSOR},
+	{"#undef", 6, LEX_COLOR_PREPROCESSOR},
+	{"#error", 6, LEX_COLOR_PREPROCESSOR},
+	{"#define", 7, LEX_COLOR_PREPROCESSOR},
+	{"#pragma", 7, LEX_COLOR_PREPROCESSOR},
+	{"#region", 7, LEX_COLOR_PREPROCESSOR},
+	{"#warning", 8, LEX_COLOR_PREPROCESSOR},
+	{"#endregion", 10, LEX_COLOR_PREPROCESSOR},
 };
 
-#define NUMBER_TEXT_ENTRIES (sizeof(colorLUT)/sizeof(struct textColorLUT))
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-void ColorLines_CS(EDIT_LINE*lines)
-{
-	EDIT_LINE*walk;
-
-	walk = lines;
-
-	/* Strip existing colorizing flags from all lines. */
-	while (walk) {
-		walk->flags &= ~LINE_FLAG_MASK;
-		walk = walk->next;
-	}
-
-	walk = lines;
-
-	/* Colorize comments. */
-	while (walk) {
-		ProcessEdit(walk);
-		walk = walk->next;
-	}
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-void SetupColors_CS(void)
-{
-	color_operator = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_OPERATOR_COLOR));
-
-	color_number = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_NUMERIC_COLOR));
-
-	color_char = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_CHARACTER_COLOR));
-
-	color_string = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_STRING_COLOR));
-
-	color_comment = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_COMMENTS_COLOR));
-
-	color_xml_comment = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_XML_COMMENTS_COLOR));
-
-	color_keyword = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_KEYWORD_COLOR));
-
-	color_preprocessor = (SCR_PTR)(GetConfigInt(CONFIG_INT_BG_COLOR) |
-	GetConfigInt(CONFIG_INT_PREPROCESSOR_COLOR));
-}
-
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-int Colorize_CS_LinePfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
-{
-	file = file;
-	arg = arg;
-
-	if (op&LINE_OP_EDIT)
-		ProcessEdit(line);
-
-	if (op&LINE_OP_INSERT)
-		ProcessInsert(line);
-
-	if (op&LINE_OP_DELETE)
-		ProcessDelete(line);
-
-	return (1);
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void ProcessInsert(EDIT_LINE*line)
-{
-	int flags, prev = 0, next = 0;
-
-	line->flags &= ~LINE_FLAG_MASK;
-
-	flags = GetLineFlags(line);
-
-	if (line->prev)
-		prev = line->prev->flags;
-
-	if (line->next)
-		next = line->next->flags;
-
-	if (!flags && (prev&(LINE_FLAG_MID | LINE_FLAG_HEAD))) {
-		line->flags |= LINE_FLAG_MID;
-		return ;
-	}
-
-	if (!flags && (next&(LINE_FLAG_MID | LINE_FLAG_TAIL))) {
-		line->flags |= LINE_FLAG_MID;
-		return ;
-	}
-
-	if (!flags)
-		return ;
-
-	/* Insert a head */
-	if (flags == LINE_FLAG_HEAD)
-		FindNewTail(line->next);
-
-	/* Insert a tail inside of a comment */
-	if ((flags == LINE_FLAG_TAIL) && (prev&(LINE_FLAG_MID | LINE_FLAG_HEAD)))
-		ClearMidTail(line->next);
-
-	/* Insert a bogus tail */
-	if ((flags == LINE_FLAG_TAIL) && !(prev&(LINE_FLAG_MID | LINE_FLAG_HEAD)))
-		return ;
-
-	line->flags |= flags;
-}
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void ProcessDelete(EDIT_LINE*line)
-{
-	int prev = 0;
-
-	if (line->prev)
-		prev = line->prev->flags;
-
-	if ((line->flags&LINE_FLAG_HEAD) && (line->flags&LINE_FLAG_TAIL))
-		return ;
-
-	if (line->flags&LINE_FLAG_MID)
-		return ;
-
-	if (line->flags&LINE_FLAG_TAIL)
-		FindNewTail(line->next);
-
-	if (line->flags&LINE_FLAG_HEAD) {
-		if (!(prev&(LINE_FLAG_HEAD | LINE_FLAG_MID)))
-			ClearMidTail(line->next);
-	}
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void ProcessEdit(EDIT_LINE*line)
-{
-	int flags, newFlags = 0, prev = 0;
-
-	if (line->prev)
-		prev = line->prev->flags;
-
-	flags = GetLineFlags(line);
-
-	if (!flags && line->flags&LINE_FLAG_MID)
-		return ;
-
-	if (flags == (line->flags&LINE_FLAG_MASK))
-		return ;
-
-	/* Insert a tail inside of a comment */
-	if ((flags == LINE_FLAG_TAIL) && (line->flags&(LINE_FLAG_MID |
-	    LINE_FLAG_HEAD))) {
-		if (!(line->flags&LINE_FLAG_TAIL))
-			ClearMidTail(line->next);
-	}
-
-	/* Add a bogus tail */
-	if ((flags == LINE_FLAG_TAIL) && !(line->flags&LINE_FLAG_MASK))
-		return ;
-
-	/* Add a head to form a dual Tail/Head configuration. */
-	if (flags == (LINE_FLAG_TAIL | LINE_FLAG_HEAD))
-		FindNewTail(line->next);
-
-	/* Add a new standalone head */
-	if ((flags == LINE_FLAG_HEAD) && (!(line->flags&(LINE_FLAG_HEAD |
-	    LINE_FLAG_MID))))
-		FindNewTail(line->next);
-
-	/* Remove the head */
-	if ((line->flags&LINE_FLAG_HEAD) && (!(flags&LINE_FLAG_HEAD))) {
-		/* Remove the head from a dual Tail/Head configuration. */
-		if (line->flags&LINE_FLAG_TAIL)
-			ClearMidTail(line->next);
-		else {
-			if (!(prev&(LINE_FLAG_HEAD | LINE_FLAG_MID)))
-				ClearMidTail(line->next);
-			else
-				newFlags |= LINE_FLAG_MID;
-		}
-	}
-
-	/* Remove the tail */
-	if ((line->flags&LINE_FLAG_TAIL) && (!(flags&LINE_FLAG_TAIL))) {
-		newFlags |= LINE_FLAG_MID;
-		FindNewTail(line->next);
-	}
-
-	/* Clear the bogus tail if any. */
-	if ((flags&LINE_FLAG_TAIL) && (!(prev&(LINE_FLAG_MID | LINE_FLAG_HEAD))))
-		flags &= ~LINE_FLAG_TAIL;
-
-	line->flags &= ~LINE_FLAG_MASK;
-	line->flags |= (flags | newFlags);
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static int GetLineFlags(EDIT_LINE*line)
-{
-	int type, flags = 0, index = 0, head = 0, state = 0;
-
-	for (; ; ) {
-		type = ProcessComments(line, &index, &state);
-
-		if (type == LINE_FLAG_TAIL)
-			flags = LINE_FLAG_TAIL;
-		else
-			break;
-	}
-
-	for (; ; ) {
-		if (type == LINE_FLAG_HEAD) {
-			head++;
-			type = ProcessComments(line, &index, &state);
-
-			if (type == LINE_FLAG_TAIL) {
-				head--;
-				type = ProcessComments(line, &index, &state);
-				continue;
-			}
-			break;
-		} else
-			break;
-	}
-
-	if (head)
-		flags |= LINE_FLAG_HEAD;
-
-	if (type == LINE_FLAG_TAIL)
-		flags |= LINE_FLAG_TAIL;
-
-	return (flags);
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void ClearMidTail(EDIT_LINE*line)
-{
-	while (line) {
-		if (line->flags&LINE_FLAG_MID)
-			line->flags &= ~LINE_FLAG_MASK;
-		else {
-			if (line->flags == LINE_FLAG_HEAD)
-				return ;
-
-			if (line->flags&LINE_FLAG_TAIL)
-				line->flags &= ~LINE_FLAG_TAIL;
-			return ;
-		}
-
-		line = line->next;
-	}
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void FindNewTail(EDIT_LINE*line)
-{
-	int type, index, state = 0;
-
-	while (line) {
-		index = 0;
-
-		type = ProcessComments(line, &index, &state);
-
-		if (type == LINE_FLAG_HEAD) {
-			line->flags |= LINE_FLAG_TAIL;
-			return ;
-		}
-
-		if (type == LINE_FLAG_TAIL) {
-			line->flags |= LINE_FLAG_TAIL;
-			line->flags &= ~LINE_FLAG_MID;
-			return ;
-		}
-
-		line->flags &= ~LINE_FLAG_MASK;
-		line->flags |= LINE_FLAG_MID;
-
-		line = line->next;
-	}
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-void Colorize_CS(EDIT_LINE*line, int pan, int len, SCR_PTR*screen, int address,
-    char defaultAttr)
-{
-	int column, cf = 0, cf2 = 0, length, i, skip = 0;
-	char ch, attr, prev;
-
-	attr = defaultAttr;
-	prev = ED_KEY_SPACE;
-
-	length = pan + len;
-
-	if (line->flags&LINE_FLAG_MID) {
-		attr = color_comment;
-		cf = length;
-	} else
-		if (line->flags&LINE_FLAG_TAIL) {
-			cf2 = BLOCK_TYPE_C_COMMENT;
-			attr = color_comment;
-		}
-
-	/* Write out paned line. */
-	for (column = 0; column < length; column++) {
-		ch = line->line[column];
-
-		if (ch == ED_KEY_TAB || ch == ED_KEY_TABPAD)
-			ch = ED_KEY_SPACE;
-
-		if (cf2 && !skip) {
-			if (blockLUT[cf2 - 1].escape && blockLUT[cf2 - 1].escape == line->
-			    line[column])
-				skip = 2;
-			else {
-				if (column + blockLUT[cf2 - 1].len2 <= length) {
-					if (!strncmp(blockLUT[cf2 - 1].end, &line->line[column],
-					    blockLUT[cf2 - 1].len2)) {
-						cf = blockLUT[cf2 - 1].len2;
-						cf2 = 0;
-					}
-				}
-			}
-		}
-
-		if (!cf && !cf2) {
-			for (i = 0; i < (int)NUMBER_BLOCK_ENTRIES; i++) {
-				if (column + blockLUT[i].len1 <= length) {
-					if (!strncmp(blockLUT[i].start, &line->line[column],
-					    blockLUT[i].len1)) {
-						cf2 = i + 1;
-						attr = *blockLUT[i].color;
-						break;
-					}
-				}
-			}
-
-			if (i == NUMBER_BLOCK_ENTRIES) {
-				if (ch != ED_KEY_SPACE && NotAChar(prev)) {
-
-					if (NOTANUM(prev) && strchr(numberLUT, ch)) {
-						cf = 1;
-						while (column + cf < length && strchr(numberLUT2,
-						    line->line[column + cf]))
-							cf++;
-						attr = color_number;
-					} else {
-						for (i = 0; i < (int)NUMBER_TEXT_ENTRIES; i++) {
-							if (SymbolCheck(i, line, column)) {
-								cf = colorLUT[i].len;
-								attr = *colorLUT[i].color;
-								break;
-							}
-						}
-					}
-				}
-
-				if (!cf) {
-					if (strchr(operatorLUT, ch)) {
-						attr = color_operator;
-						cf = 1;
-					}
-				}
-			}
-		}
-		prev = ch;
-
-		if (column >= pan) {
-			screen[address] = attr;
-			address += 2;
-		}
-
-		if (cf) {
-			if (!--cf)
-				attr = defaultAttr;
-		}
-		if (skip)
-			skip--;
-	}
-}
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static int ProcessComments(EDIT_LINE*line, int*index, int*state)
+LEX_LANGUAGE language_CS =
 {
-	int i, expire = 0, found = 0;
-	int foundIndex[MAX_FIND];
-	int foundState[MAX_FIND];
-
-	for (i = *index; i < line->len; i++) {
-		if (!(*state&LINE_FLAG_HEAD)) {
-			/* Skip over escape character */
-			if (line->line[i] == '\\') {
-				i++;
-				continue;
-			}
-
-			if (!(*state&LINE_FLAG_OPENS) && line->line[i] == '"') {
-				if (*state&LINE_FLAG_OPENQ)
-					*state &= ~LINE_FLAG_OPENQ;
-				else
-					*state |= LINE_FLAG_OPENQ;
-			}
-
-			if (!(*state&LINE_FLAG_OPENQ) && line->line[i] == '\'' && !expire) {
-				if (*state&LINE_FLAG_OPENS)
-					*state &= ~LINE_FLAG_OPENS;
-				else {
-					*state |= LINE_FLAG_OPENS;
-					expire = 2;
-				}
-			}
-		}
-
-		if (i + 2 <= line->len) {
-			if (!strncmp("//", &line->line[i], 2)) {
-				if (!(*state&(LINE_FLAG_OPENS | LINE_FLAG_OPENQ)) && (*state !=
-				    LINE_FLAG_HEAD)) {
-					*index = line->len;
-					return (0);
-				}
-			}
-
-			if (!strncmp("/*", &line->line[i], 2) && !(*state&LINE_FLAG_HEAD)) {
-				if (!(*state&(LINE_FLAG_OPENS | LINE_FLAG_OPENQ))) {
-					*state |= LINE_FLAG_HEAD;
-					*index = i + 2;
-					return (LINE_FLAG_HEAD);
-				}
-			}
-
-			if (!strncmp("*/", &line->line[i], 2)) {
-				if (found < MAX_FIND) {
-					foundIndex[found] = i + 2;
-					foundState[found] = (*state)&(LINE_FLAG_OPENS |
-					    LINE_FLAG_OPENQ);
-					found++;
-				}
-
-				if (!(*state&(LINE_FLAG_OPENS | LINE_FLAG_OPENQ))) {
-					*state &= ~LINE_FLAG_HEAD;
-					*index = i + 2;
-					return (LINE_FLAG_TAIL);
-				}
-			}
-		}
-
-		if (expire) {
-			expire--;
-
-			if (!expire)
-				*state &= ~LINE_FLAG_OPENS;
-		}
-	}
-
-	for (i = 0; i < found; i++) {
-		/* Was this a bogus single/double quote failure? */
-		if (foundState[i] == (*state&(LINE_FLAG_OPENS | LINE_FLAG_OPENQ))) {
-			*state &= ~LINE_FLAG_HEAD;
-			*index = foundIndex[i];
-			return (LINE_FLAG_TAIL);
-		}
-	}
-
-	return (0);
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static int SymbolCheck(int index, EDIT_LINE*line, int column)
-{
-	if (column + colorLUT[index].len > line->len)
-		return (0);
-
-	if (!memcmp(colorLUT[index].text, &line->line[column],
-	    colorLUT[index].len)) {
-		if (column + colorLUT[index].len == line->len)
-			return (1);
-
-		if (NotAChar(line->line[column + colorLUT[index].len]))
-			return (1);
-	}
-	return (0);
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static int NotAChar(char ch)
-{
-	if (ch >= 'a' && ch <= 'z')
-		return (0);
-
-	if (ch >= 'A' && ch <= 'Z')
-		return (0);
-
-	if (ch == '_')
-		return (0);
-
-	return (1);
-}
-
-
+	blocks, sizeof(blocks) / sizeof(LEX_BLOCK),
+	keywords, sizeof(keywords) / sizeof(LEX_KEYWORD),
+	"|&,.><=!()[]{}%^:;~-+*/",
+	"0123456789xX.lLfFabcdefABCDEF",
+	"_",
+	0,
+	0
+};
@@ -31,14 +31,6 @@
 #ifndef __COLOR_CS_H__
 #define __COLOR_CS_H__
 
-void SetupColors_CS(void);
-void ColorLines_CS(EDIT_LINE*lines);
-void Colorize_CS(EDIT_LINE*line, int pan, int len, SCR_PTR*screen, int address,
-    char defaultAttr);
-int Colorize_CS_LinePfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+extern LEX_LANGUAGE language_CS;
 
 #endif /* __COLOR_CS_H__ */
-
-
-
-
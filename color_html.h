@@ -31,14 +31,6 @@
 #ifndef __COLOR_HTML_H__
 #define __COLOR_HTML_H__
 
-void SetupColors_Html(void);
-void ColorLines_Html(EDIT_LINE*lines);
-void Colorize_Html(EDIT_LINE*line, int pan, int len, SCR_PTR*screen,
-    int address, char defaultAttr);
-int Colorize_Html_LinePfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+extern LEX_LANGUAGE language_Html;
 
 #endif /* __COLOR_HTML_H__ */
-
-
-
-
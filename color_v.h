@@ -31,14 +31,6 @@
 #ifndef __COLOR_V_H__
 #define __COLOR_V_H__
 
-void SetupColors_V(void);
-void ColorLines_V(EDIT_LINE*lines);
-void Colorize_V(EDIT_LINE*line, int pan, int len, SCR_PTR*screen, int address,
-    char defaultAttr);
-int Colorize_V_LinePfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+extern LEX_LANGUAGE language_V;
 
 #endif /* __COLOR_V_H__ */
-
-
-
-
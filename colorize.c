@@ -34,6 +34,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include "proedit.h"
+#include "lexer.h"
 #include "color_c.h"
 #include "color_v.h"
 #include "color_cs.h"
@@ -41,58 +42,33 @@
 
 extern int colorizing;
 
-typedef void COLORIZE_SETUP_PFN(void);
-typedef void LINE_COLOR_PFN(EDIT_LINE*line);
-
 typedef struct colorizingFile
 {
 	char*fileExtension;
-	COLORIZE_PFN*pfn;
-	COLORIZE_SETUP_PFN*setup;
-	LINE_PFN*linePfn;
-	LINE_COLOR_PFN*colorize;
+	LEX_LANGUAGE*language;
 }FILE_COLORIZE;
 
 FILE_COLORIZE colorizingSupport[] =
 {
-	{".cs", Colorize_CS, SetupColors_CS, (LINE_PFN*)Colorize_CS_LinePfn,
-	    ColorLines_CS},
-	{".c#", Colorize_CS, SetupColors_CS, (LINE_PFN*)Colorize_CS_LinePfn,
-	    ColorLines_CS},
-	{".c", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".h", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".cpp", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".cc", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".i", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".ic", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".cxx", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".hpp", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".hxx", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".g++", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".c++", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".h++", Colorize_C, SetupColors_C, (LINE_PFN*)Colorize_C_LinePfn,
-	    ColorLines_C},
-	{".v", Colorize_V, SetupColors_V, (LINE_PFN*)Colorize_V_LinePfn,
-	    ColorLines_V},
-	{".htm", Colorize_Html, SetupColors_Html, (LINE_PFN*)Colorize_Html_LinePfn,
-	    ColorLines_Html},
-	{".aspx", Colorize_Html, SetupColors_Html, (LINE_PFN*)Colorize_Html_LinePfn,
-	    ColorLines_Html},
-	{".html", Colorize_Html, SetupColors_Html, (LINE_PFN*)Colorize_Html_LinePfn,
-	    ColorLines_Html},
-	{".css", Colorize_Html, SetupColors_Html, (LINE_PFN*)Colorize_Html_LinePfn,
-	    ColorLines_Html},
+	{".cs", &language_CS},
+	{".c#", &language_CS},
+	{".c", &language_C},
+	{".h", &language_C},
+	{".cpp", &language_C},
+	{".cc", &language_C},
+	{".i", &language_C},
+	{".ic", &language_C},
+	{".cxx", &language_C},
+	{".hpp", &language_C},
+	{".hxx", &language_C},
+	{".g++", &language_C},
+	{".c++", &language_C},
+	{".h++", &language_C},
+	{".v", &language_V},
+	{".htm", &language_Html},
+	{".aspx", &language_Html},
+	{".html", &language_Html},
+	{".css", &language_Html},
 };
 
 #define NUMBER_FILE_COLORIZE (sizeof(colorizingSupport)/sizeof(FILE_COLORIZE))
@@ -108,8 +84,10 @@ void SetupColorizers(void)
 {
 	int i;
 
+	LexSetupColors();
+
 	for (i = 0; i < (int)NUMBER_FILE_COLORIZE; i++)
-		colorizingSupport[i].setup();
+		LexSetup(colorizingSupport[i].language);
 }
 
 
@@ -136,11 +114,11 @@ COLORIZE_PFN*ConfigColorize(EDIT_FILE*file, char*pathname)
 			for (j = 0; j < (int)NUMBER_FILE_COLORIZE; j++)
 				if (!OS_Strcasecmp(&filename[i], colorizingSupport[j].
 				    fileExtension)) {
-					AddLineCallback(file, colorizingSupport[j].linePfn,
-					    LINE_OP_EDIT | LINE_OP_DELETE | LINE_OP_INSERT);
+					AddLineCallback(file, (LINE_PFN*)LexLinePfn, LINE_OP_EDIT |
+					    LINE_OP_DELETE | LINE_OP_INSERT);
 
-					colorizingSupport[j].colorize(file->lines);
-					return (colorizingSupport[j].pfn);
+					LexStart(file, colorizingSupport[j].language);
+					return (LexColorize);
 				}
 		}
 	}
@@ -36,7 +36,7 @@
 #include "proedit.h"
 
 /* Change version anytime the configuration options have changed. */
-#define CONFIG_VERSION 25
+#define CONFIG_VERSION 26
 
 extern int ignoreCase;
 extern int globalSearch;
@@ -49,6 +49,7 @@ extern int nospawn;
 extern int force_crlf;
 extern int hex_endian;
 extern int auto_build_saveall;
+extern int spell_background;
 
 static void ConfigStyleChange(int value);
 static void ColorChange(int value);
@@ -193,6 +194,9 @@ CONFIG_LIST config_lists_def[] =
 	{CONFIG_INT_AUTO_SAVE_BUILD, INDEX_YES,
 	2, yes_no_list, yes_no_values, (CONFIG_PFN*)ListChange}, /* L10 */
 
+	{CONFIG_INT_SPELL_BACKGROUND, INDEX_NO,
+	2, yes_no_list, yes_no_values, (CONFIG_PFN*)ListChange}, /* L11 */
+
 };
 
 
@@ -279,6 +283,9 @@ CONFIG_COLOR config_colors_def[] =
 	{CONFIG_INT_XML_COMMENTS_COLOR, INDEX_FG_COLOR_RED, /* C26 */
 	16, color_list, fg_values, (CONFIG_PFN*)ColorChange},
 
+	{CONFIG_INT_SPELL_BG_COLOR, INDEX_FG_COLOR_RED, /* C27 */
+	16, color_list, bg_values, (CONFIG_PFN*)ColorChange},
+
 };
 
 CONFIG_COLOR config_colors_mono[] =
@@ -364,6 +371,9 @@ CONFIG_COLOR config_colors_mono[] =
 	{CONFIG_INT_XML_COMMENTS_COLOR, INDEX_FG_COLOR_LIGHTGRAY,
 	16, color_list, fg_values, (CONFIG_PFN*)ColorChange},
 
+	{CONFIG_INT_SPELL_BG_COLOR, INDEX_FG_COLOR_DARKGRAY,
+	16, color_list, bg_values, (CONFIG_PFN*)ColorChange},
+
 };
 
 CONFIG_COLOR config_colors_msdev[] =
@@ -449,6 +459,9 @@ CONFIG_COLOR config_colors_msdev[] =
 	{CONFIG_INT_XML_COMMENTS_COLOR, INDEX_FG_COLOR_BRIGHTGREEN,
 	16, color_list, fg_values, (CONFIG_PFN*)ColorChange},
 
+	{CONFIG_INT_SPELL_BG_COLOR, INDEX_FG_COLOR_YELLOW,
+	16, color_list, bg_values, (CONFIG_PFN*)ColorChange},
+
 };
 
 #define NUM_CONFIG_COLORS (sizeof(config_colors_def)/sizeof(CONFIG_COLOR))
@@ -542,6 +555,7 @@ static char*config_list[] = {
 	" Auto Indent Text             : $L4                ",
 	" Auto content Colorizing      : $L5                ",
 	" CR/LF handling               : $L8                ",
+	" Background Spell Checking    : $L11               ",
 	" ",
 	" Color Options:",
 	"",
@@ -558,6 +572,7 @@ static char*config_list[] = {
 	" Dialog Box: Forground Color  : $C20               ",
 	" Dialog Box: Background Color : $C21               ",
 	" Build Error Forground Color  : $C25               ",
+	" Misspelled Word Background   : $C27               ",
 	"",
 	" Auto Content Colorizing Colors:",
 	"",
@@ -1308,6 +1323,7 @@ void SetupConfig(void)
 	force_crlf = GetConfigInt(CONFIG_INT_FORCE_CRLF);
 	hex_endian = GetConfigInt(CONFIG_INT_HEX_ENDIAN);
 	auto_build_saveall = GetConfigInt(CONFIG_INT_AUTO_SAVE_BUILD);
+	spell_background = GetConfigInt(CONFIG_INT_SPELL_BACKGROUND);
 }
 
 
@@ -67,7 +67,6 @@ int CursorLeft(EDIT_FILE*file)
 	if (file->cursor.xpos == 0) {
 		if (file->display.pan) {
 			file->display.pan--;
-			file->cursor.offset--;
 
 			AdjustCursorTab(file, ADJ_CURSOR_LEFT);
 
@@ -78,7 +77,6 @@ int CursorLeft(EDIT_FILE*file)
 	}
 
 	file->cursor.xpos--;
-	file->cursor.offset--;
 
 	AdjustCursorTab(file, ADJ_CURSOR_LEFT);
 
@@ -97,7 +95,6 @@ int CursorRight(EDIT_FILE*file)
 {
 	if (file->cursor.xpos == file->display.columns - 1) {
 		file->display.pan++;
-		file->cursor.offset++;
 
 		AdjustCursorTab(file, ADJ_CURSOR_RIGHT);
 
@@ -106,7 +103,6 @@ int CursorRight(EDIT_FILE*file)
 	}
 
 	file->cursor.xpos++;
-	file->cursor.offset++;
 
 	AdjustCursorTab(file, ADJ_CURSOR_RIGHT);
 
@@ -365,6 +361,11 @@ void SetCursor(EDIT_FILE*file, CURSOR_SAVE*saved)
 	DisplayLine(file, saved->displayLine);
 
 	file->display.pan = saved->pan;
+
+	/* The line may not be the one that was saved, so keep to its columns */
+	if (!file->hexMode)
+		file->cursor.offset = LineOffset(file, file->cursor.line, file->
+		    display.pan + file->cursor.xpos);
 }
 
 
@@ -402,6 +403,10 @@ int CursorLine(EDIT_FILE*file, int line_number)
 /*###########################################################################*/
 void AdjustCursorTab(EDIT_FILE*file, int direction)
 {
+	/* The cursor moves by screen column, so a UTF-8 character is one step */
+	file->cursor.offset = LineOffset(file, file->cursor.line, file->display.
+	    pan + file->cursor.xpos);
+
 	if (file->cursor.offset < file->cursor.line->len) {
 		if (file->cursor.line->line[file->cursor.offset] == ED_KEY_TABPAD) {
 			switch (direction) {
@@ -426,11 +431,20 @@ void AdjustCursorTab(EDIT_FILE*file, int direction)
 /*###########################################################################*/
 void CursorOffset(EDIT_FILE*file, int offset)
 {
-	while (file->cursor.offset < offset)
+	int column;
+
+	/* The line may have changed under the cursor, so go by its columns */
+	column = LineColumn(file, file->cursor.line, offset);
+
+	while (file->display.pan + file->cursor.xpos < column)
 		CursorRight(file);
 
-	while (file->cursor.offset > offset)
-		CursorLeft(file);
+	while (file->display.pan + file->cursor.xpos > column)
+		if (!CursorLeft(file))
+			break;
+
+	file->cursor.offset = LineOffset(file, file->cursor.line, file->display.
+	    pan + file->cursor.xpos);
 }
 
 
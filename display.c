@@ -31,6 +31,7 @@
 #include "osdep.h" /* Platform dependent interface */
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 #include "proedit.h"
 
@@ -39,6 +40,7 @@ extern int force_rows;
 extern int force_cols;
 extern int ignoreCase;
 extern int globalSearch;
+extern int spell_background;
 
 SCR_PTR*screen;
 int screenXDIM;
@@ -49,6 +51,39 @@ int clockEnabled = 0;
 static int paintEnable = 1;
 static int bottomBarEnable = 1;
 
+/* What PaintContent last left on a screen row, so a row whose line has */
+/* not changed is not built again. file is 0 when the row is unknown.   */
+typedef struct paintRow
+{
+	EDIT_FILE*file;
+	EDIT_LINE*line;           /* 0 for a row past the end of the file */
+	struct lexLanguage*language;
+	int number;               /* Line number painted on the row       */
+	int xpos;
+	int columns;
+	int pan;
+	int special;
+	int attr;
+	int mode;
+	int span[2];              /* Selected columns, as from CopySpan   */
+	int flags;
+	int lexState;
+	int len;
+	int textSize;
+	char*text;                /* The line as it was painted           */
+}PAINT_ROW;
+
+static PAINT_ROW*paintRows;
+
+/* The bytes of a UTF-8 line's visible columns, painted before they */
+/* are folded into one cell per character.                           */
+static SCR_PTR*byteCells;
+static int byteCellsSize;
+
+/* Rows changed since the OS layer was last told, and the list for it */
+static char*damage;
+static int*damageList;
+
 unsigned char defaultColorTable[] =
 {COLOR1, COLOR2, COLOR3, COLOR4, COLOR5, COLOR6, COLOR7, COLOR8, COLOR9};
 
@@ -61,10 +96,24 @@ unsigned char defaultColorTableSelect[] =
 static SCR_PTR color_highlight;
 static SCR_PTR color_diff1;
 static SCR_PTR color_diff2;
+static SCR_PTR color_span1;
+static SCR_PTR color_span2;
 static SCR_PTR color_bottom;
 static SCR_PTR color_bookmark;
+static SCR_PTR color_spell;
 
 static void DrawBottomBar(char*text);
+static int PaintMode(EDIT_FILE*file);
+static int RowChanged(EDIT_FILE*file, EDIT_LINE*line, int x, int y, int*span);
+static void KeepRow(EDIT_FILE*file, EDIT_LINE*line, int x, int y, int number,
+    int*span);
+static void ScrollRows(EDIT_FILE*file, int x, int y);
+static void TouchRows(int y1, int y2);
+static void PutCell(int x, int y, int ch, int attr);
+static void PaintGutter(EDIT_FILE*file);
+static void PaintDamage(void);
+static void ProcessBytes(EDIT_FILE*file, EDIT_LINE*line, int pan, int len,
+    SCR_PTR*cells, int address);
 
 static void UpdateClockPfn(void);
 
@@ -124,6 +173,14 @@ int InitDisplay(void)
 
 	screen = OS_Malloc(screenXDIM*screenYDIM*SCR_PTR_SIZE);
 
+	paintRows = (PAINT_ROW*)OS_Malloc(screenYDIM*sizeof(PAINT_ROW));
+	memset(paintRows, 0, screenYDIM*sizeof(PAINT_ROW));
+
+	damage = OS_Malloc(screenYDIM);
+	memset(damage, 0, screenYDIM);
+
+	damageList = (int*)OS_Malloc(screenYDIM*sizeof(int));
+
 	for (x = 0; x < screenXDIM; x++)
 		for (y = 0; y < screenYDIM; y++) {
 			screen[y*screenXDIM*2 + x*2] = ED_KEY_SPACE;
@@ -164,6 +221,7 @@ void RestoreScreen(char*scr)
 {
 	memcpy(screen, scr, screenXDIM*screenYDIM*SCR_PTR_SIZE);
 	OS_Free(scr);
+	TouchRows(0, screenYDIM - 1);
 	if (paintEnable)
 		OS_PaintScreen((char*)screen);
 }
@@ -177,7 +235,19 @@ void RestoreScreen(char*scr)
 /*###########################################################################*/
 void CloseDisplay(void)
 {
+	int y;
+
+	for (y = 0; y < screenYDIM; y++)
+		if (paintRows[y].text)
+			OS_Free(paintRows[y].text);
+
+	OS_Free(paintRows);
+	OS_Free(damage);
+	OS_Free(damageList);
 	OS_Free(screen);
+
+	if (byteCells)
+		OS_Free(byteCells);
 }
 
 
@@ -288,6 +358,8 @@ static void DrawBottomBar(char*text)
 		screen[screenXDIM*2*(screenYDIM - 1) + i*2 + 1] = color_bottom;
 	}
 
+	TouchRows(screenYDIM - 1, screenYDIM - 1);
+
 	if (paintEnable)
 		OS_PaintStatus((char*)screen);
 
@@ -320,7 +392,7 @@ void Paint(EDIT_FILE*file)
 			if (file->file_flags&FILE_FLAG_EDIT_STATUS)
 				OS_PaintStatus((char*)screen);
 			else
-				OS_PaintScreen((char*)screen);
+				PaintDamage();
 		}
 	}
 
@@ -395,9 +467,19 @@ void SetupColors(void)
 	color_diff2 = (SCR_PTR)(GetConfigInt(CONFIG_INT_DIFF2_FG_COLOR) |
 	GetConfigInt(CONFIG_INT_DIFF2_BG_COLOR));
 
+	/* Changed words within a diff line are drawn in reverse */
+	color_span1 = (SCR_PTR)((GetConfigInt(CONFIG_INT_DIFF1_FG_COLOR) << 4) |
+	(GetConfigInt(CONFIG_INT_DIFF1_BG_COLOR) >> 4));
+
+	color_span2 = (SCR_PTR)((GetConfigInt(CONFIG_INT_DIFF2_FG_COLOR) << 4) |
+	(GetConfigInt(CONFIG_INT_DIFF2_BG_COLOR) >> 4));
+
 	color_bookmark = (SCR_PTR)(GetConfigInt(CONFIG_INT_BOOKMARK_FG_COLOR) |
 	GetConfigInt(CONFIG_INT_BOOKMARK_BG_COLOR));
 
+	/* Misspelled words keep their foreground and take this background */
+	color_spell = (SCR_PTR)GetConfigInt(CONFIG_INT_SPELL_BG_COLOR);
+
 	defaultColorTable[0] =
 	(SCR_PTR)(GetConfigInt(CONFIG_INT_FG_COLOR) |
 	GetConfigInt(CONFIG_INT_BG_COLOR));
@@ -427,6 +509,8 @@ void SetupColors(void)
 
 	SetupColorizers();
 
+	InvalidateContent();
+
 }
 
 
@@ -438,7 +522,8 @@ void SetupColors(void)
 /*###########################################################################*/
 void PaintContent(EDIT_FILE*file)
 {
-	int xp, yp, xd, yd, column, pan, line;
+	int xp, yp, xd, yd, column, columns, pan, line, end;
+	int span[2];
 	EDIT_LINE*cur_line;
 	unsigned char attr;
 
@@ -447,6 +532,9 @@ void PaintContent(EDIT_FILE*file)
 		return ;
 	}
 
+	if (spell_background)
+		SpellResults(0);
+
 	if (file->file_flags&FILE_FLAG_NOBORDER) {
 		xp = file->display.xpos;
 		yp = file->display.ypos;
@@ -461,17 +549,38 @@ void PaintContent(EDIT_FILE*file)
 	cur_line = file->display.top_line;
 	pan = file->display.pan;
 
+	if (file->colorize && colorizing)
+		ResolveLexStates(file, file->display.line_number + yd - 1);
+
+	ScrollRows(file, xp, yp);
+
 	for (line = 0; line < yd && cur_line; line++) {
+		if (!CopySpan(file, cur_line, file->display.line_number + line, &span[0],
+		    &span[1]))
+			span[0] = span[1] = 0;
+		else {
+			span[0] = LineColumn(file, cur_line, span[0]);
+
+			if (span[1] != COPY_TO_END)
+				span[1] = LineColumn(file, cur_line, span[1]);
+		}
+
+		if (!RowChanged(file, cur_line, xp, yp + line, span)) {
+			cur_line = cur_line->next;
+			continue;
+		}
+
 		column = 0;
+		columns = LineColumn(file, cur_line, cur_line->len);
 
-		if (pan < cur_line->len) {
-			column = cur_line->len - pan;
+		if (pan < columns) {
+			column = columns - pan;
 
 			if (column > xd)
 				column = xd;
 
-			ProcessContent(file, cur_line, pan, column, line,
-			    (xp + ((yp + line)*screenXDIM))*2);
+			ProcessContent(file, cur_line, pan, column, (xp + ((yp + line)*
+			    screenXDIM))*2);
 		}
 
 		/* PAD rest of the line out in the buffer. */
@@ -490,12 +599,7 @@ void PaintContent(EDIT_FILE*file)
 						else
 							attr = defaultColorTable[file->client];
 
-			if (file->copyStatus&COPY_ON)
-				if (CopyCheck(file, cur_line, pan + column, file->display.
-				    line_number + line))
-					attr = defaultColorTableSelect[file->client];
-
-			if (pan + column == cur_line->len && (file->display_special&
+			if (pan + column == columns && (file->display_special&
 			    ED_SPECIAL_SPACE))
 				screen[((xp + column) + ((yp + line)*screenXDIM))*2] = OS_Frame(
 				    11);
@@ -507,20 +611,326 @@ void PaintContent(EDIT_FILE*file)
 			column++;
 		}
 
+		/* The selection goes on top as one fill of the row */
+		column = MAX(span[0], pan) - pan;
+		end = MIN(span[1], pan + xd) - pan;
+
+		for (; column < end; column++)
+			screen[((xp + column) + ((yp + line)*screenXDIM))*2 + 1] =
+			    defaultColorTableSelect[file->client];
+
+		KeepRow(file, cur_line, xp, yp + line, file->display.line_number + line,
+		    span);
+
 		cur_line = cur_line->next;
 	}
 
 	attr = defaultColorTable[file->client];
+	span[0] = span[1] = 0;
 
 	/* PAD rest of page. */
 	while (line < yd) {
-		/* PAD rest of the line out in the buffer. */
-		for (column = 0; column < xd; column++) {
-			screen[((xp + column) + ((yp + line)*screenXDIM))*2] = ED_KEY_SPACE;
-			screen[((xp + column) + ((yp + line)*screenXDIM))*2 + 1] = attr;
+		if (RowChanged(file, 0, xp, yp + line, span)) {
+			/* PAD rest of the line out in the buffer. */
+			for (column = 0; column < xd; column++) {
+				screen[((xp + column) + ((yp + line)*screenXDIM))*2] =
+				    ED_KEY_SPACE;
+				screen[((xp + column) + ((yp + line)*screenXDIM))*2 + 1] = attr;
+			}
+
+			KeepRow(file, 0, xp, yp + line, file->display.line_number + line,
+			    span);
 		}
 		line++;
 	}
+
+	PaintGutter(file);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Lines that differ from the disk are marked in the left border.          #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void PaintGutter(EDIT_FILE*file)
+{
+	int xp, yp, yd, line;
+	char*marks;
+
+	if (!file->gutter || (file->file_flags&FILE_FLAG_NOBORDER))
+		return ;
+
+	xp = file->display.xpos;
+	yp = file->display.ypos + 1;
+	yd = file->display.rows;
+
+	marks = OS_Malloc(yd + 1);
+
+	ChangeGutter(file, file->display.top_line, file->display.line_number, yd,
+	    marks);
+
+	for (line = 0; line < yd; line++) {
+		switch (marks[line]) {
+		case GUTTER_ADDED :
+			PutCell(xp, yp + line, '+', color_diff1);
+			break;
+
+		case GUTTER_CHANGED :
+			PutCell(xp, yp + line, '~', color_diff1);
+			break;
+
+		case GUTTER_DELETED :
+			PutCell(xp, yp + line, '-', color_diff2);
+			break;
+
+		default :
+			PutCell(xp, yp + line, OS_Frame(5), defaultColorTableBorder[
+			    file->border]);
+			break;
+		}
+	}
+
+	OS_Free(marks);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Forget what every row shows, so the next paint builds them all. For     #*/
+/*# changes a row does not keep track of itself, like the colors.           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void InvalidateContent(void)
+{
+	int y;
+
+	if (!paintRows)
+		return ;
+
+	for (y = 0; y < screenYDIM; y++)
+		paintRows[y].file = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Forget just the rows showing line, as when its spelling marks change.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void InvalidateLine(EDIT_LINE*line)
+{
+	int y;
+
+	if (!paintRows)
+		return ;
+
+	for (y = 0; y < screenYDIM; y++)
+		if (paintRows[y].line == line)
+			paintRows[y].file = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The settings besides the line itself that decide the colors of a row.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int PaintMode(EDIT_FILE*file)
+{
+	return ((file->colorize && colorizing ? 1 : 0) | (spell_background ? 2 : 0));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Nonzero if screen row y has to be built again to show line, or to show  #*/
+/*# the padding past the end of the file when line is 0, with the columns   #*/
+/*# in span selected.                                                       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int RowChanged(EDIT_FILE*file, EDIT_LINE*line, int x, int y, int*span)
+{
+	PAINT_ROW*row = &paintRows[y];
+
+	if (row->file != file || row->line != line || row->xpos != x || row->
+	    columns != file->display.columns || row->pan != file->display.pan ||
+	    row->special != file->display_special || row->attr !=
+	    defaultColorTable[file->client] || row->mode != PaintMode(file) || row->
+	    language != file->language || row->span[0] != span[0] || row->span[1] !=
+	    span[1])
+		return (1);
+
+	if (!line)
+		return (0);
+
+	return (row->flags != line->flags || row->lexState != line->lexState ||
+	    row->len != line->len || (line->len && memcmp(row->text, line->line,
+	    line->len)));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Remember what screen row y was just built from. A row showing a merge   #*/
+/*# highlight depends on more than its own line, so it is left unknown and  #*/
+/*# built on every paint.                                                   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void KeepRow(EDIT_FILE*file, EDIT_LINE*line, int x, int y, int number,
+    int*span)
+{
+	PAINT_ROW*row = &paintRows[y];
+
+	damage[y] = 1;
+
+	row->file = file;
+	row->line = line;
+	row->language = file->language;
+	row->number = number;
+	row->xpos = x;
+	row->columns = file->display.columns;
+	row->pan = file->display.pan;
+	row->special = file->display_special;
+	row->attr = defaultColorTable[file->client];
+	row->mode = PaintMode(file);
+	row->span[0] = span[0];
+	row->span[1] = span[1];
+	row->len = 0;
+
+	if (!line)
+		return ;
+
+	if (row->textSize < line->len) {
+		if (row->text)
+			OS_Free(row->text);
+
+		row->textSize = line->len + 64;
+		row->text = OS_Malloc(row->textSize);
+	}
+
+	memcpy(row->text, line->line, line->len);
+
+	row->len = line->len;
+	row->flags = line->flags;
+	row->lexState = line->lexState;
+
+	if (line->flags&(LINE_FLAG_DIFF1 | LINE_FLAG_DIFF2))
+		row->file = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# If the window has scrolled since it was painted, move the rows that     #*/
+/*# are still in it rather than build them again. The OS layer is told too, #*/
+/*# and if it can move what it shows the moved rows need no painting.       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ScrollRows(EDIT_FILE*file, int x, int y)
+{
+	int i, shift, from, to, rows, columns, moved;
+	PAINT_ROW swap;
+
+	rows = file->display.rows;
+	columns = file->display.columns;
+
+	for (i = 0; i < rows; i++)
+		if (paintRows[y + i].file == file && paintRows[y + i].line &&
+		    paintRows[y + i].xpos == x && paintRows[y + i].columns == columns)
+			break;
+
+	if (i == rows)
+		return ;
+
+	shift = file->display.line_number + i - paintRows[y + i].number;
+
+	if (!shift || abs(shift) >= rows)
+		return ;
+
+	moved = paintEnable && OS_ScrollRows((char*)screen, x, y, columns, rows,
+	    shift);
+
+	/* Work away from the edge the rows are moving towards */
+	for (i = 0; i < rows - abs(shift); i++) {
+		to = shift > 0 ? y + i : y + rows - 1 - i;
+		from = to + shift;
+
+		memcpy(&screen[(x + to*screenXDIM)*2], &screen[(x + from*screenXDIM)*2],
+		    columns*SCR_PTR_SIZE);
+
+		swap = paintRows[to];
+		paintRows[to] = paintRows[from];
+		paintRows[from] = swap;
+		paintRows[from].file = 0;
+
+		/* The cells either side of the block stay behind */
+		damage[to] |= moved ? damage[from] : 1;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Rows written by something other than PaintContent. They no longer       #*/
+/*# show what paintRows says, and the OS layer has to look at them again.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void TouchRows(int y1, int y2)
+{
+	if (!paintRows)
+		return ;
+
+	for (; y1 <= y2; y1++) {
+		paintRows[y1].file = 0;
+		damage[y1] = 1;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Write a cell outside the text of a window, such as the frame or the     #*/
+/*# gutter. The row only counts as changed if the cell did.                 #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void PutCell(int x, int y, int ch, int attr)
+{
+	SCR_PTR*cell = &screen[(x + y*screenXDIM)*2];
+	PAINT_ROW*row = &paintRows[y];
+
+	if (cell[0] == (SCR_PTR)ch && cell[1] == (SCR_PTR)attr)
+		return ;
+
+	cell[0] = (SCR_PTR)ch;
+	cell[1] = (SCR_PTR)attr;
+
+	damage[y] = 1;
+
+	if (x >= row->xpos && x < row->xpos + row->columns)
+		row->file = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Hand the OS layer the rows that changed since it was last called,       #*/
+/*# rather than have it compare the whole screen.                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void PaintDamage(void)
+{
+	int y, numRows = 0;
+
+	for (y = 0; y < screenYDIM; y++) {
+		if (damage[y]) {
+			damageList[numRows++] = y;
+			damage[y] = 0;
+		}
+	}
+
+	if (numRows)
+		OS_PaintRows((char*)screen, damageList, numRows);
 }
 
 
@@ -667,6 +1077,8 @@ void PaintHex(EDIT_FILE*file)
 		}
 	}
 
+	TouchRows(yp, yp + yd - 1);
+
 	if (paintEnable)
 		OS_PaintScreen((char*)screen);
 
@@ -694,7 +1106,54 @@ void EnablePainting(int enable)
 /*#                                                                         #*/
 /*###########################################################################*/
 void ProcessContent(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, int
-    line_number, int address)
+    address)
+{
+	COLUMN_MAP*map;
+	int column, first, size;
+
+	map = FindColumnMap(file, line);
+
+	if (!map) {
+		ProcessBytes(file, line, pan, len, screen, address);
+		return ;
+	}
+
+	first = map->offset[pan];
+	size = map->offset[pan + len] - first;
+
+	if (size*2 > byteCellsSize) {
+		if (byteCells)
+			OS_Free(byteCells);
+
+		byteCellsSize = size*2 + 256;
+		byteCells = (SCR_PTR*)OS_Malloc(byteCellsSize*sizeof(SCR_PTR));
+	}
+
+	ProcessBytes(file, line, first, size, byteCells, 0);
+
+	/* Each character shows in the color of its first byte */
+	for (column = pan; column < pan + len; column++) {
+		size = map->offset[column + 1] - map->offset[column];
+		first = (map->offset[column] - map->offset[pan])*2;
+
+		if (size == 1)
+			screen[address] = byteCells[first];
+		else
+			screen[address] = map->glyphs[column];
+
+		screen[address + 1] = byteCells[first + 1];
+		address += 2;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Paint len bytes of line from pan into cells, one cell per byte.         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ProcessBytes(EDIT_FILE*file, EDIT_LINE*line, int pan, int len,
+    SCR_PTR*cells, int address)
 {
 	int column, length, address2;
 	char ch, attr = 0;
@@ -714,8 +1173,8 @@ void ProcessContent(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, int
 					attr = color_bookmark;
 				else
 					if (file->colorize && colorizing)
-						file->colorize(line, pan, len, screen, address + 1,
-						    defaultColorTable[file->client]);
+						file->colorize(file, line, pan, len, cells, address +
+						    1, defaultColorTable[file->client]);
 					else
 						attr = defaultColorTable[file->client];
 
@@ -723,11 +1182,20 @@ void ProcessContent(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, int
 		address2 = address + 1;
 
 		for (column = pan; column < length; column++) {
-			screen[address2] = attr;
+			cells[address2] = attr;
 			address2 += 2;
 		}
+
+		if (!(line->flags&LINE_FLAG_HIGHLIGHT) && (line->flags&
+		    (LINE_FLAG_DIFF1 | LINE_FLAG_DIFF2)))
+			MergeHighlight(file, line, pan, len, cells, address + 1,
+			    (line->flags&LINE_FLAG_DIFF1) ? color_span1 : color_span2);
 	}
 
+	if (spell_background && !(line->flags&(LINE_FLAG_HIGHLIGHT |
+	    LINE_FLAG_DIFF1 | LINE_FLAG_DIFF2 | LINE_FLAG_BOOKMARK)))
+		SpellHighlight(file, line, pan, len, cells, address + 1, color_spell);
+
 	/* Write out paned line. */
 	for (column = 0; column < length; column++) {
 		ch = line->line[column];
@@ -742,13 +1210,7 @@ void ProcessContent(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, int
 			ch = ED_KEY_SPACE;
 
 		if (column >= pan) {
-			screen[address] = ch;
-
-			if (file->copyStatus&COPY_ON)
-				if (CopyCheck(file, line, column, file->display.line_number +
-				    line_number))
-					screen[address + 1] = defaultColorTableSelect[file->client];
-
+			cells[address] = ch;
 			address += 2;
 		}
 	}
@@ -763,7 +1225,7 @@ void ProcessContent(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, int
 /*###########################################################################*/
 void PaintFrame(EDIT_FILE*file)
 {
-	int i, xp, yp, len, xd, yd;
+	int i, xp, yp, len, xd, yd, start, border;
 	char title[MAX_FILENAME];
 	char*ptr;
 	char*filename;
@@ -804,80 +1266,28 @@ void PaintFrame(EDIT_FILE*file)
 		ptr = title;
 
 	len = strlen(ptr);
+	start = xd / 2 - len / 2 + xp;
+	border = defaultColorTableBorder[file->border];
 
-	for (i = xp + 1; i < (xd / 2 - len / 2 + xp); i++) {
-		screen[(i + (yp*screenXDIM))*2] = OS_Frame(1);
-		screen[(i + (yp*screenXDIM))*2 + 1] = defaultColorTableBorder[file->
-		    border];
-	}
+	for (i = xp + 1; i < start; i++)
+		PutCell(i, yp, OS_Frame(1), border);
 
-	for (i = xd / 2 - len / 2 + xp; i < xd / 2 - len / 2 + xp + len; i++) {
-		screen[(i*2) + (yp*(((screenXDIM - 1) + 1)*2))] = ptr[i - (xd / 2 - len
-		    / 2 + xp)];
-		screen[(i*2) + (yp*(((screenXDIM - 1) + 1)*2)) + 1] =
-		defaultColorTableBorder[file->border];
-	}
+	for (i = start; i < start + len; i++)
+		PutCell(i, yp, ptr[i - start], border);
 
-	for (i = (xd / 2 - len / 2 + xp) + len; i < xp + xd; i++) {
-		screen[(i + (yp*screenXDIM))*2] = OS_Frame(1);
-		screen[(i + (yp*screenXDIM))*2 + 1] = defaultColorTableBorder[file->
-		    border];
-	}
+	for (i = start + len; i < xp + xd; i++)
+		PutCell(i, yp, OS_Frame(1), border);
 
-	for (i = xp + 1; i < xp + xd; i++) {
-		screen[(i + ((yp + yd + 1)*screenXDIM))*2] = OS_Frame(1);
-		screen[(i + ((yp + yd + 1)*screenXDIM))*2 + 1] =
-		defaultColorTableBorder[file->border];
-	}
+	for (i = xp + 1; i < xp + xd; i++)
+		PutCell(i, yp + yd + 1, OS_Frame(1), border);
 
 	for (i = yp + 1; i < yp + yd + 1; i++) {
-		screen[i*(((screenXDIM - 1) + 1)*2) + xp*2] = OS_Frame(5);
-		screen[i*(((screenXDIM - 1) + 1)*2) + xp*2 + 1] =
-		defaultColorTableBorder[file->border];
-
-		if (!file->scrollbar || yd <= 2) {
-			screen[i*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2] = OS_Frame(5);
-			screen[i*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2 + 1] =
-			defaultColorTableBorder[file->border];
-		}
-	}
+		PutCell(xp, i, OS_Frame(5), border);
 
-	if (file->scrollbar) {
-		if (yd > 2) {
-			for (i = yp + 2; i < yp + yd; i++) {
-				screen[i*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2] = OS_Frame(
-				    6);
-				screen[i*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2 + 1] = COLOR4;
-			}
-
-			screen[(yp + 1)*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2] = OS_Frame
-			    (8);
-			screen[(yp + 1)*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2 + 1] =
-			    COLOR4;
-
-			screen[(yp + yd)*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2] =
-			    OS_Frame(9);
-			screen[(yp + yd)*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2 + 1] =
-			    COLOR4;
-		}
+		if (!file->scrollbar || yd <= 2)
+			PutCell(xp + xd, i, OS_Frame(5), border);
 	}
 
-	screen[(xp + (yp*screenXDIM))*2] = OS_Frame(0);
-	screen[(xp + (yp*screenXDIM))*2 + 1] =
-	defaultColorTableBorder[file->border];
-
-	screen[(xp + xd + (yp*screenXDIM))*2] = OS_Frame(2);
-	screen[(xp + xd + (yp*screenXDIM))*2 + 1] =
-	defaultColorTableBorder[file->border];
-
-	screen[(xp + ((yp + yd + 1)*screenXDIM))*2] = OS_Frame(3);
-	screen[(xp + ((yp + yd + 1)*screenXDIM))*2 + 1] =
-	defaultColorTableBorder[file->border];
-
-	screen[(xp + xd + ((yp + yd + 1)*screenXDIM))*2] = OS_Frame(4);
-	screen[(xp + xd + ((yp + yd + 1)*screenXDIM))*2 + 1] =
-	defaultColorTableBorder[file->border];
-
 	if (file->scrollbar) {
 		if (yd > 2) {
 			int len = yd - 2;
@@ -892,12 +1302,23 @@ void PaintFrame(EDIT_FILE*file)
 					offset = len - 1;
 			}
 
-			screen[(yp + offset + 2)*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2] =
-			    OS_Frame(7);
-			screen[(yp + offset + 2)*(((screenXDIM - 1) + 1)*2) + (xd + xp)*2 +
-			    1] = COLOR4;
+			for (i = yp + 2; i < yp + yd; i++)
+				PutCell(xp + xd, i, OS_Frame(i == yp + offset + 2 ? 7 : 6),
+				    COLOR4);
+
+			PutCell(xp + xd, yp + 1, OS_Frame(8), COLOR4);
+			PutCell(xp + xd, yp + yd, OS_Frame(9), COLOR4);
 		}
 	}
+
+	PutCell(xp, yp, OS_Frame(0), border);
+	PutCell(xp + xd, yp, OS_Frame(2), border);
+	PutCell(xp, yp + yd + 1, OS_Frame(3), border);
+	PutCell(xp + xd, yp + yd + 1, OS_Frame(4), border);
+
+	/* The left border was just painted over the change marks */
+	if (!file->hexMode)
+		PaintGutter(file);
 }
 
 
@@ -1024,7 +1445,8 @@ void UpdateStatusBar(EDIT_FILE*file)
 	} else {
 		sprintf(line, "Line:%d/%d", file->cursor.line_number + 1, file->
 		    number_lines);
-		sprintf(col, "Col:%d", file->cursor.offset + 1);
+		sprintf(col, "Col:%d", LineColumn(file, file->cursor.line, file->
+		    cursor.offset) + 1);
 		sprintf(page, "Pg:%d/%d",
 		    (file->cursor.line_number / file->display.rows) + 1, (file->
 		    number_lines / file->display.rows) + 1);
@@ -1053,8 +1475,14 @@ void UpdateStatusBar(EDIT_FILE*file)
 static void UpdateClockPfn(void)
 {
 	char tm[OS_MAX_TIMEDATE];
+	EDIT_FILE*walk;
 	int i, len;
 
+	PollSpellCheck();
+
+	for (walk = NextFile(0); walk; walk = walk->next)
+		LexIdle(walk);
+
 	if (pendingStatus || !clockEnabled)
 		return ;
 
@@ -1062,6 +1490,8 @@ static void UpdateClockPfn(void)
 
 	len = strlen(tm);
 
+	TouchRows(screenYDIM - 1, screenYDIM - 1);
+
 	for (i = 0; i < len; i++) {
 		screen[screenXDIM*2*(screenYDIM - 1) + (i + screenXDIM - len)*2] = tm[i
 		    ];
@@ -95,7 +95,12 @@ void InsertCharacter(EDIT_FILE*file, int ch)
 		else
 			InsertText(file, &byte, 1, CAN_INDENT | CAN_WORDWRAP);
 
-		CursorRight(file);
+		/* A byte of a UTF-8 character typed a byte at a time can join */
+		/* the ones before it, so it doesn't always take a column.     */
+		if ((unsigned char)byte >= 0x80)
+			CursorOffset(file, file->cursor.offset + 1);
+		else
+			CursorRight(file);
 	}
 
 	file->paint_flags |= CONTENT_FLAG;
@@ -408,7 +413,8 @@ void InsertLine(EDIT_FILE*file, char*text, int len, int below, int flags)
 void OverstrikeCharacter(EDIT_FILE*file, char ch, int options)
 {
 	if (file->cursor.offset < file->cursor.line->len)
-		DeleteText(file, 1, 0);
+		DeleteText(file, CharacterLength(file, file->cursor.line, file->cursor.
+		    offset), 0);
 
 	InsertText(file, &ch, 1, options);
 }
@@ -551,7 +557,8 @@ void DeleteCharacter(EDIT_FILE*file, int options)
 	}
 
 	if (file->cursor.offset < file->cursor.line->len) {
-		DeleteText(file, 1, CAN_WORDWRAP);
+		DeleteText(file, CharacterLength(file, file->cursor.line, file->cursor.
+		    offset), CAN_WORDWRAP);
 		return ;
 	}
 
@@ -687,7 +694,7 @@ int WhitespaceLine(EDIT_LINE*line)
 		return (0);
 
 	for (i = 0; i < line->len; i++)
-		if (line->line[i] > ED_KEY_SPACE)
+		if ((unsigned char)line->line[i] > ED_KEY_SPACE)
 			break;
 
 	if (i == line->len)
@@ -709,7 +716,7 @@ int WhitespaceTest(EDIT_FILE*file, int mode)
 	switch (mode) {
 	case WHITESPACE_BEFORE :
 		for (i = 0; i < file->cursor.offset; i++) {
-			if (file->cursor.line->line[i] > ED_KEY_SPACE)
+			if ((unsigned char)file->cursor.line->line[i] > ED_KEY_SPACE)
 				return (0);
 		}
 		return (1);
@@ -728,7 +735,7 @@ int WhitespaceTest(EDIT_FILE*file, int mode)
 /*###########################################################################*/
 void StripLinePadding(EDIT_LINE*line)
 {
-	while (line->len && line->line[line->len - 1] <= ED_KEY_SPACE)
+	while (line->len && (unsigned char)line->line[line->len - 1] <= ED_KEY_SPACE)
 		line->len--;
 }
 
@@ -37,6 +37,7 @@ EDIT_FILE*files;
 
 static int AddFileSorted(char*filename, char*newfile);
 static int SaveFileDisk(EDIT_FILE*file, char*filename);
+static void SetDiskInfo(EDIT_FILE*file, char*filename);
 static void Backupfile(char*pathname);
 static EDIT_FILE*LoadFile(char*filename, int mode);
 static int SaveError(EDIT_FILE*file, char*filename);
@@ -427,6 +428,14 @@ void DeallocFile(EDIT_FILE*file)
 
 	RemoveAllCallbacks(file);
 
+	FreeMergeSpans(file);
+
+	FreeChangeGutter(file);
+
+	FreeSpellSpans(file);
+	FreeColumnMaps(file);
+	FreeLexer(file);
+
 	OS_Free(file);
 }
 
@@ -491,6 +500,8 @@ static EDIT_FILE*LoadFile(char*filename, int mode)
 		}
 
 		OS_Close(fp);
+
+		SetDiskInfo(new_file, filename);
 	}
 
 	AddFile(new_file, ADD_FILE_SORTED);
@@ -1305,10 +1316,37 @@ static int SaveFileDisk(EDIT_FILE*file, char*fname)
 	file->modified = 0;
 	file->force_modified = 0;
 
+	SetDiskInfo(file, pathname);
+
 	return (1);
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SetDiskInfo(EDIT_FILE*file, char*filename)
+{
+	OS_FILE_INFO info;
+
+	/* Remember what is on disk so an unmodified buffer can be matched */
+	/* against the search index without reading it.                    */
+	if (OS_GetFileInfo(filename, &info)) {
+		file->diskSize = info.fileSize;
+		file->diskTime = info.modTime;
+	} else {
+		file->diskSize = 0;
+		file->diskTime = 0;
+	}
+
+	/* The buffer matches the disk, so it is the change gutter's base */
+	ResetChangeGutter(file);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -0,0 +1,53 @@
+#!/bin/sh
+#
+# Runs each key script in tests/ against an empty file. If there is a
+# NAME.out, the file the script saves must match it, and every
+# "# expect TEXT" line in the script must appear in the final screen.
+# A script named NAME.EXT.keys edits NAME.EXT, so the extension picks
+# the colorizer; any other script edits NAME.txt.
+#
+# usage: check.sh path/to/pe_headless
+
+PE=${1:-./pe_headless}
+TESTS=`dirname $0`/tests
+WORK=${TMPDIR:-/tmp}/pe_check.$$
+FAILED=0
+
+mkdir -p $WORK/home
+
+for KEYS in $TESTS/*.keys; do
+	NAME=`basename $KEYS .keys`
+	BAD=0
+
+	case $NAME in
+	*.*)	FILE=$WORK/$NAME ;;
+	*)	FILE=$WORK/$NAME.txt ;;
+	esac
+
+	: > $FILE
+
+	HOME=$WORK/home PROEDIT_KEYS=$KEYS PROEDIT_SCREEN=$WORK/$NAME.screen \
+	    $PE $FILE 2> /dev/null
+
+	if [ -f $TESTS/$NAME.out ] && ! cmp -s $FILE $TESTS/$NAME.out
+	then
+		echo "$NAME: saved text differs"
+		BAD=1
+	fi
+
+	tr -d '\r' < $KEYS | sed -n 's/^# expect //p' | while read EXPECT; do
+		if ! grep -q -F "$EXPECT" $WORK/$NAME.screen; then
+			echo "$NAME: screen lacks \"$EXPECT\""
+			exit 1
+		fi
+	done || BAD=1
+
+	if [ $BAD = 0 ]; then
+		echo "$NAME: ok"
+	else
+		FAILED=1
+	fi
+done
+
+rm -rf $WORK
+exit $FAILED
@@ -0,0 +1,620 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <sys/types.h>
+#include "../osdep.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "../types.h"
+
+/* A display and keyboard for running the editor with no terminal. Rows */
+/* are painted into memory and keys come from a script:                 */
+/*                                                                      */
+/*   # comment                                                          */
+/*   "text typed as is"                                                 */
+/*   down 500             named key, repeated                           */
+/*                                                                      */
+/* PROEDIT_KEYS names the script (default stdin). PROEDIT_BURST=1 says  */
+/* the keys are queued, like a paste. PROEDIT_SCREEN names a file that  */
+/* gets the final screen. Timings go to stderr when the script ends.    */
+
+#define BAR_ULCORNER   '+'
+#define BAR_HORZ       '-'
+#define BAR_URCORNER   '+'
+#define BAR_LLCORNER   '+'
+#define BAR_LRCORNER   '+'
+#define BAR_VIRT       '|'
+#define BAR_SCROLL     '|'
+#define BAR_SCROLL_POS '#'
+#define BAR_DARROW     'v'
+#define BAR_UARROW     '^'
+
+typedef struct scriptKey_t
+{
+	char*name;
+	int key;
+	int mode;
+}SCRIPT_KEY;
+
+void DisplayMessages(void);
+
+static int NextScriptKey(int*mode);
+static int LookupKey(char*name, int*mode);
+static double Microseconds(void);
+static void Report(void);
+static void DumpScreen(char*filename);
+
+static char*original;
+static int screenXD, screenYD;
+static int cursor_x, cursor_y;
+
+static FILE*keyScript;
+static int scriptLine;
+static char lineText[1024];
+static char*typing;
+static int repeatKey, repeatMode, repeatCount;
+static int burst;
+
+/* A key read by OS_InputPending that OS_GetKey has not returned yet */
+static int aheadKey, aheadMode;
+static int ahead;
+
+static long keyCount;
+static double startTime, keyTime, totalTime, maxTime;
+static long paintCount, rowCount, scrollCount, statusCount, bellCount;
+
+static SCRIPT_KEY scriptKeys[] =
+{
+	{"up", ED_KEY_UP, 1},
+	{"down", ED_KEY_DOWN, 1},
+	{"left", ED_KEY_LEFT, 1},
+	{"right", ED_KEY_RIGHT, 1},
+	{"pgup", ED_KEY_PGUP, 1},
+	{"pgdn", ED_KEY_PGDN, 1},
+	{"home", ED_KEY_HOME, 1},
+	{"end", ED_KEY_END, 1},
+	{"insert", ED_KEY_INSERT, 1},
+	{"delete", ED_KEY_DELETE, 1},
+	{"ctrl-up", ED_KEY_CTRL_UP, 1},
+	{"ctrl-down", ED_KEY_CTRL_DOWN, 1},
+	{"ctrl-left", ED_KEY_CTRL_LEFT, 1},
+	{"ctrl-right", ED_KEY_CTRL_RIGHT, 1},
+	{"ctrl-insert", ED_KEY_CTRL_INSERT, 1},
+	{"alt-up", ED_KEY_ALT_UP, 1},
+	{"alt-down", ED_KEY_ALT_DOWN, 1},
+	{"alt-left", ED_KEY_ALT_LEFT, 1},
+	{"alt-right", ED_KEY_ALT_RIGHT, 1},
+	{"alt-insert", ED_KEY_ALT_INSERT, 1},
+	{"alt-tab", ED_ALT_TAB, 1},
+	{"alt-f4", ED_ALT_F4, 1},
+	{"shift-down", ED_KEY_SHIFT_DOWN, 1},
+	{"shift-up", ED_KEY_SHIFT_UP, 1},
+	{"enter", ED_KEY_CR, 0},
+	{"tab", ED_KEY_TAB, 0},
+	{"backspace", ED_KEY_BS, 0},
+	{"esc", ED_KEY_ESC, 0},
+	{"space", ED_KEY_SPACE, 0},
+	{0, 0, 0}
+};
+
+static int altKeys[26] =
+{
+	ED_ALT_A, ED_ALT_B, ED_ALT_C, ED_ALT_D, ED_ALT_E, ED_ALT_F, ED_ALT_G,
+	ED_ALT_H, ED_ALT_I, ED_ALT_J, ED_ALT_K, ED_ALT_L, ED_ALT_M, ED_ALT_N,
+	ED_ALT_O, ED_ALT_P, ED_ALT_Q, ED_ALT_R, ED_ALT_S, ED_ALT_T, ED_ALT_U,
+	ED_ALT_V, ED_ALT_W, ED_ALT_X, ED_ALT_Y, ED_ALT_Z
+};
+
+static int functionKeys[12] =
+{
+	ED_F1, ED_F2, ED_F3, ED_F4, ED_F5, ED_F6, ED_F7, ED_F8, ED_F9, ED_F10,
+	ED_F11, ED_F12
+};
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_InitScreen(int xd, int yd)
+{
+	char*filename;
+
+	screenXD = xd;
+	screenYD = yd;
+
+	filename = getenv("PROEDIT_KEYS");
+
+	if (filename) {
+		keyScript = fopen(filename, "r");
+
+		if (!keyScript) {
+			fprintf(stderr, "Unable to open key script %s\n", filename);
+			return (0);
+		}
+	} else
+		keyScript = stdin;
+
+	burst = getenv("PROEDIT_BURST") != 0;
+
+	startTime = Microseconds();
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_ScreenSize(int*xd, int*yd)
+{
+	*xd = screenXD;
+	*yd = screenYD;
+
+	original = OS_Malloc(screenXD*screenYD*SCR_PTR_SIZE);
+	memset(original, 0, screenXD*screenYD*SCR_PTR_SIZE);
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_SetWindowTitle(char*pathname)
+{
+	pathname = pathname;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_SetTextPosition(int x_position, int y_position)
+{
+	cursor_x = x_position;
+	cursor_y = y_position;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_SetCursorType(int overstrike, int visible)
+{
+	overstrike = overstrike;
+	visible = visible;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PaintScreen(char*buffer)
+{
+	int y, row = screenXD*SCR_PTR_SIZE;
+
+	paintCount++;
+
+	for (y = 0; y < screenYD; y++) {
+		if (memcmp(&original[y*row], &buffer[y*row], row)) {
+			memcpy(&original[y*row], &buffer[y*row], row);
+			rowCount++;
+		}
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Copy just the rows the editor says have changed.                        #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PaintRows(char*buffer, int*rows, int numRows)
+{
+	int i, row = screenXD*SCR_PTR_SIZE;
+
+	for (i = 0; i < numRows; i++)
+		memcpy(&original[rows[i]*row], &buffer[rows[i]*row], row);
+
+	rowCount += numRows;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Move the block like a terminal would, so the editor's scroll path       #*/
+/*# is timed too.                                                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_ScrollRows(char*buffer, int x, int y, int columns, int rows, int shift)
+{
+	int i, from, to;
+
+	buffer = buffer;
+
+	for (i = 0; i < rows - abs(shift); i++) {
+		to = shift > 0 ? y + i : y + rows - 1 - i;
+		from = to + shift;
+
+		memcpy(&original[(x + to*screenXD)*SCR_PTR_SIZE],
+		    &original[(x + from*screenXD)*SCR_PTR_SIZE],
+		    columns*SCR_PTR_SIZE);
+	}
+
+	scrollCount++;
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PaintStatus(char*buffer)
+{
+	int row = screenXD*SCR_PTR_SIZE;
+
+	memcpy(&original[(screenYD - 1)*row], &buffer[(screenYD - 1)*row], row);
+
+	statusCount++;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_Exit(void)
+{
+	char*filename;
+
+	if (original) {
+		filename = getenv("PROEDIT_SCREEN");
+
+		if (filename)
+			DumpScreen(filename);
+
+		Report();
+
+		OS_Free(original);
+	}
+
+	DisplayMessages();
+
+	exit(0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_Bell(void)
+{
+	bellCount++;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_Getch(void)
+{
+	return (getchar());
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The time from a key coming back to the next call here is what the       #*/
+/*# editor spent on it, painting included.                                  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_GetKey(int*mode, OS_MOUSE*mouse)
+{
+	double now;
+	int ch;
+
+	now = Microseconds();
+
+	if (keyCount) {
+		totalTime += now - keyTime;
+
+		if (now - keyTime > maxTime)
+			maxTime = now - keyTime;
+	}
+
+	mouse->buttonStatus = 0;
+	mouse->moveStatus = 0;
+
+	if (ahead) {
+		ahead = 0;
+		*mode = aheadMode;
+		ch = aheadKey;
+	} else
+		ch = NextScriptKey(mode);
+
+	if (!ch)
+		OS_Exit();
+
+	keyCount++;
+
+	keyTime = Microseconds();
+
+	return (ch);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Script keys are only read by OS_GetKey, never looked at early.          #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_PeekKey(int*mode, OS_MOUSE*mouse)
+{
+	mode = mode;
+	mouse = mouse;
+
+	return (0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Keys typed at a normal pace are painted one at a time. In a burst       #*/
+/*# the whole script counts as queued, like a paste.                        #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_InputPending(void)
+{
+	if (burst && !ahead)
+		ahead = (aheadKey = NextScriptKey(&aheadMode)) != 0;
+
+	return (ahead);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+char OS_Frame(int index)
+{
+	static unsigned char titles[] =
+	{BAR_ULCORNER, BAR_HORZ, BAR_URCORNER, BAR_LLCORNER, BAR_LRCORNER, BAR_VIRT,
+		BAR_SCROLL, BAR_SCROLL_POS, BAR_DARROW, BAR_UARROW, 0, 0, 0, 0
+	};
+
+	return ((char)titles[index]);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Next key from the script, or 0 at the end of it.                        #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int NextScriptKey(int*mode)
+{
+	char name[64];
+	char*ptr;
+	int count, key;
+
+	for (; ; ) {
+		if (typing && *typing && *typing != '"' && *typing != '\n') {
+			*mode = 0;
+			return ((unsigned char)*typing++);
+		}
+
+		typing = 0;
+
+		if (repeatCount) {
+			repeatCount--;
+			*mode = repeatMode;
+			return (repeatKey);
+		}
+
+		if (!fgets(lineText, sizeof(lineText), keyScript))
+			return (0);
+
+		scriptLine++;
+
+		for (ptr = lineText; *ptr == ' ' || *ptr == '\t'; ptr++)
+			;
+
+		if (*ptr == '"') {
+			typing = ptr + 1;
+			continue;
+		}
+
+		count = 1;
+
+		if (sscanf(ptr, "%63s %d", name, &count) < 1 || name[0] == '#')
+			continue;
+
+		key = LookupKey(name, &repeatMode);
+
+		if (!key) {
+			fprintf(stderr, "Key script line %d: unknown key %s\n",
+			    scriptLine, name);
+			continue;
+		}
+
+		repeatKey = key;
+		repeatCount = count > 0 ? count : 0;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# ctrl-a to ctrl-z, alt-a to alt-z, f1 to f12 and the names in            #*/
+/*# scriptKeys.                                                             #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int LookupKey(char*name, int*mode)
+{
+	int i;
+
+	*mode = 1;
+
+	if (!strncmp(name, "ctrl-", 5) && name[5] >= 'a' && name[5] <= 'z' &&
+	    !name[6])
+		return (ED_CTRL_A + name[5] - 'a');
+
+	if (!strncmp(name, "alt-", 4) && name[4] >= 'a' && name[4] <= 'z' &&
+	    !name[5])
+		return (altKeys[name[4] - 'a']);
+
+	if (name[0] == 'f' && sscanf(name + 1, "%d", &i) == 1 && i >= 1 &&
+	    i <= 12)
+		return (functionKeys[i - 1]);
+
+	for (i = 0; scriptKeys[i].name; i++) {
+		if (!strcmp(name, scriptKeys[i].name)) {
+			*mode = scriptKeys[i].mode;
+			return (scriptKeys[i].key);
+		}
+	}
+
+	return (0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static double Microseconds(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+
+	return ((double)tv.tv_sec*1000000.0 + (double)tv.tv_usec);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void Report(void)
+{
+	fprintf(stderr, "keys %ld, %.3f s\n", keyCount,
+	    (Microseconds() - startTime) / 1000000.0);
+
+	if (keyCount > 1)
+		fprintf(stderr, "per key %.1f us mean, %.1f us max\n", totalTime /
+		    (double)(keyCount - 1), maxTime);
+
+	fprintf(stderr, "paints %ld, rows %ld, scrolls %ld, status %ld, bells "
+	    "%ld\n", paintCount, rowCount, scrollCount, statusCount, bellCount);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The screen as text, one row per line, then the cursor position, then    #*/
+/*# the rows again with a '|' wherever the attribute changes.               #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void DumpScreen(char*filename)
+{
+	FILE*fp;
+	int x, y;
+	unsigned char ch;
+	char*cell;
+
+	fp = fopen(filename, "w");
+
+	if (!fp)
+		return;
+
+	for (y = 0; y < screenYD; y++) {
+		for (x = 0; x < screenXD; x++) {
+			ch = (unsigned char)original[(x + y*screenXD)*SCR_PTR_SIZE];
+			fputc(ch >= 32 && ch < 127 ? ch : ' ', fp);
+		}
+		fputc('\n', fp);
+	}
+
+	fprintf(fp, "cursor %d,%d\n", cursor_x, cursor_y);
+
+	for (y = 0; y < screenYD; y++) {
+		for (x = 0; x < screenXD; x++) {
+			cell = &original[(x + y*screenXD)*SCR_PTR_SIZE];
+
+			if (x && cell[1] != cell[1 - SCR_PTR_SIZE])
+				fputc('|', fp);
+
+			ch = (unsigned char)cell[0];
+			fputc(ch >= 32 && ch < 127 ? ch : ' ', fp);
+		}
+		fputc('\n', fp);
+	}
+
+	fclose(fp);
+}
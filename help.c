@@ -83,7 +83,8 @@ char*helpText[] = {
 	"BALT-A:  Save current file with a new name.",
 	"TALT-P:  Place/Remove a bookmark at current line/column.",
 	"TALT-J:  Jump to the next bookmark.",
-	"TALT-Y:  Merge Text File(s).",
+	"TALT-Y:  Merge Text File(s), or compare Hex Mode File(s).",
+	"TSHIFT-ALT-Y: Compare two directories and merge the files that differ.",
 	"BALT-Z:  Run a Build/Command Shell (See Also: ALT-B)",
 	"BALT-B:  Re-Build (Saves Modified files, and re-runs last Build/Command)",
 	"TALT-O:  Perform Special Operation on file or Selected text.",
@@ -164,7 +164,7 @@ static int GetLineIndent(EDIT_LINE*line)
 	int indent = 0;
 
 	for (indent = 0; indent < line->len; indent++)
-		if (line->line[indent] > ED_KEY_SPACE)
+		if ((unsigned char)line->line[indent] > ED_KEY_SPACE)
 			break;
 
 	/* Ignore lines with just whitespace. */
@@ -187,7 +187,7 @@ static EDIT_LINE*GetLastLineIndent(EDIT_LINE*line)
 
 	while (line) {
 		for (indent = 0; indent < line->len; indent++)
-			if (line->line[indent] > ED_KEY_SPACE)
+			if ((unsigned char)line->line[indent] > ED_KEY_SPACE)
 				break;
 
 		if (indent != line->len)
@@ -48,8 +48,13 @@ EDIT_FILE*ProcessUserInput(EDIT_FILE*file, USER_INPUT_PFN*pfn)
 	int mode;
 	int ch;
 
+	if (!pfn)
+		SpellIdle(file);
+
 	ch = OS_Key(&mode, &file->mouse);
 
+	SpellIdle(0);
+
 	if (ch != ED_KEY_HOME)
 		file->home_count = 0;
 
@@ -188,7 +193,10 @@ EDIT_FILE*ProcessSpecial(EDIT_FILE*file, int ch)
 
 	case ED_ALT_Y :
 		CancelSelectBlock(file);
-		file = Merge(file);
+		if (file->shift)
+			file = MergeTrees(file);
+		else
+			file = Merge(file);
 		break;
 
 	case ED_ALT_S :
@@ -0,0 +1,927 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include "osdep.h" /* Platform dependent interface */
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "proedit.h"
+#include "lexer.h"
+
+/* A line's attributes as runs of one color, so a repaint is a copy */
+typedef struct lexRun
+{
+	int end;       /* Column after the last one in the run */
+	SCR_PTR attr;
+}LEX_RUN;
+
+typedef struct lexRuns
+{
+	EDIT_LINE*line;
+	char*text;       /* line->line and len the runs were built from, */
+	int len;         /* len is -1 once the line has been edited     */
+	int state;       /* line->lexState */
+	int generation;  /* lexGeneration */
+	SCR_PTR attr;    /* Default attribute */
+	int numRuns;
+	LEX_RUN*runs;
+}LEX_RUNS;
+
+/* Lines before frontier have the right start state. Any line from     */
+/* frontier to dirtyEnd may not; the lines after dirtyEnd agree with the */
+/* line before them, so a pass can stop at the first one that already   */
+/* has its state. Line numbers match cursor.line_number.                */
+typedef struct lexFile
+{
+	LINE_CACHE*runs;
+	int frontier;             /* -1 when every line is resolved     */
+	int dirtyEnd;
+	EDIT_LINE*frontierLine;   /* The frontier line, or 0 if unknown */
+}LEX_FILE;
+
+static SCR_PTR lexColors[LEX_NUM_COLORS];
+
+/* Bumped when the colors change, which stales every cached run */
+static int lexGeneration;
+
+static SCR_PTR*lexScratch;
+static int lexScratchSize;
+
+static int LexScan(LEX_LANGUAGE*language, EDIT_LINE*line, int state, int pan,
+    int length, SCR_PTR*screen, int address, SCR_PTR defaultAttr);
+static void LexDirty(LEX_FILE*lexer, int number);
+static void LexShift(LEX_FILE*lexer, int number, int delta);
+static EDIT_LINE*FindLine(EDIT_FILE*file, int number);
+static int LexEndState(LEX_LANGUAGE*language, EDIT_LINE*line);
+static int LexKeyword(LEX_LANGUAGE*language, EDIT_LINE*line, int column);
+static void LexClasses(LEX_LANGUAGE*language);
+static void LexHashKeywords(LEX_LANGUAGE*language);
+static int PlaceBucket(LEX_LANGUAGE*language, int*bucket, int count, unsigned
+    int seed);
+static unsigned int KeywordHash(LEX_LANGUAGE*language, char*text, int len,
+    unsigned int seed);
+static int KeywordMatch(LEX_LANGUAGE*language, char*keyword, char*text, int
+    len);
+static void BuildLexRuns(LEX_LANGUAGE*language, LEX_RUNS*entry, EDIT_LINE*line,
+    SCR_PTR defaultAttr);
+static void FreeLexRuns(LEX_RUNS*entry);
+
+#define CLASS(language, ch) ((language)->tables->classes[(unsigned char)(ch)])
+
+/* Give up on a bucket after this many seeds and grow the table instead */
+#define MAX_KEYWORD_SEEDS 4096
+
+/* Lines resolved past the frontier on each idle tick */
+#define LEX_IDLE_LINES 65536
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void LexSetupColors(void)
+{
+	int bg = GetConfigInt(CONFIG_INT_BG_COLOR);
+
+	lexGeneration++;
+
+	lexColors[LEX_COLOR_DEFAULT] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_FG_COLOR));
+
+	lexColors[LEX_COLOR_OPERATOR] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_OPERATOR_COLOR));
+
+	lexColors[LEX_COLOR_NUMBER] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_NUMERIC_COLOR));
+
+	lexColors[LEX_COLOR_CHAR] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_CHARACTER_COLOR));
+
+	lexColors[LEX_COLOR_STRING] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_STRING_COLOR));
+
+	lexColors[LEX_COLOR_COMMENT] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_COMMENTS_COLOR));
+
+	lexColors[LEX_COLOR_KEYWORD] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_KEYWORD_COLOR));
+
+	lexColors[LEX_COLOR_PREPROCESSOR] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_PREPROCESSOR_COLOR));
+
+	lexColors[LEX_COLOR_XML_COMMENT] = (SCR_PTR)(bg | GetConfigInt
+	    (CONFIG_INT_XML_COMMENTS_COLOR));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void LexSetup(LEX_LANGUAGE*language)
+{
+	/* Several extensions share a language */
+	if (language->tables)
+		return;
+
+	language->tables = (LEX_TABLES*)OS_Malloc(sizeof(LEX_TABLES));
+
+	LexClasses(language);
+	LexHashKeywords(language);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Start colorizing file. No line is lexed here; the lines on screen are   #*/
+/*# resolved as they are painted and the rest when the editor is idle.      #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void LexStart(EDIT_FILE*file, LEX_LANGUAGE*language)
+{
+	if (!file->lexer) {
+		file->lexer = (LEX_FILE*)OS_Malloc(sizeof(LEX_FILE));
+		memset(file->lexer, 0, sizeof(LEX_FILE));
+		file->lexer->runs = CreateLineCache(sizeof(LEX_RUNS),
+		    (LINE_CACHE_PFN*)FreeLexRuns);
+	}
+
+	file->language = language;
+	file->lexer->frontier = 0;
+	file->lexer->dirtyEnd = file->number_lines;
+	file->lexer->frontierLine = file->lines;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# A changed line can only change the start state of the lines after it.   #*/
+/*# Rather than walk the rest of the file for one opened comment, move the  #*/
+/*# frontier back to cover them. The line is found from the cursor, since   #*/
+/*# every line operation happens at or next to it; anything else relexes    #*/
+/*# the file.                                                               #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int LexLinePfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
+{
+	LEX_FILE*lexer = file->lexer;
+	LEX_RUNS*entry;
+	int number = -1;
+
+	arg = arg;
+
+	if (!lexer)
+		return (0);
+
+	entry = (LEX_RUNS*)FindLineEntry(lexer->runs, line);
+
+	if (entry)
+		entry->len = -1;
+
+	if (line == file->cursor.line)
+		number = file->cursor.line_number;
+	else
+		if ((op&LINE_OP_INSERT) && line->prev == file->cursor.line)
+			number = file->cursor.line_number + 1;
+
+	if (number < 0) {
+		LexStart(file, file->language);
+		return (1);
+	}
+
+	if (op&(LINE_OP_INSERT | LINE_OP_DELETE))
+		lexer->frontierLine = 0;
+
+	if (op&LINE_OP_INSERT) {
+		LexShift(lexer, number, 1);
+		LexDirty(lexer, number);
+		LexDirty(lexer, number + 1);
+	}
+
+	if (op&LINE_OP_EDIT)
+		LexDirty(lexer, number + 1);
+
+	/* Called before the line is unlinked; the next line takes its number */
+	if (op&LINE_OP_DELETE) {
+		LexShift(lexer, number, -1);
+		LexDirty(lexer, number);
+	}
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Bring the start state of every line up to and including line number     #*/
+/*# last up to date. The painter calls this for the bottom line on screen.  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void ResolveLexStates(EDIT_FILE*file, int last)
+{
+	LEX_FILE*lexer = file->lexer;
+	EDIT_LINE*line;
+	int number, state;
+
+	if (!lexer || lexer->frontier < 0 || lexer->frontier > last)
+		return ;
+
+	number = lexer->frontier;
+
+	line = lexer->frontierLine ? lexer->frontierLine : FindLine(file, number);
+
+	if (!line) {
+		lexer->frontier = -1;
+		return ;
+	}
+
+	state = line->prev ? LexEndState(file->language, line->prev) : 0;
+
+	for (;;) {
+		if (state == line->lexState && number > lexer->dirtyEnd)
+			break;
+
+		line->lexState = state;
+		state = LexEndState(file->language, line);
+
+		line = line->next;
+		number++;
+
+		if (!line)
+			break;
+
+		if (number > last) {
+			lexer->frontier = number;
+			lexer->frontierLine = line;
+			return ;
+		}
+	}
+
+	lexer->frontier = -1;
+	lexer->frontierLine = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Called on the clock tick while waiting for a key. Pushes the frontier   #*/
+/*# a bounded number of lines further down, so a large file finishes        #*/
+/*# resolving in the background without holding up the keyboard.            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void LexIdle(EDIT_FILE*file)
+{
+	if (file->lexer && file->lexer->frontier >= 0)
+		ResolveLexStates(file, file->lexer->frontier + LEX_IDLE_LINES);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void LexColorize(void*file, EDIT_LINE*line, int pan, int len, SCR_PTR*screen,
+    int address, char defaultAttr)
+{
+	EDIT_FILE*editFile = (EDIT_FILE*)file;
+	LEX_RUNS*entry;
+	LEX_RUN*run;
+	int column, low, high, mid;
+
+	entry = (LEX_RUNS*)FindLineEntry(editFile->lexer->runs, line);
+
+	if (!entry) {
+		entry = (LEX_RUNS*)AddLineEntry(editFile->lexer->runs, line);
+		entry->len = -1;
+	}
+
+	if (entry->text != line->line || entry->len != line->len || entry->state !=
+	    line->lexState || entry->generation != lexGeneration || entry->attr !=
+	    defaultAttr)
+		BuildLexRuns(editFile->language, entry, line, defaultAttr);
+
+	/* Find the run holding the first visible column */
+	for (low = 0, high = entry->numRuns - 1; low < high; ) {
+		mid = (low + high) / 2;
+
+		if (entry->runs[mid].end <= pan)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	run = &entry->runs[low];
+
+	for (column = pan; column < pan + len; column++) {
+		if (column == run->end)
+			run++;
+
+		screen[address] = run->attr;
+		address += 2;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeLexer(EDIT_FILE*file)
+{
+	if (!file->lexer)
+		return ;
+
+	FreeLineCache(file->lexer->runs);
+	OS_Free(file->lexer);
+	file->lexer = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Lex the whole line once and keep the result as runs of one attribute.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void BuildLexRuns(LEX_LANGUAGE*language, LEX_RUNS*entry, EDIT_LINE*line,
+    SCR_PTR defaultAttr)
+{
+	int i, count;
+
+	if (line->len*2 > lexScratchSize) {
+		if (lexScratch)
+			OS_Free(lexScratch);
+
+		lexScratchSize = line->len*2 + 256;
+		lexScratch = (SCR_PTR*)OS_Malloc(lexScratchSize*sizeof(SCR_PTR));
+	}
+
+	LexScan(language, line, line->lexState, 0, line->len, lexScratch, 0,
+	    defaultAttr);
+
+	for (count = 0, i = 0; i < line->len; i++)
+		if (!i || lexScratch[i*2] != lexScratch[i*2 - 2])
+			count++;
+
+	if (entry->runs)
+		OS_Free(entry->runs);
+
+	entry->runs = (LEX_RUN*)OS_Malloc((count + 1)*sizeof(LEX_RUN));
+
+	for (count = 0, i = 0; i < line->len; i++) {
+		if (!i || lexScratch[i*2] != lexScratch[i*2 - 2])
+			entry->runs[count++].attr = lexScratch[i*2];
+
+		entry->runs[count - 1].end = i + 1;
+	}
+
+	/* An empty line still gets one run */
+	if (!count) {
+		entry->runs[0].attr = defaultAttr;
+		entry->runs[0].end = 0;
+		count = 1;
+	}
+
+	entry->numRuns = count;
+	entry->text = line->line;
+	entry->len = line->len;
+	entry->state = line->lexState;
+	entry->generation = lexGeneration;
+	entry->attr = defaultAttr;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeLexRuns(LEX_RUNS*entry)
+{
+	if (entry->runs)
+		OS_Free(entry->runs);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void LexDirty(LEX_FILE*lexer, int number)
+{
+	if (lexer->frontier < 0 || number < lexer->frontier) {
+		if (lexer->frontier < 0)
+			lexer->dirtyEnd = number;
+
+		lexer->frontier = number;
+		lexer->frontierLine = 0;
+	}
+
+	if (number > lexer->dirtyEnd)
+		lexer->dirtyEnd = number;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Keep the frontier on the same lines when one is inserted or deleted     #*/
+/*# above it.                                                               #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void LexShift(LEX_FILE*lexer, int number, int delta)
+{
+	if (lexer->frontier < 0)
+		return ;
+
+	if (lexer->frontier > number || (delta > 0 && lexer->frontier == number))
+		lexer->frontier += delta;
+
+	if (lexer->dirtyEnd > number || (delta > 0 && lexer->dirtyEnd == number))
+		lexer->dirtyEnd += delta;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Walk to line number from whichever of the top of the file, the top      #*/
+/*# of the screen or the cursor is closest.                                 #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_LINE*FindLine(EDIT_FILE*file, int number)
+{
+	EDIT_LINE*line = file->lines;
+	int at = 0;
+
+	if (abs(file->display.line_number - number) < number - at) {
+		line = file->display.top_line;
+		at = file->display.line_number;
+	}
+
+	if (abs(file->cursor.line_number - number) < abs(at - number)) {
+		line = file->cursor.line;
+		at = file->cursor.line_number;
+	}
+
+	while (line && at < number) {
+		line = line->next;
+		at++;
+	}
+
+	while (line && at > number) {
+		line = line->prev;
+		at--;
+	}
+
+	return (line);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int LexEndState(LEX_LANGUAGE*language, EDIT_LINE*line)
+{
+	return (LexScan(language, line, line->lexState, 0, line->len, 0, 0, 0));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The one state machine behind every language. Scans the first length     #*/
+/*# columns of line starting in state, painting the columns from pan on     #*/
+/*# when screen is set, and returns the state the next line starts in.      #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int LexScan(LEX_LANGUAGE*language, EDIT_LINE*line, int state, int pan,
+    int length, SCR_PTR*screen, int address, SCR_PTR defaultAttr)
+{
+	LEX_BLOCK*block = 0;
+	int column, run = 0, skip = 0, tags = 0, i;
+	int type, prevType = 0;
+	char ch;
+	SCR_PTR attr = defaultAttr;
+
+	if (state > 0 && state <= language->numBlocks) {
+		block = &language->blocks[state - 1];
+		attr = lexColors[block->color];
+	}
+
+	for (column = 0; column < length; column++) {
+		ch = line->line[column];
+
+		if (ch == ED_KEY_TAB || ch == ED_KEY_TABPAD)
+			ch = ED_KEY_SPACE;
+
+		type = CLASS(language, ch);
+
+		if ((language->flags&LEX_FLAG_TAGS) && ch == '<')
+			tags++;
+
+		/* Look for the end of the open block */
+		if (block && !skip) {
+			if (block->escape && block->escape == ch)
+				skip = 2;
+			else
+				if (block->end && block->end[0] == ch && column + block->endLen
+				    <= line->len && !strncmp(block->end, &line->line[column],
+				    block->endLen)) {
+					run = block->endLen;
+					block = 0;
+				}
+		}
+
+		if (!run && !block && (tags || !(language->flags&LEX_FLAG_TAGS))) {
+			if (type&LEX_CLASS_BLOCK) {
+				for (i = 0; i < language->numBlocks; i++) {
+					if (column + language->blocks[i].startLen <= line->len &&
+					    !strncmp(language->blocks[i].start, &line->line[column],
+					    language->blocks[i].startLen)) {
+						block = &language->blocks[i];
+						attr = lexColors[block->color];
+						break;
+					}
+				}
+			}
+
+			if (!block) {
+				/* Digits carry an identifier on, so a keyword or number */
+				/* can't start after one either.                        */
+				if (ch != ED_KEY_SPACE && !(prevType&(LEX_CLASS_WORD |
+				    LEX_CLASS_IDENT))) {
+					if ((type&LEX_CLASS_DIGIT) && !(prevType&LEX_CLASS_DIGIT)) {
+						run = 1;
+						while (column + run < line->len && (CLASS(language,
+						    line->line[column + run])&LEX_CLASS_NUMBER))
+							run++;
+						attr = lexColors[LEX_COLOR_NUMBER];
+					} else
+						if (type&LEX_CLASS_KEYWORD) {
+							i = LexKeyword(language, line, column);
+
+							if (i >= 0) {
+								run = language->keywords[i].len;
+								attr = lexColors[language->keywords[i].color];
+							}
+						}
+				}
+
+				if (!run && (type&LEX_CLASS_OPERATOR)) {
+					attr = lexColors[LEX_COLOR_OPERATOR];
+					run = 1;
+				}
+			}
+		}
+		prevType = type;
+
+		if ((language->flags&LEX_FLAG_TAGS) && ch == '>' && tags)
+			tags--;
+
+		if (screen && column >= pan) {
+			if ((language->flags&LEX_FLAG_TAGS) && !tags && !run && !block)
+				screen[address] = defaultAttr;
+			else
+				screen[address] = attr;
+
+			address += 2;
+		}
+
+		if (run) {
+			if (!--run)
+				attr = defaultAttr;
+		}
+
+		if (skip)
+			skip--;
+	}
+
+	if (block && (block->flags&LEX_BLOCK_LINES))
+		return ((int)(block - language->blocks) + 1);
+
+	return (0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Returns the keyword starting at column, or -1. The whole identifier is  #*/
+/*# hashed once, so only an exact match can be a keyword.                   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int LexKeyword(LEX_LANGUAGE*language, EDIT_LINE*line, int column)
+{
+	LEX_TABLES*tables = language->tables;
+	unsigned int bucket, slot;
+	int end, len, index;
+	char*text = &line->line[column];
+
+	for (end = column + 1; end < line->len && (CLASS(language, line->line[end])
+	    &LEX_CLASS_IDENT); end++)
+		;
+
+	len = end - column;
+
+	bucket = KeywordHash(language, text, len, 0)&tables->bucketMask;
+	slot = KeywordHash(language, text, len, tables->seeds[bucket])&tables->
+	    slotMask;
+
+	index = tables->slots[slot];
+
+	if (index < 0 || language->keywords[index].len != len)
+		return (-1);
+
+	if (!KeywordMatch(language, language->keywords[index].text, text, len))
+		return (-1);
+
+	return (index);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void LexClasses(LEX_LANGUAGE*language)
+{
+	LEX_TABLES*tables = language->tables;
+	int i;
+	char*ch;
+
+	memset(tables->classes, 0, sizeof(tables->classes));
+
+	for (i = 'a'; i <= 'z'; i++)
+		tables->classes[i] = LEX_CLASS_WORD | LEX_CLASS_IDENT;
+
+	for (i = 'A'; i <= 'Z'; i++)
+		tables->classes[i] = LEX_CLASS_WORD | LEX_CLASS_IDENT;
+
+	for (i = '0'; i <= '9'; i++)
+		tables->classes[i] = LEX_CLASS_DIGIT | LEX_CLASS_IDENT;
+
+	for (ch = language->wordChars; *ch; ch++)
+		CLASS(language, *ch) |= LEX_CLASS_WORD | LEX_CLASS_IDENT;
+
+	for (ch = language->numbers; *ch; ch++)
+		CLASS(language, *ch) |= LEX_CLASS_NUMBER;
+
+	for (ch = language->operators; *ch; ch++)
+		CLASS(language, *ch) |= LEX_CLASS_OPERATOR;
+
+	for (i = 0; i < language->numBlocks; i++)
+		CLASS(language, language->blocks[i].start[0]) |= LEX_CLASS_BLOCK;
+
+	for (i = 0; i < language->numKeywords; i++) {
+		ch = language->keywords[i].text;
+
+		CLASS(language, ch[0]) |= LEX_CLASS_KEYWORD;
+
+		if (language->flags&LEX_FLAG_NOCASE) {
+			if (ch[0] >= 'a' && ch[0] <= 'z')
+				CLASS(language, ch[0] - 32) |= LEX_CLASS_KEYWORD;
+
+			if (ch[0] >= 'A' && ch[0] <= 'Z')
+				CLASS(language, ch[0] + 32) |= LEX_CLASS_KEYWORD;
+		}
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Build a hash and displace perfect hash over the keywords, the same      #*/
+/*# scheme as the spelling dictionary. Keywords are split into buckets of   #*/
+/*# about two, and each bucket, largest first, gets the first seed that     #*/
+/*# sends all of its keywords to free slots. A lookup is then two hashes    #*/
+/*# and one compare.                                                        #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void LexHashKeywords(LEX_LANGUAGE*language)
+{
+	LEX_TABLES*tables = language->tables;
+	int*heads, *next, *counts, *bucket;
+	int i, j, b, size, buckets, count, maxCount;
+	unsigned int seed;
+
+	for (size = 8; size < language->numKeywords*2; size <<= 1)
+		;
+
+	next = (int*)OS_Malloc((language->numKeywords + 1)*sizeof(int));
+	bucket = (int*)OS_Malloc((language->numKeywords + 1)*sizeof(int));
+
+	for (;;) {
+		buckets = size / 4;
+
+		tables->slots = (short*)OS_Malloc(size*sizeof(short));
+		tables->seeds = (unsigned int*)OS_Malloc(buckets*sizeof(unsigned int));
+		tables->slotMask = size - 1;
+		tables->bucketMask = buckets - 1;
+
+		heads = (int*)OS_Malloc(buckets*sizeof(int));
+		counts = (int*)OS_Malloc(buckets*sizeof(int));
+
+		for (i = 0; i < size; i++)
+			tables->slots[i] = -1;
+
+		for (i = 0; i < buckets; i++) {
+			tables->seeds[i] = 0;
+			heads[i] = -1;
+			counts[i] = 0;
+		}
+
+		for (i = 0, maxCount = 0; i < language->numKeywords; i++) {
+			b = KeywordHash(language, language->keywords[i].text, language->
+			    keywords[i].len, 0)&tables->bucketMask;
+
+			/* A repeated keyword lands in the same bucket; keep the first */
+			for (j = heads[b]; j != -1; j = next[j])
+				if (language->keywords[j].len == language->keywords[i].len &&
+				    KeywordMatch(language, language->keywords[j].text,
+				    language->keywords[i].text, language->keywords[i].len))
+					break;
+
+			if (j != -1)
+				continue;
+
+			next[i] = heads[b];
+			heads[b] = i;
+
+			if (++counts[b] > maxCount)
+				maxCount = counts[b];
+		}
+
+		for (count = maxCount; count; count--) {
+			for (b = 0; b < buckets; b++) {
+				if (counts[b] != count)
+					continue;
+
+				for (i = 0, j = heads[b]; j != -1; j = next[j])
+					bucket[i++] = j;
+
+				for (seed = 1; seed < MAX_KEYWORD_SEEDS; seed++)
+					if (PlaceBucket(language, bucket, count, seed))
+						break;
+
+				if (seed == MAX_KEYWORD_SEEDS)
+					break;
+
+				tables->seeds[b] = seed;
+			}
+
+			if (b < buckets)
+				break;
+		}
+
+		OS_Free(heads);
+		OS_Free(counts);
+
+		if (!count)
+			break;
+
+		OS_Free(tables->slots);
+		OS_Free(tables->seeds);
+		size <<= 1;
+	}
+
+	OS_Free(next);
+	OS_Free(bucket);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Claim a slot for every keyword in the bucket with this seed, or none.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int PlaceBucket(LEX_LANGUAGE*language, int*bucket, int count, unsigned
+    int seed)
+{
+	LEX_TABLES*tables = language->tables;
+	unsigned int slot;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		slot = KeywordHash(language, language->keywords[bucket[i]].text,
+		    language->keywords[bucket[i]].len, seed)&tables->slotMask;
+
+		if (tables->slots[slot] != -1)
+			break;
+
+		tables->slots[slot] = (short)bucket[i];
+	}
+
+	if (i == count)
+		return (1);
+
+	while (i--) {
+		slot = KeywordHash(language, language->keywords[bucket[i]].text,
+		    language->keywords[bucket[i]].len, seed)&tables->slotMask;
+
+		tables->slots[slot] = -1;
+	}
+
+	return (0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Same mixing as DictionaryHash in spell.c, folded to upper case for      #*/
+/*# languages whose keywords ignore case.                                   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned int KeywordHash(LEX_LANGUAGE*language, char*text, int len,
+    unsigned int seed)
+{
+	unsigned int hash = 2166136261U ^ (seed*0x9e3779b9U);
+	unsigned char ch;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		ch = (unsigned char)text[i];
+
+		if ((language->flags&LEX_FLAG_NOCASE) && ch >= 'a' && ch <= 'z')
+			ch -= 32;
+
+		hash = (hash ^ ch)*16777619U;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+
+	return (hash);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int KeywordMatch(LEX_LANGUAGE*language, char*keyword, char*text, int
+    len)
+{
+	int i;
+	char ch1, ch2;
+
+	if (!(language->flags&LEX_FLAG_NOCASE))
+		return (!memcmp(keyword, text, len));
+
+	for (i = 0; i < len; i++) {
+		ch1 = keyword[i];
+		ch2 = text[i];
+
+		if (ch1 >= 'a' && ch1 <= 'z')
+			ch1 -= 32;
+
+		if (ch2 >= 'a' && ch2 <= 'z')
+			ch2 -= 32;
+
+		if (ch1 != ch2)
+			return (0);
+	}
+	return (1);
+}
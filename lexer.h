@@ -0,0 +1,114 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#ifndef __LEXER_H__
+#define __LEXER_H__
+
+#define LEX_COLOR_DEFAULT      0
+#define LEX_COLOR_OPERATOR     1
+#define LEX_COLOR_NUMBER       2
+#define LEX_COLOR_CHAR         3
+#define LEX_COLOR_STRING       4
+#define LEX_COLOR_COMMENT      5
+#define LEX_COLOR_KEYWORD      6
+#define LEX_COLOR_PREPROCESSOR 7
+#define LEX_COLOR_XML_COMMENT  8
+#define LEX_NUM_COLORS         9
+
+/* The block is still open at the start of the next line */
+#define LEX_BLOCK_LINES 0x01
+
+/* Only colorize inside <...> tags */
+#define LEX_FLAG_TAGS   0x01
+/* Keywords match in any case */
+#define LEX_FLAG_NOCASE 0x02
+
+/* Character classes, looked up once per column instead of with strchr */
+#define LEX_CLASS_WORD     0x01 /* Letters and wordChars                  */
+#define LEX_CLASS_DIGIT    0x02
+#define LEX_CLASS_IDENT    0x04 /* Carries on a keyword                   */
+#define LEX_CLASS_NUMBER   0x08 /* Carries on a number                    */
+#define LEX_CLASS_OPERATOR 0x10
+#define LEX_CLASS_BLOCK    0x20 /* First character of a block start      */
+#define LEX_CLASS_KEYWORD  0x40 /* First character of a keyword           */
+
+/* A quoted string or comment. An end of 0 runs to the end of the line.  */
+/* A line starts in state 0, or in state n when block n-1 carried over.  */
+typedef struct lexBlock
+{
+	char*start;
+	char*end;
+	char escape;
+	int startLen;
+	int endLen;
+	int flags;
+	int color;
+}LEX_BLOCK;
+
+typedef struct lexKeyword
+{
+	char*text;
+	int len;
+	int color;
+}LEX_KEYWORD;
+
+/* Built by LexSetup from a language's tables */
+typedef struct lexTables
+{
+	unsigned char classes[256];
+	short*slots;          /* Keyword in each slot of the perfect hash, or -1 */
+	unsigned int*seeds;   /* Seed of each bucket                             */
+	unsigned int slotMask;
+	unsigned int bucketMask;
+}LEX_TABLES;
+
+/* A language is just its tables; lexer.c does the rest. Blocks are */
+/* tried in order, so a longer start must come before its prefix.   */
+typedef struct lexLanguage
+{
+	LEX_BLOCK*blocks;
+	int numBlocks;
+	LEX_KEYWORD*keywords;
+	int numKeywords;
+	char*operators;
+	char*numbers;    /* Characters that carry on a number */
+	char*wordChars;  /* Word characters besides letters */
+	int flags;
+	LEX_TABLES*tables;
+}LEX_LANGUAGE;
+
+void LexSetupColors(void);
+void LexSetup(LEX_LANGUAGE*language);
+void LexStart(EDIT_FILE*file, LEX_LANGUAGE*language);
+void LexColorize(void*file, EDIT_LINE*line, int pan, int len, SCR_PTR*screen,
+    int address, char defaultAttr);
+int LexLinePfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+
+#endif /* __LEXER_H__ */
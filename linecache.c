@@ -0,0 +1,166 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "osdep.h" /* Platform dependent interface */
+#include <string.h>
+#include <stdio.h>
+#include "proedit.h"
+
+/* A power of two, so the probe can wrap with a mask */
+#define LINE_CACHE_SLOTS 1024
+
+static void*LineSlot(LINE_CACHE*cache, EDIT_LINE*line);
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Each entry is entrySize bytes and starts with its EDIT_LINE pointer.    #*/
+/*# freeEntry, if set, releases whatever an entry points at when the cache  #*/
+/*# is cleared.                                                             #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+LINE_CACHE*CreateLineCache(int entrySize, LINE_CACHE_PFN*freeEntry)
+{
+	LINE_CACHE*cache;
+
+	cache = (LINE_CACHE*)OS_Malloc(sizeof(LINE_CACHE));
+
+	cache->slots = (char*)OS_Malloc(LINE_CACHE_SLOTS*entrySize);
+	memset(cache->slots, 0, LINE_CACHE_SLOTS*entrySize);
+
+	cache->entrySize = entrySize;
+	cache->used = 0;
+	cache->freeEntry = freeEntry;
+
+	return (cache);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeLineCache(LINE_CACHE*cache)
+{
+	if (!cache)
+		return ;
+
+	ClearLineCache(cache);
+	OS_Free(cache->slots);
+	OS_Free(cache);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The entry for line, or 0 if it has none.                                #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void*FindLineEntry(LINE_CACHE*cache, EDIT_LINE*line)
+{
+	void*entry;
+
+	entry = LineSlot(cache, line);
+
+	return (*(EDIT_LINE**)entry ? entry : 0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The entry for line, adding a zeroed one if it has none. The cache is    #*/
+/*# cleared first when it is half full, so an add can free every entry      #*/
+/*# found before it.                                                        #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void*AddLineEntry(LINE_CACHE*cache, EDIT_LINE*line)
+{
+	void*entry;
+
+	entry = LineSlot(cache, line);
+
+	if (*(EDIT_LINE**)entry)
+		return (entry);
+
+	if (cache->used >= LINE_CACHE_SLOTS/2) {
+		ClearLineCache(cache);
+		entry = LineSlot(cache, line);
+	}
+
+	*(EDIT_LINE**)entry = line;
+	cache->used++;
+
+	return (entry);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void ClearLineCache(LINE_CACHE*cache)
+{
+	int i;
+
+	if (cache->freeEntry)
+		for (i = 0; i < LINE_CACHE_SLOTS; i++)
+			if (*(EDIT_LINE**)&cache->slots[i*cache->entrySize])
+				cache->freeEntry(&cache->slots[i*cache->entrySize]);
+
+	memset(cache->slots, 0, LINE_CACHE_SLOTS*cache->entrySize);
+	cache->used = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Open addressed on the line pointer. Returns the line's slot or the      #*/
+/*# empty slot where it would go.                                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void*LineSlot(LINE_CACHE*cache, EDIT_LINE*line)
+{
+	EDIT_LINE**slot;
+	unsigned int index;
+
+	index = (unsigned int)(((size_t)line/sizeof(EDIT_LINE))*2654435761U);
+
+	for (; ; index++) {
+		index &= LINE_CACHE_SLOTS - 1;
+
+		slot = (EDIT_LINE**)&cache->slots[index*cache->entrySize];
+
+		if (*slot == line || !*slot)
+			return (slot);
+	}
+}
@@ -30,36 +30,254 @@
 #include "osdep.h" /* Platform dependent interface */
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
+#include <limits.h>
 #include "proedit.h"
 
 #define TEST_OPT
 
+/* Diagonal steps between abort checks while diffing */
+#define MERGE_ABORT_WORK     0x40000L
+
+/* Edit cost after which a split settles for the best diagonal so far */
+#define MERGE_MIN_EXPENSIVE  4096
+
+/* Combined line count above which the second file is hashed on a thread */
+#define MERGE_THREAD_LINES   20000
+
+/* Most threads a merge or directory compare will run */
+#define MERGE_MAX_THREADS    16
+
+/* Read size when a tree file can't be mapped (a multiple of 8) */
+#define MERGE_READ_CHUNK     0x10000L
+
+/* Smallest block a binary compare matches, and the most blocks it indexes */
+#define MERGE_MIN_BLOCK      32
+#define MERGE_MAX_BLOCKS     0x100000L
+
+/* Same hash blocks looked at before a binary compare gives up on a match */
+#define MERGE_BLOCK_CHAIN    64
+
+/* Hex rows shown for each side of a binary hunk */
+#define MERGE_HEX_ROWS       256
+
+/* Lines the change gutter will walk looking for an unchanged line */
+#define MERGE_GUTTER_REACH   10000
+
+/* Lines marked above and below the window, so scrolling reuses them */
+#define MERGE_GUTTER_MARGIN  256
+
+#define MERGE_HASH_SEED      0xcbf29ce484222325ULL
+#define MERGE_HASH_PRIME     0x9e3779b97f4a7c15ULL
+
+#define DIFF_POLL_ABORT      0x01
+#define DIFF_POLL_PROGRESS   0x02
+#define DIFF_POLL_CANCEL     0x04
+
 extern int merge_nows;
 
+typedef struct lineHash
+{
+	EDIT_LINE*line;
+	unsigned long long hash;
+}EDIT_LINE_HASH;
+
 typedef struct
 {
-	unsigned long file1, file2;
-	int match;
-}INDEX_TABLE;
+	EDIT_LINE_HASH key;
+	char in1, in2;
+}MERGE_SLOT;
 
-EDIT_FILE**fileHandles;
+typedef struct
+{
+	int xmid, ymid;
+}MERGE_SPLIT;
 
-static EDIT_FILE*CreateMergeFile(EDIT_FILE*file1, EDIT_FILE*file2);
-static int MergeCompareLines(int line1, int numLines1, int line2,
-    int numLines2);
-static int CompareFilenames(EDIT_FILE*comp1, EDIT_FILE*comp2);
-static int MergeLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+typedef struct
+{
+	EDIT_LINE_HASH*hash1;
+	EDIT_LINE_HASH*hash2;
+	int*x;
+	int*y;
+	int*xindex;
+	int*yindex;
+	char*changed1;
+	char*changed2;
+	int*fdiag;
+	int*bdiag;
+	int numX, numY;
+	int tooExpensive;
+	long work;
+	int poll;
+	int aborted;
+}MERGE_DIFF;
 
-typedef struct lineHash
+typedef struct
+{
+	long offset1, offset2, len;
+}MERGE_MATCH;
+
+typedef struct
+{
+	char*data1;
+	char*data2;
+	long start1, limit1;       /* File1 range the blocks were indexed over */
+	long blockSize;
+	unsigned long long*blockHash;
+	int*heads;
+	int*next;
+	int shift;                 /* Hash bits dropped for the bucket index */
+	MERGE_MATCH*matches;
+	int numMatches, maxMatches;
+	long work;
+	int poll;
+	int aborted;
+}MERGE_BINARY;
+
+typedef struct
+{
+	EDIT_FILE*file1;
+	EDIT_FILE*file2;
+	int single;  /* Only job, so it may use a hash thread and the progress bar */
+	int done;
+	MERGE_DIFF diff;
+	MERGE_BINARY binary;  /* Used instead of diff for hex mode files */
+}MERGE_JOB;
+
+typedef struct
+{
+	EDIT_LINE_HASH*table;
+	int numLines;
+}HASH_JOB;
+
+typedef void MERGE_TASK_PFN(void*tasks, int index, int poll);
+
+typedef struct
+{
+	MERGE_TASK_PFN*pfn;
+	void*tasks;
+	int numTasks;
+	int next;
+}MERGE_POOL;
+
+typedef struct
+{
+	char*path;   /* Relative to the tree root */
+	long size;
+	unsigned long long hash;
+	int mate;    /* Same path in the other tree, or -1 */
+	int next;    /* Path hash chain */
+}TREE_FILE;
+
+typedef struct
+{
+	char root[MAX_FILENAME];
+	TREE_FILE*files;
+	int numFiles, maxFiles;
+}MERGE_TREE;
+
+typedef struct
+{
+	MERGE_TREE*tree1;
+	MERGE_TREE*tree2;
+	int*pairs;
+}TREE_HASH_JOB;
+
+typedef struct
 {
 	EDIT_LINE*line;
-	unsigned int hash;
-}EDIT_LINE_HASH;
+	char*text;   /* line->line and len when the spans were found */
+	int len;
+	int*spans;   /* Changed start/end columns ended by -1, or 0 for none */
+}MERGE_SPANS;
+
+typedef struct
+{
+	EDIT_LINE*line;
+	int index;   /* Saved line number, or -1 once the line is deleted */
+}GUTTER_SLOT;
+
+typedef struct mergeGutter
+{
+	unsigned long long*saved;   /* Hash of each line as it is on disk */
+	int numSaved;
+	GUTTER_SLOT*slots;          /* Saved line number by line pointer */
+	unsigned int mask;
+	char*marks;                 /* Marks of numMarks lines from first, */
+	int first;                  /* kept until the next line operation  */
+	int numMarks;
+}MERGE_GUTTER;
 
-static EDIT_LINE_HASH*HashLines(EDIT_FILE*file);
+EDIT_FILE**fileHandles;
 
-static EDIT_LINE_HASH*hashFile1;
-static EDIT_LINE_HASH*hashFile2;
+static int PairFilenames(EDIT_FILE**files, int numFiles, int*comp1, int*comp2);
+static EDIT_FILE*MergePairs(MERGE_JOB*jobs, int numJobs, int*total);
+static void MergeTask(MERGE_JOB*jobs, int index, int poll);
+static EDIT_FILE*CreateMergeFile(MERGE_JOB*job);
+static EDIT_FILE*CreateHexMergeFile(MERGE_JOB*job);
+static EDIT_FILE*AllocMergeFile(EDIT_FILE*file1, EDIT_FILE*file2);
+static EDIT_LINE*AddHexRows(EDIT_FILE*file, EDIT_LINE*line, char*data, long
+    offset, long len, int flags);
+static void RunTasks(MERGE_TASK_PFN*pfn, void*tasks, int numTasks,
+    char*progress);
+static void PoolWorker(MERGE_POOL*pool);
+static int NextTask(MERGE_POOL*pool);
+static void CancelMerge(void);
+static int MergeCancelled(void);
+static int DiffLines(MERGE_DIFF*diff, EDIT_LINE_HASH*hash1, int numLines1,
+    EDIT_LINE_HASH*hash2, int numLines2, int poll);
+static void FreeDiff(MERGE_DIFF*diff);
+static void DiscardUnique(MERGE_DIFF*diff, int start, int end1, int end2);
+static void CompareSequence(MERGE_DIFF*diff, int xoff, int xlim, int yoff,
+    int ylim);
+static void SplitSequence(MERGE_DIFF*diff, int xoff, int xlim, int yoff,
+    int ylim, MERGE_SPLIT*split);
+static int MergeLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+static EDIT_LINE_HASH*AllocLineHash(EDIT_FILE*file);
+static void HashLines(EDIT_LINE_HASH*table1, int numLines1,
+    EDIT_LINE_HASH*table2, int numLines2, int threaded);
+static void HashWorker(HASH_JOB*job);
+static unsigned long long LineHash(char*line, int len);
+static unsigned long long HashBytes(unsigned long long hash, char*data,
+    long len);
+static int SameLine(EDIT_LINE_HASH*hash1, EDIT_LINE_HASH*hash2);
+static int DiffBytes(MERGE_BINARY*binary, char*data1, long size1, char*data2,
+    long size2, int poll);
+static void FreeBytes(MERGE_BINARY*binary);
+static void IndexBlocks(MERGE_BINARY*binary, long start1, long limit1);
+static void MatchBlocks(MERGE_BINARY*binary, long start2, long limit2);
+static long FindBlock(MERGE_BINARY*binary, unsigned long long hash, char*data,
+    long end1, long expected);
+static void AddMatch(MERGE_BINARY*binary, long offset1, long offset2, long
+    len);
+static unsigned long PathHash(char*path);
+static int OpenTree(MERGE_TREE*tree, char*dir);
+static int ReadTree(MERGE_TREE*tree, char*relPath);
+static void AddTreeFile(MERGE_TREE*tree, char*relPath, long size);
+static void FreeTree(MERGE_TREE*tree);
+static int PairTrees(MERGE_TREE*tree1, MERGE_TREE*tree2);
+static void TreeHashTask(TREE_HASH_JOB*job, int index, int poll);
+static int HashFile(char*root, char*path, long size, unsigned long long*hash);
+static EDIT_FILE*LoadTreeFile(EDIT_FILE*current, char*root, char*path);
+static void StoreSpans(LINE_CACHE*cache, EDIT_LINE*line, int*spans);
+static void FreeSpans(MERGE_SPANS*entry);
+static EDIT_LINE*DiffPartner(EDIT_LINE*line);
+static void DiffWords(EDIT_LINE*line1, EDIT_LINE*line2, int**spans1,
+    int**spans2);
+static int SplitWords(EDIT_LINE*line, EDIT_LINE*words);
+static int*ChangedSpans(EDIT_LINE*line, EDIT_LINE*words, int numWords,
+    char*changed);
+static int GutterLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+static GUTTER_SLOT*FindGutterSlot(MERGE_GUTTER*gutter, EDIT_LINE*line);
+static int SavedLine(MERGE_GUTTER*gutter, EDIT_LINE*line, int after);
+static void GutterMarks(MERGE_GUTTER*gutter, EDIT_LINE*top, int rows, char
+    *marks);
+static void MarkGutterRegion(MERGE_GUTTER*gutter, EDIT_LINE*start, int count,
+    int saved, int numSaved, int row, int rows, char*marks);
+static unsigned long long GutterHash(EDIT_LINE*line);
+
+static OS_MUTEX*mergeLock;
+static int mergeCancel;
 static int aborted;
 
 /*###########################################################################*/
@@ -71,9 +289,9 @@ static int aborted;
 EDIT_FILE*Merge(EDIT_FILE*current)
 {
 	char newFilename[MAX_FILENAME*2];
-	int i, j, found = 0, total = 0, totalFiles = 0, numFiles;
+	int i, found = 0, total = 0, totalFiles = 0, numFiles, numJobs = 0;
 	EDIT_FILE*original;
-	char*flags;
+	MERGE_JOB*jobs;
 	int*comp1;
 	int*comp2;
 	int already_merged = 0;
@@ -83,9 +301,9 @@ EDIT_FILE*Merge(EDIT_FILE*current)
 	original = current;
 
 	fileHandles = (EDIT_FILE**)OS_Malloc(numFiles*sizeof(EDIT_FILE*));
-	flags = (char*)OS_Malloc(numFiles*sizeof(char));
 	comp1 = (int*)OS_Malloc(numFiles*sizeof(int));
 	comp2 = (int*)OS_Malloc(numFiles*sizeof(int));
+	jobs = (MERGE_JOB*)OS_Malloc(numFiles*sizeof(MERGE_JOB));
 
 	memset(fileHandles, 0, numFiles*sizeof(EDIT_FILE*));
 
@@ -93,50 +311,19 @@ EDIT_FILE*Merge(EDIT_FILE*current)
 		fileHandles[i] = current;
 		current = NextFile(current);
 
-		/* Skip over Hex mode files and previously merged files */
-		while (current->hexMode || (current->file_flags&FILE_FLAG_MERGED))
+		/* Skip over previously merged files */
+		while (current->file_flags&FILE_FLAG_MERGED)
 			current = NextFile(current);
 
 		if (current == original)
 			break;
 	}
 
-	for (i = 0; i < numFiles; i++) {
-		flags[i] = 0;
-
+	for (i = 0; i < numFiles; i++)
 		if (fileHandles[i])
 			totalFiles++;
-	}
-
-	for (i = 0; i < numFiles; i++)
-		if (fileHandles[i]) {
-			if (flags[i])
-				continue;
-
-			for (j = 0; j < numFiles; j++) {
-				if (j == i)
-					continue;
-
-				if (!fileHandles[j])
-					continue;
 
-				if (flags[j])
-					continue;
-
-				if (CompareFilenames(fileHandles[i], fileHandles[j])) {
-					if (flags[i]) {
-						flags[j] = 1;
-						continue;
-					}
-
-					comp1[found] = i;
-					comp2[found] = j;
-					flags[i] = 1;
-					flags[j] = 1;
-					found++;
-				}
-			}
-		}
+	found = PairFilenames(fileHandles, numFiles, comp1, comp2);
 
 	if (!found) {
 		if (totalFiles != 2)
@@ -149,20 +336,27 @@ EDIT_FILE*Merge(EDIT_FILE*current)
 	}
 
 	for (i = 0; i < found; i++) {
-		CenterBottomBar(1, "[+] Merging %d of %d files [+]", i + 1, found);
+		/* Hex mode files are only compared with each other */
+		if (!fileHandles[comp1[i]]->hexMode != !fileHandles[comp2[i]]->hexMode)
+			continue;
 
 		sprintf(newFilename, "%s.dif", fileHandles[comp1[i]]->pathname);
 
 		/* Already a merged version? */
 		if (!FileAlreadyLoaded(newFilename)) {
-			current = CreateMergeFile(fileHandles[comp1[i]],
-			    fileHandles[comp2[i]]);
-			if (current)
-				total++;
+			jobs[numJobs].file1 = fileHandles[comp1[i]];
+			jobs[numJobs].file2 = fileHandles[comp2[i]];
+			numJobs++;
 		} else
 			already_merged++;
-		if (aborted)
-			break;
+	}
+
+	aborted = 0;
+	current = 0;
+
+	if (numJobs) {
+		CenterBottomBar(1, "[+] Merging %d of %d files [+]", numJobs, found);
+		current = MergePairs(jobs, numJobs, &total);
 	}
 
 	if (found) {
@@ -184,329 +378,214 @@ EDIT_FILE*Merge(EDIT_FILE*current)
 		current = original;
 
 	OS_Free(fileHandles);
-	OS_Free(flags);
 	OS_Free(comp1);
 	OS_Free(comp2);
+	OS_Free(jobs);
 
 	current->paint_flags |= CONTENT_FLAG | CURSOR_FLAG | FRAME_FLAG;
 
 	return (current);
 }
 
+
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# Compare two directory trees. Files are paired by relative path, pairs   #*/
+/*# with the same size and content hash are skipped, and only the files    #*/
+/*# that differ are loaded and merged.                                      #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static int MergeCompareLines(int line1, int numLines1, int line2, int numLines2)
+EDIT_FILE*MergeTrees(EDIT_FILE*current)
 {
-	int total = 0;
+	char newFilename[MAX_FILENAME*2];
+	char dir1[MAX_FILENAME], dir2[MAX_FILENAME];
+	MERGE_TREE tree1, tree2;
+	TREE_HASH_JOB hashJob;
+	TREE_FILE*entry;
+	MERGE_JOB*jobs;
+	EDIT_FILE*file1, *file2, *newFile;
+	int i, numPairs, numHash = 0, numJobs = 0, numDiffer = 0, total = 0;
 
-	while (hashFile1[line1].hash == hashFile2[line2].hash) {
-		total++;
+	current->paint_flags |= CURSOR_FLAG;
 
-		line1++;
-		line2++;
+	OS_GetFilename(current->pathname, dir1, 0);
 
-		if (line1 >= numLines1)
-			break;
+	Input(HISTORY_NEWFILE, "Compare Directory:", dir1, MAX_FILENAME);
 
-		if (line2 >= numLines2)
-			break;
-	}
+	if (!strlen(dir1))
+		return (current);
 
-	return (total);
-}
+	strcpy(dir2, dir1);
 
+	Input(HISTORY_NEWFILE, "With Directory:", dir2, MAX_FILENAME);
 
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static int CompareFilenames(EDIT_FILE*comp1, EDIT_FILE*comp2)
-{
-	char cmp1[MAX_FILENAME], cmp2[MAX_FILENAME];
+	if (!strlen(dir2))
+		return (current);
 
-	OS_GetFilename(comp1->pathname, 0, cmp1);
-	OS_GetFilename(comp2->pathname, 0, cmp2);
+	memset(&tree1, 0, sizeof(MERGE_TREE));
+	memset(&tree2, 0, sizeof(MERGE_TREE));
 
-	if (!OS_Strcasecmp(cmp1, cmp2))
-		return (1);
+	if (!OpenTree(&tree1, dir1) || !OpenTree(&tree2, dir2)) {
+		CenterBottomBar(1, "[-] Invalid Directory \"%s\" [-]", tree2.root[0] ?
+		    dir2 : dir1);
+		FreeTree(&tree1);
+		FreeTree(&tree2);
+		return (current);
+	}
 
-	return (0);
-}
+	numPairs = PairTrees(&tree1, &tree2);
 
+	/* Only same sized files need their contents compared */
+	hashJob.tree1 = &tree1;
+	hashJob.tree2 = &tree2;
+	hashJob.pairs = (int*)OS_Malloc((numPairs + 1)*sizeof(int));
 
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static EDIT_FILE*CreateMergeFile(EDIT_FILE*file1, EDIT_FILE*file2)
-{
-	INDEX_TABLE indexTable1;
-	INDEX_TABLE indexTable2;
-	EDIT_FILE*newFile;
-	EDIT_LINE*newLine;
-	int file1_line_num, file2_line_num, i, j, match, deltas = 0, stop;
-	char newFilename[MAX_FILENAME*2];
+	for (i = 0; i < tree1.numFiles; i++) {
+		entry = &tree1.files[i];
+
+		if (entry->mate >= 0 && entry->size && entry->size == tree2.files[
+		    entry->mate].size)
+			hashJob.pairs[numHash++] = i;
+	}
 
 	aborted = 0;
+	mergeCancel = 0;
 
 	ProgressBar(0, 0, 0);
 
-	hashFile1 = HashLines(file1);
-	hashFile2 = HashLines(file2);
-
-	sprintf(newFilename, "%s.dif", file1->pathname);
-
-	file1_line_num = 0;
-	file2_line_num = 0;
+	RunTasks((MERGE_TASK_PFN*)TreeHashTask, &hashJob, numHash, "Comparing");
 
-	newFile = AllocFile(newFilename);
-	newLine = newFile->lines;
+	jobs = (MERGE_JOB*)OS_Malloc((numPairs + 1)*sizeof(MERGE_JOB));
 
-	newFile->diff1_filename = OS_Malloc(strlen(file1->pathname) + 1);
-	strcpy(newFile->diff1_filename, file1->pathname);
+	for (i = 0; i < tree1.numFiles && !mergeCancel; i++) {
+		entry = &tree1.files[i];
 
-	newFile->diff2_filename = OS_Malloc(strlen(file2->pathname) + 1);
-	strcpy(newFile->diff2_filename, file2->pathname);
+		if (AbortRequest())
+			mergeCancel = 1;
 
-	for (; ; ) {
-		if (AbortRequest()) {
-			aborted = 1;
-			break;
-		}
+		if (entry->mate < 0)
+			continue;
 
-		ProgressBar("Merging", file1_line_num, file1->number_lines);
+		if (entry->size == tree2.files[entry->mate].size && entry->hash ==
+		    tree2.files[entry->mate].hash)
+			continue;
 
-		match = MergeCompareLines(file1_line_num, file1->number_lines,
-		    file2_line_num, file2->number_lines);
+		numDiffer++;
 
-		if (match) {
-			for (i = 0; i < match; i++) {
-				newLine = AddFileLine(newFile, newLine,
-				    hashFile1[file1_line_num].line->line, hashFile1[
-				    file1_line_num].line->len, 0);
+		file1 = LoadTreeFile(current, tree1.root, entry->path);
+		file2 = LoadTreeFile(current, tree2.root, tree2.files[entry->mate].
+		    path);
 
-				file1_line_num++;
-				file2_line_num++;
-			}
-			if (AbortRequest()) {
-				aborted = 1;
-				break;
-			}
-		} else {
-			/* Re-Sync Code */
-			indexTable1.match = 0;
-			indexTable1.file1 = 0;
-			indexTable1.file2 = 0;
+		if (!file1 || !file2 || !file1->hexMode != !file2->hexMode)
+			continue;
 
-			indexTable2.match = 0;
-			indexTable2.file1 = 0;
-			indexTable2.file2 = 0;
+		sprintf(newFilename, "%s.dif", file1->pathname);
 
-			stop = file1->number_lines;
+		if (FileAlreadyLoaded(newFilename))
+			continue;
 
-			for (j = file1_line_num; j < file1->number_lines && j < stop; j++) {
-				if (AbortRequest()) {
-					aborted = 1;
-					break;
-				}
+		jobs[numJobs].file1 = file1;
+		jobs[numJobs].file2 = file2;
+		numJobs++;
+	}
 
-				for (i = file2_line_num; i < file2->number_lines && i < stop; i
-				    ++) {
-					match = MergeCompareLines(j, file1->number_lines, i,
-					    file2->number_lines);
-
-					if (match) {
-						if (match > indexTable1.match) {
-							indexTable1.match = match;
-							indexTable1.file1 = j;
-							indexTable1.file2 = i;
-
-							if (MAX(i, j) + match < stop)
-								stop = MAX(i, j) + match;
-						}
-						break;
-					}
-				}
+	if (mergeCancel)
+		aborted = 1;
 
-				if (j + indexTable1.match >= stop)
-					break;
-			}
+	newFile = 0;
 
-			if (aborted)
-				break;
+	if (numJobs && !aborted) {
+		CenterBottomBar(1, "[+] Merging %d of %d files [+]", numJobs,
+		    numDiffer);
+		newFile = MergePairs(jobs, numJobs, &total);
+	}
 
-			stop = file2->number_lines;
+	if (aborted)
+		CenterBottomBar(1, "[-] Directory Compare Aborted... [-]");
+	else
+		if (!numPairs)
+			CenterBottomBar(1, "[-] No Files Found In Both Directories [-]");
+		else
+			CenterBottomBar(1,
+			    "[+] %d of %d Files Differ, %d Different Files Merged [+]",
+			    numDiffer, numPairs, total);
 
-			for (j = file2_line_num; j < file2->number_lines && j < stop; j++) {
-				if (AbortRequest()) {
-					aborted = 1;
-					break;
-				}
+	OS_Free(jobs);
+	OS_Free(hashJob.pairs);
+	FreeTree(&tree1);
+	FreeTree(&tree2);
 
-				for (i = file1_line_num; i < file1->number_lines && i < stop; i
-				    ++) {
-					match = MergeCompareLines(i, file1->number_lines, j,
-					    file2->number_lines);
-
-					if (match) {
-						if (match > indexTable2.match) {
-							indexTable2.match = match;
-							indexTable2.file1 = i;
-							indexTable2.file2 = j;
-
-							if (MAX(i, j) + match < stop)
-								stop = MAX(i, j) + match;
-						}
-						break;
-					}
-				}
+	if (newFile)
+		current = newFile;
 
-				if (j + indexTable2.match >= stop)
-					break;
-			}
+	current->paint_flags |= CONTENT_FLAG | CURSOR_FLAG | FRAME_FLAG;
 
-			if (aborted)
-				break;
+	return (current);
+}
 
-			if (indexTable1.match && indexTable1.match >= indexTable2.match) {
-				if (file1_line_num < (int)indexTable1.file1)
-					AddBookmark(newFile, newLine, 0, 0);
 
-				for (i = file1_line_num; i < (int)indexTable1.file1; i++) {
-					newLine = AddFileLine(newFile, newLine, hashFile1[i].line->
-					    line, hashFile1[i].line->len, LINE_FLAG_DIFF1);
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Compute the shortest edit script between the two hashed files (Myers    #*/
+/*# O(ND) with linear space). Changed lines are flagged in changed1 and     #*/
+/*# changed2; the remaining lines pair up in order. Returns 0 if aborted.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int DiffLines(MERGE_DIFF*diff, EDIT_LINE_HASH*hash1, int numLines1,
+    EDIT_LINE_HASH*hash2, int numLines2, int poll)
+{
+	int start, end1, end2, diags;
 
-					deltas = 1;
-					file1_line_num++;
-				}
+	memset(diff, 0, sizeof(MERGE_DIFF));
 
-				if (file2_line_num < (int)indexTable1.file2)
-					AddBookmark(newFile, newLine, 0, 0);
+	diff->hash1 = hash1;
+	diff->hash2 = hash2;
+	diff->poll = poll;
 
-				for (i = file2_line_num; i < (int)indexTable1.file2; i++) {
-					newLine = AddFileLine(newFile, newLine, hashFile2[i].line->
-					    line, hashFile2[i].line->len, LINE_FLAG_DIFF2);
+	diff->changed1 = (char*)OS_Malloc(numLines1 + 1);
+	diff->changed2 = (char*)OS_Malloc(numLines2 + 1);
 
-					deltas = 1;
-					file2_line_num++;
-				}
-			} else
-				if (indexTable2.match && indexTable2.match >=
-				    indexTable1.match) {
-					if (file1_line_num < (int)indexTable2.file1)
-						AddBookmark(newFile, newLine, 0, 0);
-
-					for (i = file1_line_num; i < (int)indexTable2.file1; i++) {
-						newLine = AddFileLine(newFile, newLine, hashFile1[i].
-						    line->line, hashFile1[i].line->len,
-						    LINE_FLAG_DIFF1);
-
-						deltas = 1;
-						file1_line_num++;
-					}
-
-
-					if (file2_line_num < (int)indexTable2.file2)
-						AddBookmark(newFile, newLine, 0, 0);
-
-					for (i = file2_line_num; i < (int)indexTable2.file2; i++) {
-						newLine = AddFileLine(newFile, newLine, hashFile2[i].
-						    line->line, hashFile2[i].line->len,
-						    LINE_FLAG_DIFF2);
-
-						deltas = 1;
-						file2_line_num++;
-					}
-				} else {
-					if (file1_line_num < file1->number_lines)
-						AddBookmark(newFile, newLine, 0, 0);
-
-					while (file1_line_num < file1->number_lines) {
-						newLine = AddFileLine(newFile, newLine, hashFile1[
-						    file1_line_num].line->line,
-						    hashFile1[file1_line_num].line->len,
-						    LINE_FLAG_DIFF1);
-
-						deltas = 1;
-						file1_line_num++;
-					}
-
-					if (file2_line_num < file2->number_lines)
-						AddBookmark(newFile, newLine, 0, 0);
-
-					while (file2_line_num < file2->number_lines) {
-						newLine = AddFileLine(newFile, newLine, hashFile2[
-						    file2_line_num].line->line,
-						    hashFile2[file2_line_num].line->len,
-						    LINE_FLAG_DIFF2);
-
-						deltas = 1;
-						file2_line_num++;
-					}
-					break;
-				}
-		}
+	memset(diff->changed1, 0, numLines1 + 1);
+	memset(diff->changed2, 0, numLines2 + 1);
 
-		/* Reached End of ONE of the files..... */
-		if ((file1_line_num >= file1->number_lines) || (file2_line_num >=
-		    file2->number_lines)) {
-			if (file1_line_num < file1->number_lines)
-				AddBookmark(newFile, newLine, 0, 0);
+	/* Common head and tail lines never need to be searched */
+	start = 0;
+	end1 = numLines1;
+	end2 = numLines2;
 
-			while (file1_line_num < file1->number_lines) {
-				newLine = AddFileLine(newFile, newLine,
-				    hashFile1[file1_line_num].line->line, hashFile1[
-				    file1_line_num].line->len, LINE_FLAG_DIFF1);
+	while (start < end1 && start < end2 && SameLine(&hash1[start],
+	    &hash2[start]))
+		start++;
 
-				deltas = 1;
-				file1_line_num++;
-			}
+	while (end1 > start && end2 > start && SameLine(&hash1[end1 - 1],
+	    &hash2[end2 - 1])) {
+		end1--;
+		end2--;
+	}
 
-			if (file2_line_num < file2->number_lines)
-				AddBookmark(newFile, newLine, 0, 0);
+	DiscardUnique(diff, start, end1, end2);
 
-			while (file2_line_num < file2->number_lines) {
-				newLine = AddFileLine(newFile, newLine,
-				    hashFile2[file2_line_num].line->line, hashFile2[
-				    file2_line_num].line->len, LINE_FLAG_DIFF2);
+	diags = diff->numX + diff->numY + 3;
 
-				deltas = 1;
-				file2_line_num++;
-			}
-			break;
-		}
-	}
+	diff->fdiag = (int*)OS_Malloc(diags*sizeof(int));
+	diff->bdiag = (int*)OS_Malloc(diags*sizeof(int));
 
-	OS_Free(hashFile1);
-	OS_Free(hashFile2);
+	diff->fdiag += diff->numY + 1;
+	diff->bdiag += diff->numY + 1;
 
-	/* Don't create a delta file if the files are the same, of if the */
-	/* user aborted.                                                  */
-	if (aborted || !deltas) {
-		DeallocFile(newFile);
-		return (0);
-	}
+	diff->tooExpensive = 1;
 
-	InitDisplayFile(newFile);
-	InitCursorFile(newFile);
+	for (; diags != 0; diags >>= 2)
+		diff->tooExpensive <<= 1;
 
-	newFile->colorize = ConfigColorize(newFile, file1->pathname);
+	diff->tooExpensive = MAX(MERGE_MIN_EXPENSIVE, diff->tooExpensive);
 
-	newFile->file_flags |= FILE_FLAG_MERGED;
+	CompareSequence(diff, 0, diff->numX, 0, diff->numY);
 
-	AddFile(newFile, ADD_FILE_TOP);
-	AddLineCallback(newFile, (LINE_PFN*)MergeLineHandler,
-	    LINE_OP_GETTING_FOCUS);
+	diff->fdiag -= diff->numY + 1;
+	diff->bdiag -= diff->numY + 1;
 
-	return (newFile);
+	return (!diff->aborted);
 }
 
 
@@ -516,21 +595,97 @@ static EDIT_FILE*CreateMergeFile(EDIT_FILE*file1, EDIT_FILE*file2)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static int MergeLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
+static void FreeDiff(MERGE_DIFF*diff)
 {
-	arg = arg;
+	OS_Free(diff->hash1);
+	OS_Free(diff->hash2);
+	OS_Free(diff->x);
+	OS_Free(diff->y);
+	OS_Free(diff->xindex);
+	OS_Free(diff->yindex);
+	OS_Free(diff->changed1);
+	OS_Free(diff->changed2);
+	OS_Free(diff->fdiag);
+	OS_Free(diff->bdiag);
+}
 
-	if (op&LINE_OP_GETTING_FOCUS) {
-		if (line->flags&LINE_FLAG_DIFF1)
-			file->title = file->diff1_filename;
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Give every distinct line an id through a hash table keyed by the line   #*/
+/*# hash and verified against the line bytes, so the diff compares ints and #*/
+/*# hash collisions can't pair different lines. Lines that never occur in   #*/
+/*# the other file are flagged changed up front and left out of the diff.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void DiscardUnique(MERGE_DIFF*diff, int start, int end1, int end2)
+{
+	MERGE_SLOT*slots;
+	EDIT_LINE_HASH*hash;
+	unsigned int mask, index;
+	int i, size;
+
+	for (size = 64; size < 2*((end1 - start) + (end2 - start)); size <<= 1)
+		;
+
+	mask = (unsigned int)size - 1;
+
+	slots = (MERGE_SLOT*)OS_Malloc(size*sizeof(MERGE_SLOT));
+	memset(slots, 0, size*sizeof(MERGE_SLOT));
+
+	diff->x = (int*)OS_Malloc((end1 - start + 1)*sizeof(int));
+	diff->y = (int*)OS_Malloc((end2 - start + 1)*sizeof(int));
+	diff->xindex = (int*)OS_Malloc((end1 - start + 1)*sizeof(int));
+	diff->yindex = (int*)OS_Malloc((end2 - start + 1)*sizeof(int));
+
+	for (i = start; i < end1 + (end2 - start); i++) {
+		if (i < end1)
+			hash = &diff->hash1[i];
 		else
-			if (line->flags&LINE_FLAG_DIFF2)
-				file->title = file->diff2_filename;
-			else
-				file->title = 0;
+			hash = &diff->hash2[i - end1 + start];
+
+		index = (unsigned int)(hash->hash >> 32) & mask;
+
+		/* Saved gutter hashes have no line, so the flags mark a used slot */
+		while ((slots[index].in1 || slots[index].in2) && !SameLine(hash,
+		    &slots[index].key))
+			index = (index + 1) & mask;
+
+		slots[index].key = *hash;
+
+		if (i < end1)
+			slots[index].in1 = 1;
+		else
+			slots[index].in2 = 1;
 	}
 
-	return (0);
+	for (i = start; i < end1 + (end2 - start); i++) {
+		if (i < end1)
+			hash = &diff->hash1[i];
+		else
+			hash = &diff->hash2[i - end1 + start];
+
+		index = (unsigned int)(hash->hash >> 32) & mask;
+
+		while (!SameLine(hash, &slots[index].key))
+			index = (index + 1) & mask;
+
+		if (i < end1) {
+			if (slots[index].in2) {
+				diff->x[diff->numX] = (int)index;
+				diff->xindex[diff->numX++] = i;
+			} else
+				diff->changed1[i] = 1;
+		} else {
+			if (slots[index].in1) {
+				diff->y[diff->numY] = (int)index;
+				diff->yindex[diff->numY++] = i - end1 + start;
+			} else
+				diff->changed2[i - end1 + start] = 1;
+		}
+	}
+
+	OS_Free(slots);
 }
 
 
@@ -540,41 +695,2211 @@ static int MergeLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static EDIT_LINE_HASH*HashLines(EDIT_FILE*file)
+static void CompareSequence(MERGE_DIFF*diff, int xoff, int xlim, int yoff,
+    int ylim)
 {
-	unsigned int hash;
-	EDIT_LINE_HASH*hashTable;
-	EDIT_LINE*line;
-	int i, index;
+	MERGE_SPLIT split;
 
-	hashTable = (EDIT_LINE_HASH*)
-	OS_Malloc((file->number_lines + 2)*sizeof(EDIT_LINE_HASH));
+	if (diff->aborted)
+		return ;
 
-	memset(hashTable, 0, (file->number_lines + 2)*sizeof(EDIT_LINE_HASH));
+	while (xoff < xlim && yoff < ylim && diff->x[xoff] == diff->y[yoff]) {
+		xoff++;
+		yoff++;
+	}
 
-	line = file->lines;
-	index = 0;
+	while (xlim > xoff && ylim > yoff && diff->x[xlim - 1] == diff->y[ylim - 1]
+	    ) {
+		xlim--;
+		ylim--;
+	}
 
-	while (line) {
-		hash = 5137;
+	if (xoff == xlim) {
+		while (yoff < ylim)
+			diff->changed2[diff->yindex[yoff++]] = 1;
 
-		for (i = 0; i < line->len; i++) {
-			if (merge_nows && line->line[i] <= 32)
-				continue;
+		if (diff->poll&DIFF_POLL_PROGRESS)
+			ProgressBar("Merging", xlim, diff->numX);
+	} else
+		if (yoff == ylim) {
+			while (xoff < xlim)
+				diff->changed1[diff->xindex[xoff++]] = 1;
+
+			if (diff->poll&DIFF_POLL_PROGRESS)
+				ProgressBar("Merging", xlim, diff->numX);
+		} else {
+			SplitSequence(diff, xoff, xlim, yoff, ylim, &split);
 
-			hash = ((hash << 5) + hash) + line->line[i];
+			CompareSequence(diff, xoff, split.xmid, yoff, split.ymid);
+			CompareSequence(diff, split.xmid, xlim, split.ymid, ylim);
 		}
+}
 
-		hashTable[index].hash = hash;
-		hashTable[index].line = line;
-		index++;
 
-		line = line->next;
-	}
-	hashTable[index].line = 0;
-	hashTable[index].hash = (unsigned int)((unsigned long)hashTable);
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Find the middle snake of the shortest edit path by searching forward    #*/
+/*# from the start and backward from the end until the two meet. Past the   #*/
+/*# tooExpensive cost, settle for the furthest reaching diagonal instead.   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SplitSequence(MERGE_DIFF*diff, int xoff, int xlim, int yoff,
+    int ylim, MERGE_SPLIT*split)
+{
+	int*fd = diff->fdiag;
+	int*bd = diff->bdiag;
+	int*xv = diff->x;
+	int*yv = diff->y;
+	int dmin = xoff - ylim, dmax = xlim - yoff;
+	int fmid = xoff - yoff, bmid = xlim - ylim;
+	int fmin = fmid, fmax = fmid, bmin = bmid, bmax = bmid;
+	int odd = (fmid - bmid)&1;
+	int c, d, x, y, tlo, thi, best, bestx;
+
+	fd[fmid] = xoff;
+	bd[bmid] = xlim;
+
+	for (c = 1; ; c++) {
+		diff->work += (fmax - fmin) + (bmax - bmin) + 2;
+
+		if (diff->work >= MERGE_ABORT_WORK) {
+			diff->work = 0;
+
+			if ((diff->poll&DIFF_POLL_ABORT) && AbortRequest())
+				CancelMerge();
+
+			if ((diff->poll&DIFF_POLL_CANCEL) && MergeCancelled()) {
+				diff->aborted = 1;
+				split->xmid = xoff;
+				split->ymid = yoff;
+				return ;
+			}
+		}
 
-	return (hashTable);
+		/* Extend the forward search by one edit */
+		if (fmin > dmin)
+			fd[--fmin - 1] = -1;
+		else
+			fmin++;
+
+		if (fmax < dmax)
+			fd[++fmax + 1] = -1;
+		else
+			fmax--;
+
+		for (d = fmax; d >= fmin; d -= 2) {
+			tlo = fd[d - 1];
+			thi = fd[d + 1];
+
+			x = tlo >= thi ? tlo + 1 : thi;
+			y = x - d;
+
+			while (x < xlim && y < ylim && xv[x] == yv[y]) {
+				x++;
+				y++;
+			}
+
+			fd[d] = x;
+
+			if (odd && bmin <= d && d <= bmax && bd[d] <= x) {
+				split->xmid = x;
+				split->ymid = y;
+				return ;
+			}
+		}
+
+		/* Extend the backward search by one edit */
+		if (bmin > dmin)
+			bd[--bmin - 1] = INT_MAX;
+		else
+			bmin++;
+
+		if (bmax < dmax)
+			bd[++bmax + 1] = INT_MAX;
+		else
+			bmax--;
+
+		for (d = bmax; d >= bmin; d -= 2) {
+			tlo = bd[d - 1];
+			thi = bd[d + 1];
+
+			x = tlo < thi ? tlo : thi - 1;
+			y = x - d;
+
+			while (x > xoff && y > yoff && xv[x - 1] == yv[y - 1]) {
+				x--;
+				y--;
+			}
+
+			bd[d] = x;
+
+			if (!odd && fmin <= d && d <= fmax && x <= fd[d]) {
+				split->xmid = x;
+				split->ymid = y;
+				return ;
+			}
+		}
+
+		if (c < diff->tooExpensive)
+			continue;
+
+		/* Too costly for an exact answer, take whichever search */
+		/* got closest to its goal.                              */
+		best = -1;
+		bestx = xoff;
+
+		for (d = fmax; d >= fmin; d -= 2) {
+			x = MIN(fd[d], xlim);
+			y = x - d;
+
+			if (ylim < y) {
+				x = ylim + d;
+				y = ylim;
+			}
+
+			if (best < x + y) {
+				best = x + y;
+				bestx = x;
+			}
+		}
+
+		split->xmid = bestx;
+		split->ymid = best - bestx;
+
+		best = INT_MAX;
+
+		for (d = bmax; d >= bmin; d -= 2) {
+			x = MAX(xoff, bd[d]);
+			y = x - d;
+
+			if (y < yoff) {
+				x = yoff + d;
+				y = yoff;
+			}
+
+			if (x + y < best) {
+				best = x + y;
+				bestx = x;
+			}
+		}
+
+		if ((split->xmid + split->ymid) - (xoff + yoff) <= (xlim + ylim) - best
+		    ) {
+			split->xmid = bestx;
+			split->ymid = best - bestx;
+		}
+		return ;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Pair open files by name. Each name is hashed once into a chained table; #*/
+/*# the first two files sharing a name become a pair and any further copies #*/
+/*# are left alone.                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int PairFilenames(EDIT_FILE**files, int numFiles, int*comp1, int*comp2)
+{
+	char*names;
+	int*heads;
+	int*next;
+	int*mate;
+	int i, j, size, bucket, found = 0;
+
+	for (size = 16; size < numFiles*2; size <<= 1)
+		;
+
+	names = (char*)OS_Malloc(numFiles*MAX_FILENAME);
+	heads = (int*)OS_Malloc(size*sizeof(int));
+	next = (int*)OS_Malloc(numFiles*sizeof(int));
+	mate = (int*)OS_Malloc(numFiles*sizeof(int));
+
+	for (i = 0; i < size; i++)
+		heads[i] = -1;
+
+	for (i = 0; i < numFiles; i++) {
+		mate[i] = -1;
+
+		if (!files[i])
+			continue;
+
+		OS_GetFilename(files[i]->pathname, 0, &names[i*MAX_FILENAME]);
+
+		bucket = (int)(PathHash(&names[i*MAX_FILENAME]) & (size - 1));
+
+		for (j = heads[bucket]; j != -1; j = next[j])
+			if (!OS_Strcasecmp(&names[i*MAX_FILENAME], &names[j*MAX_FILENAME]))
+				break;
+
+		if (j == -1) {
+			next[i] = heads[bucket];
+			heads[bucket] = i;
+		} else
+			if (mate[j] == -1)
+				mate[j] = i;
+	}
+
+	for (i = 0; i < numFiles; i++)
+		if (mate[i] != -1) {
+			comp1[found] = i;
+			comp2[found] = mate[i];
+			found++;
+		}
+
+	OS_Free(names);
+	OS_Free(heads);
+	OS_Free(next);
+	OS_Free(mate);
+
+	return (found);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Diff every pair on the worker pool, then build the merge files in       #*/
+/*# order on this thread. Returns the last merge file created, if any.      #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_FILE*MergePairs(MERGE_JOB*jobs, int numJobs, int*total)
+{
+	EDIT_FILE*newFile, *lastFile = 0;
+	int i;
+
+	aborted = 0;
+	mergeCancel = 0;
+
+	ProgressBar(0, 0, 0);
+
+	for (i = 0; i < numJobs; i++) {
+		jobs[i].single = (numJobs == 1);
+		jobs[i].done = 0;
+	}
+
+	RunTasks((MERGE_TASK_PFN*)MergeTask, jobs, numJobs, numJobs > 1 ?
+	    "Merging" : 0);
+
+	if (mergeCancel)
+		aborted = 1;
+
+	*total = 0;
+
+	for (i = 0; i < numJobs; i++) {
+		newFile = CreateMergeFile(&jobs[i]);
+
+		if (newFile) {
+			lastFile = newFile;
+			(*total)++;
+		}
+	}
+
+	return (lastFile);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void MergeTask(MERGE_JOB*jobs, int index, int poll)
+{
+	MERGE_JOB*job = &jobs[index];
+	EDIT_LINE_HASH*hash1;
+	EDIT_LINE_HASH*hash2;
+
+	if (poll)
+		poll = job->single ? DIFF_POLL_ABORT | DIFF_POLL_PROGRESS :
+		    DIFF_POLL_ABORT;
+
+	poll |= DIFF_POLL_CANCEL;
+
+	if (job->file1->hexMode) {
+		job->done = DiffBytes(&job->binary, job->file1->hexData, job->file1->
+		    number_lines, job->file2->hexData, job->file2->number_lines, poll);
+
+		if (!job->done)
+			FreeBytes(&job->binary);
+
+		return ;
+	}
+
+	hash1 = AllocLineHash(job->file1);
+	hash2 = AllocLineHash(job->file2);
+
+	HashLines(hash1, job->file1->number_lines, hash2, job->file2->number_lines,
+	    job->single);
+
+	job->done = DiffLines(&job->diff, hash1, job->file1->number_lines, hash2,
+	    job->file2->number_lines, poll);
+
+	if (!job->done)
+		FreeDiff(&job->diff);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_FILE*CreateMergeFile(MERGE_JOB*job)
+{
+	MERGE_DIFF*diff = &job->diff;
+	EDIT_FILE*file1 = job->file1;
+	EDIT_FILE*file2 = job->file2;
+	EDIT_FILE*newFile;
+	EDIT_LINE*newLine;
+	int file1_line_num, file2_line_num, start1, start2, i, deltas = 0;
+
+	if (!job->done)
+		return (0);
+
+	if (file1->hexMode)
+		return (CreateHexMergeFile(job));
+
+	file1_line_num = 0;
+	file2_line_num = 0;
+
+	newFile = AllocMergeFile(file1, file2);
+	newLine = newFile->lines;
+
+	while (file1_line_num < file1->number_lines || file2_line_num <
+	    file2->number_lines) {
+		if (file1_line_num < file1->number_lines && file2_line_num <
+		    file2->number_lines && !diff->changed1[file1_line_num] &&
+		    !diff->changed2[file2_line_num]) {
+			newLine = AddFileLine(newFile, newLine,
+			    diff->hash1[file1_line_num].line->line, diff->hash1[
+			    file1_line_num].line->len, 0);
+
+			file1_line_num++;
+			file2_line_num++;
+			continue;
+		}
+
+		/* One hunk: the file1 side, then the file2 side */
+		start1 = file1_line_num;
+		start2 = file2_line_num;
+
+		while (file1_line_num < file1->number_lines &&
+		    diff->changed1[file1_line_num])
+			file1_line_num++;
+
+		while (file2_line_num < file2->number_lines &&
+		    diff->changed2[file2_line_num])
+			file2_line_num++;
+
+		if (start1 < file1_line_num)
+			AddBookmark(newFile, newLine, 0, 0);
+
+		for (i = start1; i < file1_line_num; i++) {
+			newLine = AddFileLine(newFile, newLine, diff->hash1[i].line->line,
+			    diff->hash1[i].line->len, LINE_FLAG_DIFF1);
+
+			deltas = 1;
+		}
+
+		if (start2 < file2_line_num)
+			AddBookmark(newFile, newLine, 0, 0);
+
+		for (i = start2; i < file2_line_num; i++) {
+			newLine = AddFileLine(newFile, newLine, diff->hash2[i].line->line,
+			    diff->hash2[i].line->len, LINE_FLAG_DIFF2);
+
+			deltas = 1;
+		}
+	}
+
+	FreeDiff(diff);
+
+	/* Don't create a delta file if the files are the same. */
+	if (!deltas) {
+		DeallocFile(newFile);
+		return (0);
+	}
+
+	InitDisplayFile(newFile);
+	InitCursorFile(newFile);
+
+	newFile->colorize = ConfigColorize(newFile, file1->pathname);
+
+	newFile->file_flags |= FILE_FLAG_MERGED;
+
+	AddFile(newFile, ADD_FILE_TOP);
+	AddLineCallback(newFile, (LINE_PFN*)MergeLineHandler,
+	    LINE_OP_GETTING_FOCUS | LINE_OP_EDIT | LINE_OP_DELETE | LINE_OP_INSERT);
+
+	return (newFile);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Lay out a binary compare as a text merge file. Matching ranges become   #*/
+/*# a single summary line and each hunk is a hex dump of the file1 bytes    #*/
+/*# then the file2 bytes, so bookmarks and the word highlighting apply.     #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_FILE*CreateHexMergeFile(MERGE_JOB*job)
+{
+	MERGE_BINARY*binary = &job->binary;
+	EDIT_FILE*file1 = job->file1;
+	EDIT_FILE*file2 = job->file2;
+	EDIT_FILE*newFile;
+	EDIT_LINE*newLine;
+	MERGE_MATCH*match;
+	long offset1 = 0, offset2 = 0, next1, next2;
+	int i, len, deltas = 0;
+	char text[128];
+
+	newFile = AllocMergeFile(file1, file2);
+	newLine = newFile->lines;
+
+	for (i = 0; i <= binary->numMatches; i++) {
+		if (i < binary->numMatches) {
+			next1 = binary->matches[i].offset1;
+			next2 = binary->matches[i].offset2;
+		} else {
+			next1 = file1->number_lines;
+			next2 = file2->number_lines;
+		}
+
+		if (offset1 < next1) {
+			AddBookmark(newFile, newLine, 0, 0);
+			newLine = AddHexRows(newFile, newLine, file1->hexData, offset1,
+			    next1 - offset1, LINE_FLAG_DIFF1);
+			deltas = 1;
+		}
+
+		if (offset2 < next2) {
+			AddBookmark(newFile, newLine, 0, 0);
+			newLine = AddHexRows(newFile, newLine, file2->hexData, offset2,
+			    next2 - offset2, LINE_FLAG_DIFF2);
+			deltas = 1;
+		}
+
+		if (i == binary->numMatches)
+			break;
+
+		match = &binary->matches[i];
+
+		if (match->offset1 == match->offset2)
+			len = sprintf(text, "0x%08lx: %ld bytes match", (unsigned long)
+			    match->offset1, match->len);
+		else
+			len = sprintf(text, "0x%08lx: %ld bytes match at 0x%08lx",
+			    (unsigned long)match->offset1, match->len, (unsigned long)
+			    match->offset2);
+
+		newLine = AddFileLine(newFile, newLine, text, len, 0);
+
+		offset1 = match->offset1 + match->len;
+		offset2 = match->offset2 + match->len;
+	}
+
+	FreeBytes(binary);
+
+	if (!deltas) {
+		DeallocFile(newFile);
+		return (0);
+	}
+
+	InitDisplayFile(newFile);
+	InitCursorFile(newFile);
+
+	newFile->file_flags |= FILE_FLAG_MERGED;
+
+	AddFile(newFile, ADD_FILE_TOP);
+	AddLineCallback(newFile, (LINE_PFN*)MergeLineHandler,
+	    LINE_OP_GETTING_FOCUS | LINE_OP_EDIT | LINE_OP_DELETE | LINE_OP_INSERT);
+
+	return (newFile);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_FILE*AllocMergeFile(EDIT_FILE*file1, EDIT_FILE*file2)
+{
+	char newFilename[MAX_FILENAME*2];
+	EDIT_FILE*newFile;
+
+	sprintf(newFilename, "%s.dif", file1->pathname);
+
+	newFile = AllocFile(newFilename);
+
+	newFile->diff1_filename = OS_Malloc(strlen(file1->pathname) + 1);
+	strcpy(newFile->diff1_filename, file1->pathname);
+
+	newFile->diff2_filename = OS_Malloc(strlen(file2->pathname) + 1);
+	strcpy(newFile->diff2_filename, file2->pathname);
+
+	return (newFile);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Dump len bytes from offset in the same layout as the hex view. Long     #*/
+/*# ranges are cut short with a line giving the number of bytes left.       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_LINE*AddHexRows(EDIT_FILE*file, EDIT_LINE*line, char*data, long
+    offset, long len, int flags)
+{
+	unsigned char*bytes = (unsigned char*)data;
+	char*text;
+	int columns, rows, i, count, pos;
+
+	columns = GetConfigInt(CONFIG_INT_HEX_COLS);
+
+	text = OS_Malloc(32 + columns*4);
+
+	for (rows = 0; len > 0 && rows < MERGE_HEX_ROWS; rows++) {
+		count = (int)MIN(len, (long)columns);
+
+		pos = sprintf(text, "0x%08lx: ", (unsigned long)offset);
+
+		for (i = 0; i < columns; i++)
+			if (i < count)
+				pos += sprintf(&text[pos], "%02x ", bytes[offset + i]);
+			else
+				pos += sprintf(&text[pos], "   ");
+
+		for (i = 0; i < count; i++)
+			text[pos++] = (bytes[offset + i] >= 32 && bytes[offset + i] < 127) ?
+			    (char)bytes[offset + i] : '.';
+
+		line = AddFileLine(file, line, text, pos, flags);
+
+		offset += count;
+		len -= count;
+	}
+
+	if (len > 0) {
+		pos = sprintf(text, "0x%08lx: %ld more bytes", (unsigned long)offset,
+		    len);
+		line = AddFileLine(file, line, text, pos, flags);
+	}
+
+	OS_Free(text);
+
+	return (line);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Run pfn over every task on a pool of worker threads. This thread takes  #*/
+/*# tasks too and is the only one that polls for ESC and paints progress;   #*/
+/*# the workers stop picking up tasks once the merge is cancelled.          #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void RunTasks(MERGE_TASK_PFN*pfn, void*tasks, int numTasks,
+    char*progress)
+{
+	OS_THREAD*threads[MERGE_MAX_THREADS];
+	MERGE_POOL pool;
+	int i, index, numThreads;
+
+	pool.pfn = pfn;
+	pool.tasks = tasks;
+	pool.numTasks = numTasks;
+	pool.next = 0;
+
+	numThreads = MIN(OS_NumProcessors(), numTasks) - 1;
+	numThreads = MIN(numThreads, MERGE_MAX_THREADS);
+
+	if (numThreads > 0)
+		mergeLock = OS_CreateMutex();
+
+	for (i = 0; i < numThreads; i++) {
+		threads[i] = OS_CreateThread((OS_THREAD_PFN*)PoolWorker, &pool);
+
+		if (!threads[i])
+			break;
+	}
+
+	numThreads = i;
+
+	while ((index = NextTask(&pool)) >= 0) {
+		pfn(tasks, index, 1);
+
+		if (progress)
+			ProgressBar(progress, index + 1, numTasks);
+
+		if (AbortRequest())
+			CancelMerge();
+	}
+
+	for (i = 0; i < numThreads; i++)
+		OS_JoinThread(threads[i]);
+
+	if (mergeLock) {
+		OS_DestroyMutex(mergeLock);
+		mergeLock = 0;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void PoolWorker(MERGE_POOL*pool)
+{
+	int index;
+
+	while ((index = NextTask(pool)) >= 0)
+		pool->pfn(pool->tasks, index, 0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int NextTask(MERGE_POOL*pool)
+{
+	int index = -1;
+
+	if (mergeLock)
+		OS_LockMutex(mergeLock);
+
+	if (!mergeCancel && pool->next < pool->numTasks)
+		index = pool->next++;
+
+	if (mergeLock)
+		OS_UnlockMutex(mergeLock);
+
+	return (index);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void CancelMerge(void)
+{
+	if (mergeLock)
+		OS_LockMutex(mergeLock);
+
+	mergeCancel = 1;
+
+	if (mergeLock)
+		OS_UnlockMutex(mergeLock);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int MergeCancelled(void)
+{
+	int cancelled;
+
+	if (mergeLock)
+		OS_LockMutex(mergeLock);
+
+	cancelled = mergeCancel;
+
+	if (mergeLock)
+		OS_UnlockMutex(mergeLock);
+
+	return (cancelled);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int MergeLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
+{
+	arg = arg;
+
+	if (op&LINE_OP_GETTING_FOCUS) {
+		if (line->flags&LINE_FLAG_DIFF1)
+			file->title = file->diff1_filename;
+		else
+			if (line->flags&LINE_FLAG_DIFF2)
+				file->title = file->diff2_filename;
+			else
+				file->title = 0;
+	}
+
+	/* Any edit can move the line pairing, so the spans all go */
+	if ((op&(LINE_OP_EDIT | LINE_OP_DELETE | LINE_OP_INSERT)) && file->
+	    diffSpans)
+		ClearLineCache(file->diffSpans);
+
+	return (0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Paint the words that changed within a DIFF1 or DIFF2 line. The line is  #*/
+/*# paired with the line at the same offset in the other half of its hunk,  #*/
+/*# and the word diff is only run the first time either line is painted.    #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void MergeHighlight(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, SCR_PTR
+    *screen, int address, SCR_PTR attr)
+{
+	MERGE_SPANS*entry;
+	EDIT_LINE*mate;
+	int*spans;
+	int*mateSpans;
+	int i, column, end;
+
+	if (!(file->file_flags&FILE_FLAG_MERGED) || !(line->flags&
+	    (LINE_FLAG_DIFF1 | LINE_FLAG_DIFF2)))
+		return ;
+
+	if (!file->diffSpans)
+		file->diffSpans = CreateLineCache(sizeof(MERGE_SPANS), (LINE_CACHE_PFN*)
+		    FreeSpans);
+
+	entry = (MERGE_SPANS*)FindLineEntry(file->diffSpans, line);
+
+	if (!entry || entry->text != line->line || entry->len != line->len) {
+		mate = DiffPartner(line);
+		spans = 0;
+
+		if (mate) {
+			DiffWords(line, mate, &spans, &mateSpans);
+			StoreSpans(file->diffSpans, mate, mateSpans);
+		}
+
+		StoreSpans(file->diffSpans, line, spans);
+		entry = (MERGE_SPANS*)FindLineEntry(file->diffSpans, line);
+	}
+
+	for (i = 0; entry->spans && entry->spans[i] >= 0; i += 2) {
+		column = MAX(entry->spans[i], pan);
+		end = MIN(entry->spans[i + 1], pan + len);
+
+		for (; column < end; column++)
+			screen[address + (column - pan)*2] = attr;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeMergeSpans(EDIT_FILE*file)
+{
+	FreeLineCache(file->diffSpans);
+	file->diffSpans = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void StoreSpans(LINE_CACHE*cache, EDIT_LINE*line, int*spans)
+{
+	MERGE_SPANS*entry;
+
+	entry = (MERGE_SPANS*)AddLineEntry(cache, line);
+
+	if (entry->spans)
+		OS_Free(entry->spans);
+
+	entry->text = line->line;
+	entry->len = line->len;
+	entry->spans = spans;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeSpans(MERGE_SPANS*entry)
+{
+	if (entry->spans)
+		OS_Free(entry->spans);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# A hunk is a run of DIFF1 lines followed by a run of DIFF2 lines. The    #*/
+/*# partner is the line at the same offset in the other run, if it has one. #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_LINE*DiffPartner(EDIT_LINE*line)
+{
+	EDIT_LINE*walk;
+	int index = 0;
+
+	if (line->flags&LINE_FLAG_DIFF1) {
+		for (walk = line; walk->prev && (walk->prev->flags&LINE_FLAG_DIFF1);
+		    walk = walk->prev)
+			index++;
+
+		for (walk = line; walk && (walk->flags&LINE_FLAG_DIFF1); walk =
+		    walk->next)
+			;
+
+		if (!walk || !(walk->flags&LINE_FLAG_DIFF2))
+			return (0);
+	} else {
+		for (walk = line; walk->prev && (walk->prev->flags&LINE_FLAG_DIFF2);
+		    walk = walk->prev)
+			index++;
+
+		walk = walk->prev;
+
+		if (!walk || !(walk->flags&LINE_FLAG_DIFF1))
+			return (0);
+
+		while (walk->prev && (walk->prev->flags&LINE_FLAG_DIFF1))
+			walk = walk->prev;
+	}
+
+	while (index-- && walk->next && (walk->next->flags&walk->flags&
+	    (LINE_FLAG_DIFF1 | LINE_FLAG_DIFF2)))
+		walk = walk->next;
+
+	return (index < 0 ? walk : 0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Diff two lines a word at a time by treating each word as a line, and   #*/
+/*# return the changed columns of each. Unless half of the shorter line is  #*/
+/*# common text the pair is left to the whole line colour.                  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void DiffWords(EDIT_LINE*line1, EDIT_LINE*line2, int**spans1,
+    int**spans2)
+{
+	MERGE_DIFF diff;
+	EDIT_LINE_HASH*hash1;
+	EDIT_LINE_HASH*hash2;
+	EDIT_LINE*words1;
+	EDIT_LINE*words2;
+	int i, numWords1, numWords2, common = 0, text1 = 0, text2 = 0;
+
+	*spans1 = 0;
+	*spans2 = 0;
+
+	words1 = (EDIT_LINE*)OS_Malloc((line1->len + 1)*sizeof(EDIT_LINE));
+	words2 = (EDIT_LINE*)OS_Malloc((line2->len + 1)*sizeof(EDIT_LINE));
+
+	numWords1 = SplitWords(line1, words1);
+	numWords2 = SplitWords(line2, words2);
+
+	hash1 = (EDIT_LINE_HASH*)OS_Malloc((numWords1 + 1)*sizeof(EDIT_LINE_HASH));
+	hash2 = (EDIT_LINE_HASH*)OS_Malloc((numWords2 + 1)*sizeof(EDIT_LINE_HASH));
+
+	for (i = 0; i < numWords1; i++) {
+		hash1[i].line = &words1[i];
+		hash1[i].hash = LineHash(words1[i].line, words1[i].len);
+	}
+
+	for (i = 0; i < numWords2; i++) {
+		hash2[i].line = &words2[i];
+		hash2[i].hash = LineHash(words2[i].line, words2[i].len);
+	}
+
+	DiffLines(&diff, hash1, numWords1, hash2, numWords2, 0);
+
+	/* White space doesn't count towards the lines being alike */
+	for (i = 0; i < numWords1; i++)
+		if ((unsigned char)*words1[i].line > 32) {
+			text1 += words1[i].len;
+
+			if (!diff.changed1[i])
+				common += words1[i].len;
+		}
+
+	for (i = 0; i < numWords2; i++)
+		if ((unsigned char)*words2[i].line > 32)
+			text2 += words2[i].len;
+
+	if (common && common*2 >= MIN(text1, text2)) {
+		*spans1 = ChangedSpans(line1, words1, numWords1, diff.changed1);
+		*spans2 = ChangedSpans(line2, words2, numWords2, diff.changed2);
+	}
+
+	FreeDiff(&diff);
+
+	OS_Free(words1);
+	OS_Free(words2);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# A word is a run of identifier characters, a run of white space, or any  #*/
+/*# other single character.                                                 #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SplitWords(EDIT_LINE*line, EDIT_LINE*words)
+{
+	unsigned char*text = (unsigned char*)line->line;
+	int start, end, numWords = 0;
+
+	for (start = 0; start < line->len; start = end) {
+		end = start + 1;
+
+		if (isalnum(text[start]) || text[start] == '_' || text[start] >= 0x80)
+			while (end < line->len && (isalnum(text[end]) || text[end] == '_'
+			    || text[end] >= 0x80))
+				end++;
+		else
+			if (text[start] <= 32)
+				while (end < line->len && text[end] <= 32)
+					end++;
+
+		words[numWords].line = line->line + start;
+		words[numWords].len = end - start;
+		numWords++;
+	}
+
+	return (numWords);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int*ChangedSpans(EDIT_LINE*line, EDIT_LINE*words, int numWords,
+    char*changed)
+{
+	int*spans;
+	int i, start, numSpans = 0;
+
+	spans = (int*)OS_Malloc((numWords*2 + 1)*sizeof(int));
+
+	for (i = 0; i < numWords; i++) {
+		if (!changed[i])
+			continue;
+
+		start = words[i].line - line->line;
+
+		if (numSpans && spans[numSpans - 1] == start)
+			spans[numSpans - 1] = start + words[i].len;
+		else {
+			spans[numSpans++] = start;
+			spans[numSpans++] = start + words[i].len;
+		}
+	}
+
+	if (!numSpans) {
+		OS_Free(spans);
+		return (0);
+	}
+
+	spans[numSpans] = -1;
+
+	return (spans);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Remember the lines as they are on disk for the change gutter. Called    #*/
+/*# when a file is loaded or saved, while the buffer matches the disk.      #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void ResetChangeGutter(EDIT_FILE*file)
+{
+	MERGE_GUTTER*gutter;
+	GUTTER_SLOT*slot;
+	EDIT_LINE*line;
+	unsigned int size;
+	int index;
+
+	FreeChangeGutter(file);
+
+	if (file->hexMode || (file->file_flags&(FILE_FLAG_NONFILE |
+	    FILE_FLAG_MERGED)))
+		return ;
+
+	gutter = (MERGE_GUTTER*)OS_Malloc(sizeof(MERGE_GUTTER));
+
+	for (gutter->numSaved = 0, line = file->lines; line; line = line->next)
+		gutter->numSaved++;
+
+	for (size = 64; size < (unsigned int)gutter->numSaved*2; size <<= 1)
+		;
+
+	gutter->mask = size - 1;
+	gutter->saved = (unsigned long long*)OS_Malloc(gutter->numSaved*sizeof
+	    (unsigned long long));
+	gutter->slots = (GUTTER_SLOT*)OS_Malloc(size*sizeof(GUTTER_SLOT));
+
+	memset(gutter->slots, 0, size*sizeof(GUTTER_SLOT));
+
+	gutter->marks = 0;
+	gutter->numMarks = 0;
+
+	for (index = 0, line = file->lines; line; line = line->next, index++) {
+		gutter->saved[index] = GutterHash(line);
+
+		slot = FindGutterSlot(gutter, line);
+		slot->line = line;
+		slot->index = index;
+	}
+
+	file->gutter = gutter;
+
+	AddLineCallback(file, (LINE_PFN*)GutterLineHandler, LINE_OP_EDIT |
+	    LINE_OP_DELETE | LINE_OP_INSERT);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeChangeGutter(EDIT_FILE*file)
+{
+	if (!file->gutter)
+		return ;
+
+	OS_Free(file->gutter->saved);
+	OS_Free(file->gutter->slots);
+
+	if (file->gutter->marks)
+		OS_Free(file->gutter->marks);
+
+	OS_Free(file->gutter);
+
+	file->gutter = 0;
+
+	RemoveLineCallback(file, (LINE_PFN*)GutterLineHandler);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Fill marks with how each of rows lines from top, line number number,    #*/
+/*# differs from the disk. The marks are kept for a margin either side of   #*/
+/*# the window until a line changes, so moving the cursor or scrolling      #*/
+/*# just copies them.                                                       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void ChangeGutter(EDIT_FILE*file, EDIT_LINE*top, int number, int rows, char
+    *marks)
+{
+	MERGE_GUTTER*gutter = file->gutter;
+	int before;
+
+	if (!gutter || !top) {
+		memset(marks, 0, rows);
+		return ;
+	}
+
+	if (number < gutter->first || number + rows > gutter->first +
+	    gutter->numMarks) {
+		for (before = 0; before < MERGE_GUTTER_MARGIN && top->prev; before++)
+			top = top->prev;
+
+		if (gutter->marks)
+			OS_Free(gutter->marks);
+
+		gutter->first = number - before;
+		gutter->numMarks = before + rows + MERGE_GUTTER_MARGIN;
+		gutter->marks = (char*)OS_Malloc(gutter->numMarks);
+
+		GutterMarks(gutter, top, gutter->numMarks, gutter->marks);
+	}
+
+	memcpy(marks, gutter->marks + number - gutter->first, rows);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Fill marks with how each of rows lines from top differs from the disk.  #*/
+/*# Unchanged lines still on disk anchor the compare, so only the region    #*/
+/*# between the anchors either side of an edit is diffed, however large    #*/
+/*# the file is.                                                            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void GutterMarks(MERGE_GUTTER*gutter, EDIT_LINE*top, int rows, char
+    *marks)
+{
+	EDIT_LINE*start;
+	EDIT_LINE*end;
+	int saved = -1, next, row, count, reach;
+
+	memset(marks, 0, rows);
+
+	/* Back up to the nearest anchor above the window */
+	row = 0;
+
+	for (start = top; start->prev && row > -MERGE_GUTTER_REACH; row--) {
+		if ((saved = SavedLine(gutter, start->prev, -1)) >= 0)
+			break;
+
+		start = start->prev;
+	}
+
+	/* Too far to know where the window is in the saved file */
+	if (start->prev && saved < 0) {
+		for (start = top, row = 0; start && row < rows; start = start->next,
+		    row++) {
+			if ((saved = SavedLine(gutter, start, -1)) >= 0)
+				break;
+
+			marks[row] = GUTTER_CHANGED;
+		}
+
+		if (!start || row == rows)
+			return ;
+
+		start = start->next;
+		row++;
+	}
+
+	while (row < rows) {
+		/* The region runs to the next anchor after the last one */
+		for (end = start, count = 0, reach = 0; end && reach <
+		    MERGE_GUTTER_REACH; end = end->next, count++, reach++)
+			if ((next = SavedLine(gutter, end, saved)) >= 0)
+				break;
+
+		if (end && reach == MERGE_GUTTER_REACH) {
+			for (; row < rows; row++)
+				if (row >= 0)
+					marks[row] = GUTTER_CHANGED;
+			return ;
+		}
+
+		if (!end)
+			next = gutter->numSaved;
+
+		MarkGutterRegion(gutter, start, count, saved + 1, next - saved - 1,
+		    row, rows, marks);
+
+		if (!end)
+			return ;
+
+		row += count + 1;
+		saved = next;
+		start = end->next;
+
+		if (!start)
+			return ;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int GutterLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
+{
+	GUTTER_SLOT*slot;
+
+	arg = arg;
+
+	if (!file->gutter)
+		return (0);
+
+	/* Any change can move the anchors the kept marks were found from */
+	file->gutter->numMarks = 0;
+
+	/* The line is about to be freed, and a new line may reuse its address */
+	if (op&LINE_OP_DELETE) {
+		slot = FindGutterSlot(file->gutter, line);
+
+		if (slot->line)
+			slot->index = -1;
+	}
+
+	return (0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Open addressed on the line pointer. Returns the line's slot or the      #*/
+/*# empty slot where it would go.                                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static GUTTER_SLOT*FindGutterSlot(MERGE_GUTTER*gutter, EDIT_LINE*line)
+{
+	unsigned int index;
+
+	index = (unsigned int)(((size_t)line/sizeof(EDIT_LINE))*2654435761U);
+
+	for (; ; index++) {
+		index &= gutter->mask;
+
+		if (gutter->slots[index].line == line || !gutter->slots[index].line)
+			return (&gutter->slots[index]);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The saved line number of a line that is unchanged since the save and   #*/
+/*# comes after saved line after, otherwise -1.                            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SavedLine(MERGE_GUTTER*gutter, EDIT_LINE*line, int after)
+{
+	GUTTER_SLOT*slot;
+
+	slot = FindGutterSlot(gutter, line);
+
+	if (!slot->line || slot->index <= after)
+		return (-1);
+
+	if (GutterHash(line) != gutter->saved[slot->index])
+		return (-1);
+
+	return (slot->index);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Diff count lines from start, the first at row, against the numSaved     #*/
+/*# saved lines from saved, and mark the rows inside the window.            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void MarkGutterRegion(MERGE_GUTTER*gutter, EDIT_LINE*start, int count,
+    int saved, int numSaved, int row, int rows, char*marks)
+{
+	MERGE_DIFF diff;
+	EDIT_LINE_HASH*hash1;
+	EDIT_LINE_HASH*hash2;
+	EDIT_LINE*line;
+	int i, j, start1, start2, mark;
+
+	if (!count) {
+		/* Nothing but deleted lines, shown on the anchor below */
+		if (numSaved && row >= 0 && row < rows)
+			marks[row] = GUTTER_DELETED;
+		return ;
+	}
+
+	if (!numSaved || numSaved > MERGE_GUTTER_REACH) {
+		mark = numSaved ? GUTTER_CHANGED : GUTTER_ADDED;
+
+		for (i = 0; i < count && row + i < rows; i++)
+			if (row + i >= 0)
+				marks[row + i] = (char)mark;
+		return ;
+	}
+
+	hash1 = (EDIT_LINE_HASH*)OS_Malloc((count + 1)*sizeof(EDIT_LINE_HASH));
+	hash2 = (EDIT_LINE_HASH*)OS_Malloc((numSaved + 1)*sizeof(EDIT_LINE_HASH));
+
+	for (i = 0, line = start; i < count; i++, line = line->next) {
+		hash1[i].line = line;
+		hash1[i].hash = GutterHash(line);
+	}
+
+	for (j = 0; j < numSaved; j++) {
+		hash2[j].line = 0;
+		hash2[j].hash = gutter->saved[saved + j];
+	}
+
+	DiffLines(&diff, hash1, count, hash2, numSaved, 0);
+
+	for (i = 0, j = 0; i < count || j < numSaved; ) {
+		if (i < count && j < numSaved && !diff.changed1[i] &&
+		    !diff.changed2[j]) {
+			i++;
+			j++;
+			continue;
+		}
+
+		start1 = i;
+		start2 = j;
+
+		while (i < count && diff.changed1[i])
+			i++;
+
+		while (j < numSaved && diff.changed2[j])
+			j++;
+
+		if (start1 == i) {
+			/* Only deleted lines, shown on the line after them */
+			if (row + i >= 0 && row + i < rows)
+				marks[row + i] = GUTTER_DELETED;
+			continue;
+		}
+
+		mark = start2 == j ? GUTTER_ADDED : GUTTER_CHANGED;
+
+		for (; start1 < i; start1++)
+			if (row + start1 >= 0 && row + start1 < rows)
+				marks[row + start1] = (char)mark;
+	}
+
+	FreeDiff(&diff);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Whitespace always counts here, whatever the merge setting.              #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned long long GutterHash(EDIT_LINE*line)
+{
+	unsigned long long hash;
+
+	hash = HashBytes(MERGE_HASH_SEED, line->line, line->len);
+	hash = (hash ^ ((unsigned long long)line->len << 56))*MERGE_HASH_PRIME;
+	hash ^= hash >> 32;
+
+	return (hash);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_LINE_HASH*AllocLineHash(EDIT_FILE*file)
+{
+	EDIT_LINE_HASH*hashTable;
+	EDIT_LINE*line;
+	int index;
+
+	hashTable = (EDIT_LINE_HASH*)
+	OS_Malloc((file->number_lines + 1)*sizeof(EDIT_LINE_HASH));
+
+	memset(hashTable, 0, (file->number_lines + 1)*sizeof(EDIT_LINE_HASH));
+
+	line = file->lines;
+	index = 0;
+
+	while (line) {
+		hashTable[index++].line = line;
+		line = line->next;
+	}
+
+	return (hashTable);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Hash both files, the second one on a worker thread when they are large  #*/
+/*# enough to be worth it and there is a spare processor.                   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void HashLines(EDIT_LINE_HASH*table1, int numLines1,
+    EDIT_LINE_HASH*table2, int numLines2, int threaded)
+{
+	OS_THREAD*thread = 0;
+	HASH_JOB job1, job2;
+
+	job1.table = table1;
+	job1.numLines = numLines1;
+
+	job2.table = table2;
+	job2.numLines = numLines2;
+
+	if (threaded && numLines1 + numLines2 >= MERGE_THREAD_LINES &&
+	    OS_NumProcessors() > 1)
+		thread = OS_CreateThread((OS_THREAD_PFN*)HashWorker, &job2);
+
+	HashWorker(&job1);
+
+	if (thread)
+		OS_JoinThread(thread);
+	else
+		HashWorker(&job2);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void HashWorker(HASH_JOB*job)
+{
+	int i;
+
+	for (i = 0; i < job->numLines && job->table[i].line; i++)
+		job->table[i].hash = LineHash(job->table[i].line->line,
+		    job->table[i].line->len);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# 64 bit line hash. Plain lines are mixed eight bytes at a time; with     #*/
+/*# merge_nows the non-whitespace bytes are packed into words first.        #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned long long LineHash(char*line, int len)
+{
+	unsigned long long hash = MERGE_HASH_SEED, word;
+	int i, bytes = 0, total = 0;
+
+	if (!merge_nows) {
+		hash = HashBytes(hash, line, len);
+		total = len;
+	} else {
+		for (word = 0, i = 0; i < len; i++) {
+			if ((unsigned char)line[i] <= 32)
+				continue;
+
+			word = (word << 8) | (unsigned char)line[i];
+			total++;
+
+			if (++bytes == 8) {
+				hash = (hash ^ word)*MERGE_HASH_PRIME;
+				hash ^= hash >> 29;
+				word = 0;
+				bytes = 0;
+			}
+		}
+
+		if (bytes) {
+			hash = (hash ^ word)*MERGE_HASH_PRIME;
+			hash ^= hash >> 29;
+		}
+	}
+
+	hash = (hash ^ ((unsigned long long)total << 56))*MERGE_HASH_PRIME;
+	hash ^= hash >> 32;
+
+	return (hash);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Mix a block of bytes into hash eight at a time. Hashing a buffer in     #*/
+/*# pieces gives the same result as one call as long as every piece but    #*/
+/*# the last is a multiple of 8 bytes.                                      #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned long long HashBytes(unsigned long long hash, char*data,
+    long len)
+{
+	unsigned long long word;
+	long i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		memcpy(&word, data + i, 8);
+
+		hash = (hash ^ word)*MERGE_HASH_PRIME;
+		hash ^= hash >> 29;
+	}
+
+	if (i < len) {
+		for (word = 0; i < len; i++)
+			word = (word << 8) | (unsigned char)data[i];
+
+		hash = (hash ^ word)*MERGE_HASH_PRIME;
+		hash ^= hash >> 29;
+	}
+
+	return (hash);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Hashes can collide, so equal hashes are confirmed against the bytes     #*/
+/*# (ignoring whitespace when merge_nows is set).                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SameLine(EDIT_LINE_HASH*hash1, EDIT_LINE_HASH*hash2)
+{
+	char*str1, *str2, *end1, *end2;
+
+	if (hash1->hash != hash2->hash)
+		return (0);
+
+	/* Saved lines for the change gutter are only kept as hashes */
+	if (!hash1->line || !hash2->line)
+		return (1);
+
+	if (!merge_nows)
+		return (hash1->line->len == hash2->line->len && !memcmp(hash1->line->
+		    line, hash2->line->line, hash1->line->len));
+
+	str1 = hash1->line->line;
+	str2 = hash2->line->line;
+	end1 = str1 + hash1->line->len;
+	end2 = str2 + hash2->line->len;
+
+	for (; ; ) {
+		while (str1 < end1 && (unsigned char)*str1 <= 32)
+			str1++;
+
+		while (str2 < end2 && (unsigned char)*str2 <= 32)
+			str2++;
+
+		if (str1 == end1 || str2 == end2)
+			return (str1 == end1 && str2 == end2);
+
+		if (*str1++ != *str2++)
+			return (0);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Compare two byte buffers rsync style. File1 is cut into fixed blocks    #*/
+/*# indexed by a polynomial hash, and a rolling hash over file2 looks each  #*/
+/*# window up. A verified block is grown in both directions into a match.   #*/
+/*# The matches ascend in both files, and the gaps between them are the     #*/
+/*# inserted, deleted and changed ranges.                                   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int DiffBytes(MERGE_BINARY*binary, char*data1, long size1, char*data2,
+    long size2, int poll)
+{
+	long start, end1, end2;
+
+	memset(binary, 0, sizeof(MERGE_BINARY));
+
+	binary->data1 = data1;
+	binary->data2 = data2;
+	binary->poll = poll;
+
+	/* Common head and tail bytes never need to be searched */
+	start = 0;
+	end1 = size1;
+	end2 = size2;
+
+	while (start < end1 && start < end2 && data1[start] == data2[start])
+		start++;
+
+	while (end1 > start && end2 > start && data1[end1 - 1] == data2[end2 - 1]) {
+		end1--;
+		end2--;
+	}
+
+	if (start)
+		AddMatch(binary, 0, 0, start);
+
+	if (end1 - start >= MERGE_MIN_BLOCK && end2 - start >= MERGE_MIN_BLOCK) {
+		IndexBlocks(binary, start, end1);
+		MatchBlocks(binary, start, end2);
+
+		OS_Free(binary->blockHash);
+		OS_Free(binary->heads);
+		OS_Free(binary->next);
+	}
+
+	if (end1 < size1)
+		AddMatch(binary, end1, end2, size1 - end1);
+
+	return (!binary->aborted);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeBytes(MERGE_BINARY*binary)
+{
+	if (binary->matches)
+		OS_Free(binary->matches);
+
+	binary->matches = 0;
+	binary->numMatches = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The block size doubles until there are at most MERGE_MAX_BLOCKS blocks. #*/
+/*# Chains run in file order so the earliest block is found first.          #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void IndexBlocks(MERGE_BINARY*binary, long start1, long limit1)
+{
+	unsigned char*data;
+	unsigned long long hash;
+	long i, size, numBlocks;
+	int block, bits;
+
+	binary->start1 = start1;
+	binary->limit1 = limit1;
+
+	for (binary->blockSize = MERGE_MIN_BLOCK; (limit1 - start1)/binary->
+	    blockSize > MERGE_MAX_BLOCKS; binary->blockSize <<= 1)
+		;
+
+	numBlocks = (limit1 - start1)/binary->blockSize;
+
+	for (size = 64, bits = 6; size < numBlocks*2; size <<= 1)
+		bits++;
+
+	binary->shift = 64 - bits;
+
+	binary->blockHash = (unsigned long long*)OS_Malloc(numBlocks*sizeof
+	    (unsigned long long));
+	binary->heads = (int*)OS_Malloc(size*sizeof(int));
+	binary->next = (int*)OS_Malloc(numBlocks*sizeof(int));
+
+	for (i = 0; i < size; i++)
+		binary->heads[i] = -1;
+
+	for (block = (int)numBlocks - 1; block >= 0; block--) {
+		data = (unsigned char*)binary->data1 + start1 + block*binary->
+		    blockSize;
+
+		for (hash = 0, i = 0; i < binary->blockSize; i++)
+			hash = hash*MERGE_HASH_PRIME + data[i];
+
+		binary->blockHash[block] = hash;
+		binary->next[block] = binary->heads[hash >> binary->shift];
+		binary->heads[hash >> binary->shift] = block;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Roll a block sized window over file2. The window is first tried on the  #*/
+/*# diagonal of the last match, which keeps runs of changed bytes and fill  #*/
+/*# patterns in step, and otherwise looked up in the block index.           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void MatchBlocks(MERGE_BINARY*binary, long start2, long limit2)
+{
+	unsigned char*data1 = (unsigned char*)binary->data1;
+	unsigned char*data2 = (unsigned char*)binary->data2;
+	unsigned long long hash = 0, power = 1;
+	long blockSize = binary->blockSize;
+	long end1, end2, offset1, offset2, expected, len, i;
+	int rolling = 0;
+
+	for (i = 1; i < blockSize; i++)
+		power *= MERGE_HASH_PRIME;
+
+	end1 = binary->start1;
+	end2 = start2;
+
+	for (offset2 = start2; offset2 + blockSize <= limit2; ) {
+		if (!rolling) {
+			for (hash = 0, i = 0; i < blockSize; i++)
+				hash = hash*MERGE_HASH_PRIME + data2[offset2 + i];
+
+			rolling = 1;
+		}
+
+		expected = end1 + (offset2 - end2);
+
+		if (expected + blockSize <= binary->limit1 && data1[expected] ==
+		    data2[offset2] && !memcmp(&data1[expected], &data2[offset2],
+		    blockSize))
+			offset1 = expected;
+		else
+			offset1 = FindBlock(binary, hash, (char*)&data2[offset2], end1,
+			    expected);
+
+		if (offset1 >= 0) {
+			while (offset1 > end1 && offset2 > end2 && data1[offset1 - 1] ==
+			    data2[offset2 - 1]) {
+				offset1--;
+				offset2--;
+			}
+
+			for (len = 0; offset1 + len < binary->limit1 && offset2 + len <
+			    limit2 && data1[offset1 + len] == data2[offset2 + len]; )
+				len++;
+
+			AddMatch(binary, offset1, offset2, len);
+
+			end1 = offset1 + len;
+			end2 = offset2 + len;
+			offset2 = end2;
+			rolling = 0;
+
+			binary->work += len/blockSize;
+		} else {
+			if (offset2 + blockSize < limit2)
+				hash = (hash - data2[offset2]*power)*MERGE_HASH_PRIME + data2[
+				    offset2 + blockSize];
+
+			offset2++;
+			binary->work++;
+		}
+
+		if (binary->work >= MERGE_ABORT_WORK) {
+			binary->work = 0;
+
+			if (binary->poll&DIFF_POLL_PROGRESS)
+				ProgressBar("Comparing", (int)((offset2 - start2) >> 10), (int)
+				    ((limit2 - start2) >> 10));
+
+			if ((binary->poll&DIFF_POLL_ABORT) && AbortRequest())
+				CancelMerge();
+
+			if ((binary->poll&DIFF_POLL_CANCEL) && MergeCancelled()) {
+				binary->aborted = 1;
+				return ;
+			}
+		}
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Of the blocks at or after end1 that match data, return the offset of    #*/
+/*# the one nearest the expected offset, or -1.                             #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static long FindBlock(MERGE_BINARY*binary, unsigned long long hash, char*data,
+    long end1, long expected)
+{
+	long offset, best = -1, distance, bestDistance = 0;
+	int block, tries;
+
+	block = binary->heads[hash >> binary->shift];
+
+	for (tries = 0; block >= 0 && tries < MERGE_BLOCK_CHAIN; tries++, block =
+	    binary->next[block]) {
+		offset = binary->start1 + block*binary->blockSize;
+
+		if (binary->blockHash[block] != hash || offset < end1)
+			continue;
+
+		if (memcmp(&binary->data1[offset], data, binary->blockSize))
+			continue;
+
+		distance = offset > expected ? offset - expected : expected - offset;
+
+		if (best < 0 || distance < bestDistance) {
+			best = offset;
+			bestDistance = distance;
+		}
+	}
+
+	return (best);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AddMatch(MERGE_BINARY*binary, long offset1, long offset2, long
+    len)
+{
+	MERGE_MATCH*matches;
+	MERGE_MATCH*last;
+
+	if (binary->numMatches) {
+		last = &binary->matches[binary->numMatches - 1];
+
+		if (last->offset1 + last->len == offset1 && last->offset2 + last->len
+		    == offset2) {
+			last->len += len;
+			return ;
+		}
+	}
+
+	if (binary->numMatches == binary->maxMatches) {
+		binary->maxMatches = binary->maxMatches ? binary->maxMatches*2 : 64;
+
+		matches = (MERGE_MATCH*)OS_Malloc(binary->maxMatches*sizeof
+		    (MERGE_MATCH));
+
+		if (binary->matches) {
+			memcpy(matches, binary->matches, binary->numMatches*sizeof
+			    (MERGE_MATCH));
+			OS_Free(binary->matches);
+		}
+
+		binary->matches = matches;
+	}
+
+	binary->matches[binary->numMatches].offset1 = offset1;
+	binary->matches[binary->numMatches].offset2 = offset2;
+	binary->matches[binary->numMatches].len = len;
+	binary->numMatches++;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Case folded FNV-1a, matching the case insensitive name compares used    #*/
+/*# when pairing files.                                                     #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned long PathHash(char*path)
+{
+	unsigned long hash = 2166136261UL;
+
+	while (*path)
+		hash = (hash ^ (unsigned long)tolower((unsigned char)*path++))*
+		    16777619UL;
+
+	return (hash);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int OpenTree(MERGE_TREE*tree, char*dir)
+{
+	int len;
+
+	if (!OS_GetFullPathname(dir, tree->root, MAX_FILENAME))
+		return (0);
+
+	len = strlen(tree->root);
+
+	while (len > 1 && (tree->root[len - 1] == '/' || tree->root[len - 1] ==
+	    '\\'))
+		tree->root[--len] = 0;
+
+	return (ReadTree(tree, ""));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int ReadTree(MERGE_TREE*tree, char*relPath)
+{
+	char path[MAX_FILENAME];
+	OS_DIR_ENTRY entry;
+	OS_DIR*dir;
+	char**subdirs = 0;
+	char**grown;
+	int i, numSubdirs = 0, maxSubdirs = 0;
+
+	if (*relPath) {
+		if (strlen(tree->root) + strlen(relPath) + 2 > MAX_FILENAME)
+			return (0);
+
+		OS_JoinPath(path, tree->root, relPath);
+		dir = OS_OpenDir(path);
+	} else
+		dir = OS_OpenDir(tree->root);
+
+	if (!dir)
+		return (0);
+
+	while (OS_ReadDir(dir, &entry)) {
+		/* Links are left out, so a compare never loops or pairs a file */
+		/* with itself through a second path.                           */
+		if (entry.link)
+			continue;
+
+		if (strlen(relPath) + strlen(entry.name) + 2 > MAX_FILENAME)
+			continue;
+
+		if (*relPath)
+			OS_JoinPath(path, relPath, entry.name);
+		else
+			strcpy(path, entry.name);
+
+		if (entry.file_type == FILE_TYPE_DIR) {
+			if (numSubdirs == maxSubdirs) {
+				maxSubdirs = maxSubdirs ? maxSubdirs*2 : 16;
+
+				grown = (char**)OS_Malloc(maxSubdirs*sizeof(char*));
+
+				if (subdirs) {
+					memcpy(grown, subdirs, numSubdirs*sizeof(char*));
+					OS_Free(subdirs);
+				}
+
+				subdirs = grown;
+			}
+
+			subdirs[numSubdirs] = OS_Malloc(strlen(path) + 1);
+			strcpy(subdirs[numSubdirs++], path);
+		} else
+			if (OS_DirEntryInfo(dir, &entry))
+				AddTreeFile(tree, path, entry.fileSize);
+	}
+
+	/* Close before descending so a deep tree holds one descriptor. */
+	OS_CloseDir(dir);
+
+	for (i = 0; i < numSubdirs; i++) {
+		ReadTree(tree, subdirs[i]);
+		OS_Free(subdirs[i]);
+	}
+
+	if (subdirs)
+		OS_Free(subdirs);
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AddTreeFile(MERGE_TREE*tree, char*relPath, long size)
+{
+	TREE_FILE*files;
+	TREE_FILE*entry;
+
+	if (tree->numFiles == tree->maxFiles) {
+		tree->maxFiles = tree->maxFiles ? tree->maxFiles*2 : 256;
+
+		files = (TREE_FILE*)OS_Malloc(tree->maxFiles*sizeof(TREE_FILE));
+
+		if (tree->files) {
+			memcpy(files, tree->files, tree->numFiles*sizeof(TREE_FILE));
+			OS_Free(tree->files);
+		}
+
+		tree->files = files;
+	}
+
+	entry = &tree->files[tree->numFiles++];
+
+	entry->path = OS_Malloc(strlen(relPath) + 1);
+	strcpy(entry->path, relPath);
+
+	entry->size = size;
+	entry->hash = 0;
+	entry->mate = -1;
+	entry->next = -1;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeTree(MERGE_TREE*tree)
+{
+	int i;
+
+	for (i = 0; i < tree->numFiles; i++)
+		OS_Free(tree->files[i].path);
+
+	if (tree->files)
+		OS_Free(tree->files);
+
+	tree->files = 0;
+	tree->numFiles = 0;
+	tree->maxFiles = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Match up files with the same relative path through a hash table over    #*/
+/*# the second tree. Returns the number of pairs.                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int PairTrees(MERGE_TREE*tree1, MERGE_TREE*tree2)
+{
+	int*heads;
+	int i, j, size, bucket, numPairs = 0;
+
+	for (size = 64; size < tree2->numFiles*2; size <<= 1)
+		;
+
+	heads = (int*)OS_Malloc(size*sizeof(int));
+
+	for (i = 0; i < size; i++)
+		heads[i] = -1;
+
+	for (i = 0; i < tree2->numFiles; i++) {
+		bucket = (int)(PathHash(tree2->files[i].path) & (size - 1));
+
+		tree2->files[i].next = heads[bucket];
+		heads[bucket] = i;
+	}
+
+	for (i = 0; i < tree1->numFiles; i++) {
+		bucket = (int)(PathHash(tree1->files[i].path) & (size - 1));
+
+		for (j = heads[bucket]; j != -1; j = tree2->files[j].next)
+			if (tree2->files[j].mate == -1 && !OS_Strcasecmp(tree1->files[i].
+			    path, tree2->files[j].path))
+				break;
+
+		if (j != -1) {
+			tree1->files[i].mate = j;
+			tree2->files[j].mate = i;
+			numPairs++;
+		}
+	}
+
+	OS_Free(heads);
+
+	return (numPairs);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void TreeHashTask(TREE_HASH_JOB*job, int index, int poll)
+{
+	TREE_FILE*file1;
+	TREE_FILE*file2;
+
+	poll = poll;
+
+	file1 = &job->tree1->files[job->pairs[index]];
+	file2 = &job->tree2->files[file1->mate];
+
+	/* A file that can't be read is always reported as different */
+	if (!HashFile(job->tree1->root, file1->path, file1->size, &file1->hash) ||
+	    !HashFile(job->tree2->root, file2->path, file2->size, &file2->hash)) {
+		file1->hash = 0;
+		file2->hash = 1;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int HashFile(char*root, char*path, long size, unsigned long long*hash)
+{
+	char pathname[MAX_FILENAME*2];
+	FILE_HANDLE*fp;
+	char*data;
+	long offset, chunk;
+
+	OS_JoinPath(pathname, root, path);
+
+	fp = OS_Open(pathname, "rb");
+
+	if (!fp)
+		return (0);
+
+	*hash = MERGE_HASH_SEED;
+
+	data = size > MERGE_READ_CHUNK ? OS_MapFile(fp, size) : 0;
+
+	if (data) {
+		*hash = HashBytes(*hash, data, size);
+		OS_UnmapFile(data, size);
+	} else {
+		data = OS_Malloc(MERGE_READ_CHUNK);
+
+		for (offset = 0; offset < size; offset += chunk) {
+			chunk = MIN(size - offset, MERGE_READ_CHUNK);
+
+			if (!OS_Read(data, chunk, 1, fp))
+				break;
+
+			*hash = HashBytes(*hash, data, chunk);
+		}
+
+		OS_Free(data);
+
+		if (offset < size) {
+			OS_Close(fp);
+			return (0);
+		}
+	}
+
+	OS_Close(fp);
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static EDIT_FILE*LoadTreeFile(EDIT_FILE*current, char*root, char*path)
+{
+	char pathname[MAX_FILENAME*2];
+	char fullpath[MAX_FILENAME];
+
+	OS_JoinPath(pathname, root, path);
+
+	if (strlen(pathname) >= MAX_FILENAME)
+		return (0);
+
+	LoadFileWildcard(current, pathname, LOAD_FILE_EXISTS |
+	    LOAD_FILE_NOWILDCARD | LOAD_FILE_NOPAINT | LOAD_FILE_INTERACTIVE);
+
+	if (!OS_GetFullPathname(pathname, fullpath, MAX_FILENAME))
+		return (0);
+
+	return (FileAlreadyLoaded(fullpath));
 }
 
 
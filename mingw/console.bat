@@ -1,3 +1,3 @@
 path=c:\MinGW\bin;%PATH%
-gcc -DWIN32_CONSOLE -DOS_DAEMONIZE -ope.exe ..\utility.c ..\spell.c ..\shell.c ..\checkout.c ..\find.c ..\errors.c ..\match.c ..\stubs.c ..\adrian_cstyle.c ..\wordwrap.c ..\indenting.c ..\bsd_cstyle.c ..\proedit.c win32_console.c win32.c ..\file.c ..\display.c ..\block.c ..\clip.c ..\undo.c ..\input.c ..\cursor.c ..\edit.c ..\search.c ..\goto.c ..\merge.c ..\history.c ..\browse.c ..\calc.c ..\select.c ..\help.c ..\memory.c ..\config.c ..\picklist.c ..\operation.c ..\cstyle.c ..\tabs.c ..\hex.c ..\session.c ..\colorize.c ..\color_c.c ..\color_v.c ..\color_cs.c ..\color_html.c ..\sun_cstyle.c ..\macro.c ..\bookmarks.c
-gcc -DWIN32_CONSOLE -orgrep.exe ..\rgrep.c ..\memory.c win32_console.c win32.c
+gcc -DWIN32_CONSOLE -DOS_DAEMONIZE -ope.exe ..\utility.c ..\spell.c ..\shell.c ..\checkout.c ..\find.c ..\errors.c ..\match.c ..\stubs.c ..\adrian_cstyle.c ..\wordwrap.c ..\indenting.c ..\bsd_cstyle.c ..\proedit.c win32_console.c win32.c ..\file.c ..\display.c ..\block.c ..\clip.c ..\undo.c ..\input.c ..\cursor.c ..\edit.c ..\search.c ..\trigram.c ..\goto.c ..\merge.c ..\history.c ..\browse.c ..\calc.c ..\select.c ..\help.c ..\memory.c ..\config.c ..\picklist.c ..\operation.c ..\cstyle.c ..\tabs.c ..\utf8.c ..\linecache.c ..\hex.c ..\session.c ..\colorize.c ..\lexer.c ..\color_c.c ..\color_v.c ..\color_cs.c ..\color_html.c ..\sun_cstyle.c ..\macro.c ..\bookmarks.c
+gcc -DWIN32_CONSOLE -orgrep.exe ..\rgrep.c ..\trigram.c ..\multisearch.c ..\memory.c win32_console.c win32.c
@@ -50,6 +50,8 @@ static void   SaveScreen(void);
 static void   RestoreScreen(void);
 static int    ProcessKey(INPUT_RECORD *in, int *mode);
 static int    ProcessMouse(INPUT_RECORD *in, OS_MOUSE *mouse);
+static int    ReadInput(INPUT_RECORD *in);
+static int    TranslateInput(INPUT_RECORD *in, int *mode, OS_MOUSE *mouse);
 static int    ProcessALTKey(int ch);
 static int    ProcessCTRLKey(int ch);
 static int    CheckWildcard(char *filename);
@@ -74,6 +76,10 @@ static int            screen_x;
 static int            screen_y;
 static int            screen_setup;
 
+/* A record read by OS_InputPending that OS_GetKey has not returned yet */
+static INPUT_RECORD   aheadRecord;
+static int            ahead;
+
 extern int nospawn;
 
 /*###########################################################################*/
@@ -472,6 +478,96 @@ SMALL_RECT rcl;
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Write just the rows the editor says have changed, one call for each     #*/
+/*# run of adjacent rows.                                                   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PaintRows(char *buffer, int *rows, int numRows)
+{
+COORD dim,pos;
+SMALL_RECT rcl;
+int i,end;
+
+   dim.X=screenXD;
+   dim.Y=screenYD;
+
+   for (i=0; i < numRows; i=end)
+      {
+      for (end=i+1; end < numRows && rows[end] == rows[end-1]+1; end++)
+         ;
+
+      /* Keep OptimizeScreen from writing these rows again */
+      memcpy(&original[rows[i] * screenXD*SCR_PTR_SIZE],
+             &buffer  [rows[i] * screenXD*SCR_PTR_SIZE],
+             (rows[end-1] - rows[i] + 1) * screenXD*SCR_PTR_SIZE);
+
+      pos.X=0;
+      pos.Y=rows[i];
+
+      rcl.Left  =0;
+      rcl.Right =screenXD-1;
+
+      rcl.Top   =rows[i];
+      rcl.Bottom=rows[end-1];
+
+      WriteConsoleOutput(GetStdHandle(STD_OUTPUT_HANDLE),
+         (PCHAR_INFO)buffer,dim,pos, &rcl);
+      }
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Move a block of rows by shift rows (up if positive) inside the console  #*/
+/*# buffer, so only the rows it uncovers have to be written again.          #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_ScrollRows(char *buffer, int x, int y, int columns, int rows, int shift)
+{
+SMALL_RECT rcl;
+CHAR_INFO fill;
+COORD dest;
+int i,from,to,top,count;
+
+   buffer = buffer;
+
+   /* Where the rows that stay in the block land */
+   top  =shift > 0 ? y : y-shift;
+   count=rows-abs(shift);
+
+   rcl.Left  =x;
+   rcl.Right =x+columns-1;
+
+   rcl.Top   =top+shift;
+   rcl.Bottom=top+shift+count-1;
+
+   dest.X=x;
+   dest.Y=top;
+
+   fill.Char.AsciiChar=' ';
+   fill.Attributes    =0;
+
+   if (!ScrollConsoleScreenBuffer(GetStdHandle(STD_OUTPUT_HANDLE),
+          &rcl,NULL,dest,&fill))
+      return(0);
+
+   /* Work away from the edge the rows are moving towards */
+   for (i=0; i < count; i++)
+      {
+      to  =shift > 0 ? y+i : y+rows-1-i;
+      from=to+shift;
+
+      memcpy(&original[(x + to  *screenXD)*SCR_PTR_SIZE],
+             &original[(x + from*screenXD)*SCR_PTR_SIZE],
+             columns*SCR_PTR_SIZE);
+      }
+
+   return(1);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -586,31 +682,103 @@ int OS_Getch(void)
 /*###########################################################################*/
 int OS_PeekKey(int *mode, OS_MOUSE *mouse)
 {
-int ch;
 INPUT_RECORD in;
 DWORD cnt;
 
    *mode=0;
 
+   if (ahead)
+      {
+      ahead=0;
+      return(TranslateInput(&aheadRecord, mode, mouse));
+      }
+
    if (PeekConsoleInput(GetStdHandle(STD_INPUT_HANDLE), &in, 1,&cnt) && cnt)
       {
-      if (ReadConsoleInput(GetStdHandle(STD_INPUT_HANDLE), &in, 1,&cnt) && cnt)
+      if (ReadInput(&in))
+         return(TranslateInput(&in, mode, mouse));
+      }
+
+   return(0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Read ahead through queued records until one of them gives a key. The    #*/
+/*# record is kept for OS_GetKey, so the caller can skip painting while     #*/
+/*# more input is waiting.                                                  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_InputPending(void)
+{
+OS_MOUSE mouse;
+DWORD cnt;
+int mode;
+
+   while (!ahead && PeekConsoleInput(GetStdHandle(STD_INPUT_HANDLE),
+          &aheadRecord, 1,&cnt) && cnt)
+      {
+      if (!ReadInput(&aheadRecord))
+         break;
+
+      memset(&mouse, 0, sizeof(OS_MOUSE));
+      ahead=TranslateInput(&aheadRecord, &mode, &mouse) != 0;
+      }
+
+   return(ahead);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Read one record. A run of mouse moves is read as its last move.         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int ReadInput(INPUT_RECORD *in)
+{
+INPUT_RECORD next;
+DWORD cnt;
+
+   if (!ReadConsoleInput(GetStdHandle(STD_INPUT_HANDLE), in, 1,&cnt) || !cnt)
+      return(0);
+
+   while (in->EventType == MOUSE_EVENT &&
+          in->Event.MouseEvent.dwEventFlags == MOUSE_MOVED)
+      {
+      if (!PeekConsoleInput(GetStdHandle(STD_INPUT_HANDLE), &next, 1,&cnt) ||
+          !cnt)
+         break;
+
+      if (next.EventType != MOUSE_EVENT ||
+          next.Event.MouseEvent.dwEventFlags != MOUSE_MOVED)
+         break;
+
+      ReadConsoleInput(GetStdHandle(STD_INPUT_HANDLE), in, 1,&cnt);
+      }
+
+   return(1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int TranslateInput(INPUT_RECORD *in, int *mode, OS_MOUSE *mouse)
+{
+   if (in->EventType == KEY_EVENT)
+      {
+      *mode=0;
+      return(ProcessKey(in, mode));
+      }
+
+   if (in->EventType == MOUSE_EVENT)
+      {
+      if (ProcessMouse(in, mouse))
          {
-         if (in.EventType == KEY_EVENT)
-            {
-            *mode=0;
-            ch = ProcessKey(&in, mode);
-            return(ch);
-            }
-
-         if (in.EventType == MOUSE_EVENT)
-            {
-            if (ProcessMouse(&in, mouse))
-               {
-               *mode=1;
-               return(ED_KEY_MOUSE);
-               }    
-            }
+         *mode=1;
+         return(ED_KEY_MOUSE);
          }
       }
 
@@ -631,6 +799,12 @@ INPUT_RECORD in;
 DWORD cnt;
 int ch;
 
+   if (ahead)
+      {
+      ahead=0;
+      return(TranslateInput(&aheadRecord, mode, mouse));
+      }
+
    for ( ; ; )
    {
    if (PeekConsoleInput(GetStdHandle(STD_INPUT_HANDLE), &in, 1,&cnt) && !cnt)
@@ -644,24 +818,11 @@ int ch;
          }
       }
 
-   if (ReadConsoleInput(GetStdHandle(STD_INPUT_HANDLE), &in, 1,&cnt) && cnt)
+   if (ReadInput(&in))
       {
-      if (in.EventType == KEY_EVENT)
-         {
-         *mode=0;
-         ch=ProcessKey(&in, mode);
-         if (ch)
-           return(ch);
-         }
-
-      if (in.EventType == MOUSE_EVENT)
-         {
-         if (ProcessMouse(&in, mouse))
-            {
-            *mode=1;
-            return(ED_KEY_MOUSE);
-            }    
-         }
+      ch=TranslateInput(&in, mode, mouse);
+      if (ch)
+        return(ch);
       }
    else
       return(0);
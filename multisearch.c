@@ -0,0 +1,516 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "osdep.h" /* Platform dependent interface */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "multisearch.h"
+
+static void ReleaseAutomaton(MULTI_SEARCH*search);
+static void FindAnchor(MULTI_PATTERN*pattern);
+static int Wildcard(char ch);
+static int FunctionCheck(char ch);
+static void BuildAutomaton(MULTI_SEARCH*search);
+static int VerifyPattern(MULTI_SEARCH*search, MULTI_PATTERN*pattern,
+    char*buffer);
+static void AddHit(MULTI_HITS*hits, long offset, int pattern);
+static int CompareHits(const void*p1, const void*p2);
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+MULTI_SEARCH*CreateMultiSearch(void)
+{
+	MULTI_SEARCH*search;
+
+	search = OS_Malloc(sizeof(MULTI_SEARCH));
+	memset(search, 0, sizeof(MULTI_SEARCH));
+
+	return (search);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeMultiSearch(MULTI_SEARCH*search)
+{
+	int i;
+
+	ReleaseAutomaton(search);
+
+	for (i = 0; i < search->numPatterns; i++)
+		OS_Free(search->patterns[i].text);
+
+	if (search->patterns)
+		OS_Free(search->patterns);
+
+	OS_Free(search);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeMultiHits(MULTI_HITS*hits)
+{
+	if (hits->hits)
+		OS_Free(hits->hits);
+
+	hits->hits = 0;
+	hits->numHits = 0;
+	hits->maxHits = 0;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ReleaseAutomaton(MULTI_SEARCH*search)
+{
+	if (search->next)
+		OS_Free(search->next);
+
+	if (search->output)
+		OS_Free(search->output);
+
+	if (search->outLink)
+		OS_Free(search->outLink);
+
+	if (search->patternNext)
+		OS_Free(search->patternNext);
+
+	if (search->unanchored)
+		OS_Free(search->unanchored);
+
+	search->next = 0;
+	search->output = 0;
+	search->outLink = 0;
+	search->patternNext = 0;
+	search->unanchored = 0;
+	search->numUnanchored = 0;
+	search->numStates = 0;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void AddMultiPattern(MULTI_SEARCH*search, char*pattern)
+{
+	MULTI_PATTERN*patterns;
+	MULTI_PATTERN*add;
+	int i;
+
+	if (!strlen(pattern))
+		return ;
+
+	/* The same pattern twice would only report every hit twice. */
+	for (i = 0; i < search->numPatterns; i++)
+		if (!strcmp(search->patterns[i].text, pattern))
+			return ;
+
+	if (search->numPatterns == search->maxPatterns) {
+		search->maxPatterns += MULTI_PATTERN_CHUNK;
+
+		patterns = OS_Malloc(search->maxPatterns*sizeof(MULTI_PATTERN));
+
+		if (search->patterns) {
+			memcpy(patterns, search->patterns, search->numPatterns*sizeof(
+			    MULTI_PATTERN));
+			OS_Free(search->patterns);
+		}
+
+		search->patterns = patterns;
+	}
+
+	add = &search->patterns[search->numPatterns++];
+
+	add->text = OS_Malloc(strlen(pattern) + 1);
+	strcpy(add->text, pattern);
+	add->len = strlen(pattern);
+
+	FindAnchor(add);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FindAnchor(MULTI_PATTERN*pattern)
+{
+	int i, start = 0;
+
+	pattern->anchor = 0;
+	pattern->anchorLen = 0;
+
+	for (i = 0; i <= pattern->len; i++) {
+		if (i < pattern->len && !Wildcard(pattern->text[i]))
+			continue;
+
+		if (i - start > pattern->anchorLen) {
+			pattern->anchor = start;
+			pattern->anchorLen = i - start;
+		}
+
+		start = i + 1;
+	}
+
+	pattern->literal = pattern->anchorLen == pattern->len;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int Wildcard(char ch)
+{
+	return (ch == '?' || ch == '^');
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int FunctionCheck(char ch)
+{
+	if (ch >= 'a' && ch <= 'z')
+		return (1);
+
+	if (ch >= 'A' && ch <= 'Z')
+		return (1);
+
+	if (ch == '_')
+		return (1);
+
+	if (ch >= '0' && ch <= '9')
+		return (1);
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void CompileMultiSearch(MULTI_SEARCH*search, int ignoreCase)
+{
+	int i, j, total = 1;
+	unsigned char ch;
+
+	ReleaseAutomaton(search);
+
+	search->ignoreCase = ignoreCase;
+
+	for (i = 0; i < 256; i++) {
+		search->fold[i] = (unsigned char)i;
+
+		if (ignoreCase && i >= 'a' && i <= 'z')
+			search->fold[i] = (unsigned char)(i - 32);
+	}
+
+	/* Class 0 stands for every byte no anchor uses. */
+	memset(search->classes, 0, sizeof(search->classes));
+	search->numClasses = 1;
+
+	search->unanchored = OS_Malloc((search->numPatterns + 1)*sizeof(int));
+
+	for (i = 0; i < search->numPatterns; i++) {
+		if (!search->patterns[i].anchorLen) {
+			search->unanchored[search->numUnanchored++] = i;
+			continue;
+		}
+
+		total += search->patterns[i].anchorLen;
+
+		for (j = 0; j < search->patterns[i].anchorLen; j++) {
+			ch = search->fold[(unsigned char)search->patterns[i].text[search->
+			    patterns[i].anchor + j]];
+
+			if (!search->classes[ch])
+				search->classes[ch] = (unsigned char)search->numClasses++;
+		}
+	}
+
+	for (i = 0; i < 256; i++)
+		search->classes[i] = search->classes[search->fold[i]];
+
+	search->next = OS_Malloc(total*search->numClasses*sizeof(int));
+	search->output = OS_Malloc(total*sizeof(int));
+	search->outLink = OS_Malloc(total*sizeof(int));
+	search->patternNext = OS_Malloc((search->numPatterns + 1)*sizeof(int));
+
+	BuildAutomaton(search);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void BuildAutomaton(MULTI_SEARCH*search)
+{
+	MULTI_PATTERN*pattern;
+	int*fail;
+	int*queue;
+	int i, j, c, state, target, head = 0, tail = 0;
+	int numClasses = search->numClasses;
+
+	for (i = 0; i < numClasses; i++)
+		search->next[i] = -1;
+
+	search->output[0] = -1;
+	search->outLink[0] = 0;
+	search->numStates = 1;
+
+	/* Build the trie of anchors. */
+	for (i = 0; i < search->numPatterns; i++) {
+		pattern = &search->patterns[i];
+		search->patternNext[i] = -1;
+
+		if (!pattern->anchorLen)
+			continue;
+
+		state = 0;
+
+		for (j = 0; j < pattern->anchorLen; j++) {
+			c = search->classes[(unsigned char)pattern->text[pattern->anchor + j]];
+			target = search->next[state*numClasses + c];
+
+			if (target < 0) {
+				target = search->numStates++;
+
+				for (c = 0; c < numClasses; c++)
+					search->next[target*numClasses + c] = -1;
+
+				search->output[target] = -1;
+				search->outLink[target] = 0;
+
+				c = search->classes[(unsigned char)pattern->text[pattern->anchor
+				    + j]];
+				search->next[state*numClasses + c] = target;
+			}
+
+			state = target;
+		}
+
+		search->patternNext[i] = search->output[state];
+		search->output[state] = i;
+	}
+
+	fail = OS_Malloc(search->numStates*sizeof(int));
+	queue = OS_Malloc(search->numStates*sizeof(int));
+
+	for (c = 0; c < numClasses; c++) {
+		target = search->next[c];
+
+		if (target < 0)
+			search->next[c] = 0;
+		else {
+			fail[target] = 0;
+			queue[tail++] = target;
+		}
+	}
+
+	/* Breadth first, turning the trie into a full transition table and */
+	/* linking each state to the nearest suffix state with output.       */
+	while (head < tail) {
+		state = queue[head++];
+
+		for (c = 0; c < numClasses; c++) {
+			target = search->next[state*numClasses + c];
+
+			if (target < 0) {
+				search->next[state*numClasses + c] = search->next[fail[state]*
+				    numClasses + c];
+				continue;
+			}
+
+			fail[target] = search->next[fail[state]*numClasses + c];
+
+			if (search->output[fail[target]] >= 0)
+				search->outLink[target] = fail[target];
+			else
+				search->outLink[target] = search->outLink[fail[target]];
+
+			queue[tail++] = target;
+		}
+	}
+
+	OS_Free(queue);
+	OS_Free(fail);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+long MultiSearchBuffer(MULTI_SEARCH*search, MULTI_HITS*hits, char*buffer,
+    long size)
+{
+	MULTI_PATTERN*pattern;
+	long i, start;
+	int state = 0, match, p, j;
+
+	hits->numHits = 0;
+
+	for (i = 0; i < size; i++) {
+		state = search->next[state*search->numClasses + search->classes[
+		    (unsigned char)buffer[i]]];
+
+		match = search->output[state] >= 0 ? state : search->outLink[state];
+
+		for (; match; match = search->outLink[match]) {
+			for (p = search->output[match]; p >= 0; p = search->patternNext[p]) {
+				pattern = &search->patterns[p];
+				start = i - pattern->anchor - pattern->anchorLen + 1;
+
+				if (start < 0 || start + pattern->len > size)
+					continue;
+
+				if (pattern->literal || VerifyPattern(search, pattern, &buffer[
+				    start]))
+					AddHit(hits, start, p);
+			}
+		}
+	}
+
+	/* Patterns made only of wildcards have no anchor to find them by. */
+	for (j = 0; j < search->numUnanchored; j++) {
+		pattern = &search->patterns[search->unanchored[j]];
+
+		for (i = 0; i + pattern->len <= size; i++)
+			if (VerifyPattern(search, pattern, &buffer[i]))
+				AddHit(hits, i, search->unanchored[j]);
+	}
+
+	if (hits->numHits > 1)
+		qsort(hits->hits, hits->numHits, sizeof(MULTI_HIT), CompareHits);
+
+	return (hits->numHits);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int VerifyPattern(MULTI_SEARCH*search, MULTI_PATTERN*pattern,
+    char*buffer)
+{
+	int j;
+	char ch, ch2;
+
+	for (j = 0; j < pattern->len; j++) {
+		ch = buffer[j];
+		ch2 = pattern->text[j];
+
+		if (ch2 == '?')
+			continue;
+
+		// check for identifier
+		if (ch2 == '^' && !FunctionCheck(ch))
+			continue;
+
+		if (search->fold[(unsigned char)ch] != search->fold[(unsigned char)
+		    ch2])
+			return (0);
+	}
+
+	return (1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AddHit(MULTI_HITS*hits, long offset, int pattern)
+{
+	MULTI_HIT*grow;
+
+	if (hits->numHits == hits->maxHits) {
+		hits->maxHits = hits->maxHits ? hits->maxHits*2 : MULTI_HIT_CHUNK;
+
+		grow = OS_Malloc(hits->maxHits*sizeof(MULTI_HIT));
+
+		if (hits->hits) {
+			memcpy(grow, hits->hits, hits->numHits*sizeof(MULTI_HIT));
+			OS_Free(hits->hits);
+		}
+
+		hits->hits = grow;
+	}
+
+	hits->hits[hits->numHits].offset = offset;
+	hits->hits[hits->numHits].pattern = pattern;
+	hits->numHits++;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int CompareHits(const void*p1, const void*p2)
+{
+	const MULTI_HIT*hit1 = (const MULTI_HIT*)p1;
+	const MULTI_HIT*hit2 = (const MULTI_HIT*)p2;
+
+	if (hit1->offset != hit2->offset)
+		return (hit1->offset < hit2->offset ? -1 : 1);
+
+	return (hit1->pattern - hit2->pattern);
+}
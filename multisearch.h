@@ -0,0 +1,90 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __MULTISEARCH_H__
+#define __MULTISEARCH_H__
+
+#define MULTI_PATTERN_CHUNK 32
+#define MULTI_HIT_CHUNK     256
+
+/* Each pattern is found through its longest run of literal characters */
+/* (the anchor); '?' and '^' around the anchor are checked afterwards.   */
+typedef struct multiPattern_t
+{
+	char*text;
+	int len;
+	int anchor;
+	int anchorLen;
+	int literal;
+}MULTI_PATTERN;
+
+typedef struct multiHit_t
+{
+	long offset;
+	int pattern;
+}MULTI_HIT;
+
+/* Hits are kept apart from the automaton so several threads can search */
+/* with one compiled MULTI_SEARCH.                                       */
+typedef struct multiHits_t
+{
+	MULTI_HIT*hits;
+	long numHits;
+	long maxHits;
+}MULTI_HITS;
+
+/* Aho-Corasick automaton over the anchors. Bytes are folded and mapped  */
+/* to classes first, so the transition table is numStates*numClasses.   */
+typedef struct multiSearch_t
+{
+	MULTI_PATTERN*patterns;
+	int numPatterns;
+	int maxPatterns;
+	int ignoreCase;
+	unsigned char fold[256];
+	unsigned char classes[256];
+	int numClasses;
+	int numStates;
+	int*next;
+	int*output;
+	int*outLink;
+	int*patternNext;
+	int*unanchored;
+	int numUnanchored;
+}MULTI_SEARCH;
+
+MULTI_SEARCH*CreateMultiSearch(void);
+void FreeMultiSearch(MULTI_SEARCH*search);
+void AddMultiPattern(MULTI_SEARCH*search, char*pattern);
+void CompileMultiSearch(MULTI_SEARCH*search, int ignoreCase);
+long MultiSearchBuffer(MULTI_SEARCH*search, MULTI_HITS*hits, char*buffer,
+    long size);
+void FreeMultiHits(MULTI_HITS*hits);
+
+#endif /* __MULTISEARCH_H__ */
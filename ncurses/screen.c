@@ -62,6 +62,11 @@ typedef struct PE_KEY_EVENT_T{
 }PE_KEY_EVENT;
 
 static int screenXD, screenYD;
+
+/* A key read by OS_InputPending that OS_GetKey has not returned yet */
+static PE_KEY_EVENT aheadEvent;
+static int ahead;
+
 int OS_GetKey(int*mode, OS_MOUSE*mouse);
 static void OS_Paint_Line(char*buffer, int line);
 static int ProcessEvent(int*mode, PE_KEY_EVENT*ev, OS_MOUSE*mouse);
@@ -82,6 +87,7 @@ int new_term = 0;
 struct termios orig_term;
 
 static int OptimizeScreen(char*new, char*prev, int*y1, int*y2);
+static void PaintCells(char*buffer, int line, int x1, int x2);
 static char*original;
 
 static int cursor_enabled = 0;
@@ -284,6 +290,92 @@ void OS_PaintScreen(char*buffer)
 
 }
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Paint just the rows the editor says have changed.                       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PaintRows(char*buffer, int*rows, int numRows)
+{
+	int i;
+
+	old_buffer = buffer;
+
+	for (i = 0; i < numRows; i++)
+		OS_Paint_Line(buffer, rows[i]);
+
+	show_cursor();
+	wrefresh(stdscr);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Move a block of rows by shift rows (up if positive) with a scroll       #*/
+/*# region, so curses can scroll the terminal instead of writing the rows   #*/
+/*# out again. Curses scrolls whole lines, so the cells either side of the  #*/
+/*# block are put back from buffer afterwards.                              #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_ScrollRows(char*buffer, int x, int y, int columns, int rows, int shift)
+{
+	int i, from, to, size;
+
+	old_buffer = buffer;
+
+	size = screenXD*SCR_PTR_SIZE;
+
+	scrollok(stdscr, TRUE);
+	setscrreg(y, y + rows - 1);
+	scrl(shift);
+	setscrreg(0, screenYD - 1);
+	scrollok(stdscr, FALSE);
+
+	/* Work away from the edge the rows are moving towards */
+	for (i = 0; i < rows; i++) {
+		to = shift > 0 ? y + i : y + rows - 1 - i;
+		from = to + shift;
+
+		if (from >= y && from < y + rows)
+			memcpy(&original[to*size], &original[from*size], size);
+		else
+			memset(&original[to*size], 0, size);
+	}
+
+	for (i = y; i < y + rows; i++) {
+		PaintCells(buffer, i, 0, x - 1);
+		PaintCells(buffer, i, x + columns, screenXD - 1);
+	}
+
+	return (1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Write the cells from x1 to x2 of a row that differ from original.       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void PaintCells(char*buffer, int line, int x1, int x2)
+{
+	int lineAddr;
+	chtype attr;
+
+	for (; x1 <= x2; x1++) {
+		lineAddr = (line*screenXD + x1)*SCR_PTR_SIZE;
+
+		if (original[lineAddr] == buffer[lineAddr] && original[lineAddr + 1] ==
+		    buffer[lineAddr + 1])
+			continue;
+
+		if (!(attr = attr_lut[(unsigned char)buffer[lineAddr + 1]]))
+			attr = setup_color((unsigned char)buffer[lineAddr + 1]);
+
+		mvaddch(line, x1, text_lut[(unsigned char)buffer[lineAddr]] | attr);
+
+		original[lineAddr] = buffer[lineAddr];
+		original[lineAddr + 1] = buffer[lineAddr + 1];
+	}
+}
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -479,6 +571,11 @@ int OS_GetKey(int*mode, OS_MOUSE*mouse)
 	mouse->buttonStatus = 0;
 	mouse->moveStatus = 0;
 
+	if (ahead) {
+		ahead = 0;
+		return (ProcessEvent(mode, &aheadEvent, mouse));
+	}
+
 	for (; ; ) {
 		timeout.tv_sec = 0;
 		timeout.tv_usec = 1000000 / CURSOR_FLASH_PER_SEC;
@@ -516,6 +613,28 @@ int OS_PeekKey(int*mode, OS_MOUSE*mouse)
 	return (0);
 }
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Read ahead through queued keys until one of them means something. The   #*/
+/*# key is kept for OS_GetKey, so the caller can skip painting while more   #*/
+/*# input is waiting.                                                       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_InputPending(void)
+{
+	OS_MOUSE mouse;
+	int mode;
+
+	nodelay(stdscr, TRUE);
+
+	while (!ahead && GetKeyEvent(&aheadEvent, 0))
+		ahead = ProcessEvent(&mode, &aheadEvent, &mouse) != 0;
+
+	nodelay(stdscr, FALSE);
+
+	return (ahead);
+}
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -37,6 +37,7 @@
 #include <string.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <dirent.h>
@@ -45,6 +46,7 @@
 #include <stdarg.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
 #include "../types.h"
 
 extern int nospawn;
@@ -56,11 +58,23 @@ typedef struct exitMessages_t
 	struct exitMessages_t*prev;
 }EXIT_MESSAGE;
 
+typedef struct unixThread_t
+{
+	pthread_t thread;
+	OS_THREAD_PFN*pfn;
+	void*arg;
+}UNIX_THREAD;
+
+typedef struct unixSemaphore_t
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+}UNIX_SEMAPHORE;
+
 static EXIT_MESSAGE*head;
 static EXIT_MESSAGE*tail;
 
-int OS_GetKey(int*mode, OS_MOUSE*mouse);
-
 extern void SetupClipboard(void*reqevent);
 
 static char*clipboardData;
@@ -70,24 +84,13 @@ static int WildcardMatch(char*mask, char*filename);
 static int CheckWildcard(char*filename);
 static void AddMessage(EXIT_MESSAGE*msg);
 static int ValidFile(char*pathname);
+static void*ThreadEntry(void*arg);
 
 CLOCK_PFN*clock_pfn;
 
 
 #define MAX_PATH   512
 
-#define MAX_MACRO_SIZE 16384
-#define RECORD 1
-#define STOP   2
-#define DONE   3
-#define PLAY   4
-
-static long macroIndex = 0, macroSize = 0;
-static int macro = 0;
-
-static char macroBuffer1[MAX_MACRO_SIZE];
-static char macroBuffer2[MAX_MACRO_SIZE];
-
 
 static char*session_filenames[] =
 {
@@ -409,6 +412,21 @@ void OS_Time(char*string)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Milliseconds from an arbitrary start, for timing paints.                #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+unsigned long OS_Clock(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+
+	return ((unsigned long)tv.tv_sec*1000 + tv.tv_usec / 1000);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -430,6 +448,7 @@ int OS_GetFileInfo(char*path, OS_FILE_INFO*info)
 				return (0);
 
 		info->fileSize = filestat.st_size;
+		info->modTime = filestat.st_mtime;
 
 		ptr = ctime(&filestat.st_ctime);
 
@@ -763,24 +782,31 @@ void OS_DosFindEnd(void)
 	}
 }
 
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-void*OS_Malloc(long size)
+OS_DIR*OS_OpenDir(char*path)
 {
-	void*data;
+	int fd;
+	DIR*dirp;
 
-	data = malloc(size);
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
 
-	if (!data) {
-		OS_Printf("ProEdit MP: Out of memory (%d)\n", size);
-		OS_Exit();
+	if (fd < 0)
+		return (0);
+
+	dirp = fdopendir(fd);
+
+	if (!dirp) {
+		close(fd);
+		return (0);
 	}
 
-	return (data);
+	return ((OS_DIR*)dirp);
 }
 
 
@@ -790,82 +816,153 @@ void*OS_Malloc(long size)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-void OS_Free(void*ptr)
+int OS_ReadDir(OS_DIR*dir, OS_DIR_ENTRY*entry)
 {
-	free(ptr);
+	struct dirent*dp;
+	struct stat filestat;
+	int file_type, link;
+
+	for (; ; ) {
+		dp = readdir((DIR*)dir);
+
+		if (!dp)
+			return (0);
+
+		if (!strcmp(dp->d_name, ".") || !strcmp(dp->d_name, ".."))
+			continue;
+
+		if (strlen(dp->d_name) >= OS_MAX_DIR_ENTRY)
+			continue;
+
+		file_type = 0;
+		link = 0;
+
+		switch (dp->d_type) {
+			case DT_DIR :
+				file_type = FILE_TYPE_DIR;
+				break;
+
+			case DT_REG :
+				file_type = FILE_TYPE_FILE;
+				break;
+
+			case DT_LNK :
+				link = 1;
+				break;
+
+			case DT_UNKNOWN :
+				/* Filesystem doesn't report types, fall back to a stat. */
+				if (!fstatat(dirfd((DIR*)dir), dp->d_name, &filestat,
+				    AT_SYMLINK_NOFOLLOW)) {
+					if (S_ISDIR(filestat.st_mode))
+						file_type = FILE_TYPE_DIR;
+					else
+						if (S_ISREG(filestat.st_mode))
+							file_type = FILE_TYPE_FILE;
+						else
+							if (S_ISLNK(filestat.st_mode))
+								link = 1;
+				}
+				break;
+		}
+
+		/* A link takes the type of its target. Dangling links, devices, */
+		/* sockets and fifos are never reported.                         */
+		if (link && !fstatat(dirfd((DIR*)dir), dp->d_name, &filestat, 0)) {
+			if (S_ISDIR(filestat.st_mode))
+				file_type = FILE_TYPE_DIR;
+			else
+				if (S_ISREG(filestat.st_mode))
+					file_type = FILE_TYPE_FILE;
+		}
+
+		if (!file_type)
+			continue;
+
+		strcpy(entry->name, dp->d_name);
+		entry->file_type = file_type;
+		entry->link = link;
+		entry->fileSize = -1;
+		entry->modTime = 0;
+
+		/* The target was just stat'd, and OS_DirEntryInfo() would only */
+		/* see the link itself.                                         */
+		if (link) {
+			entry->fileSize = filestat.st_size;
+			entry->modTime = filestat.st_mtime;
+		}
+
+		return (1);
+	}
 }
 
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-void OS_Printf(char*fmt, ...)
+void OS_CloseDir(OS_DIR*dir)
 {
-	EXIT_MESSAGE*msg;
+	if (dir)
+		closedir((DIR*)dir);
+}
 
-	va_list args;
-	char*buffer;
 
-	buffer = OS_Malloc(1024);
-	va_start(args, fmt);
-	vsprintf(buffer, fmt, args);
-	va_end(args);
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_DirEntryInfo(OS_DIR*dir, OS_DIR_ENTRY*entry)
+{
+	struct stat filestat;
 
-	#if 1
-	msg = (EXIT_MESSAGE*)OS_Malloc(sizeof(EXIT_MESSAGE));
-	msg->next = 0;
-	msg->prev = 0;
-	msg->string = OS_Malloc(strlen(buffer) + 1);
-	strcpy(msg->string, buffer);
+	if (entry->fileSize != -1)
+		return (1);
 
-	OS_Free(buffer);
+	if (fstatat(dirfd((DIR*)dir), entry->name, &filestat,
+	    AT_SYMLINK_NOFOLLOW))
+		return (0);
 
-	AddMessage(msg);
-	#else
-	printf("%s\n", buffer);
-	OS_Free(buffer);
-	#endif
+	entry->fileSize = filestat.st_size;
+	entry->modTime = filestat.st_mtime;
+
+	return (1);
 }
 
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-int OS_DefineMacro(int mode)
+int OS_DirIdentity(OS_DIR*dir, OS_DIR_ID*id)
 {
-	if (mode == -1) {
-		if (macro == RECORD || macro == STOP)
-			return (1);
+	struct stat filestat;
+
+	if (fstat(dirfd((DIR*)dir), &filestat))
 		return (0);
-	}
-	if (mode == 1) {
-		macro = RECORD;
-		macroIndex = 0;
-	}
-	if (mode == 2) {
-		macro = DONE;
-		macroSize = macroIndex;
-		macroIndex = 0;
-	}
-	return (0);
+
+	id->volume = (unsigned long long)filestat.st_dev;
+	id->file = (unsigned long long)filestat.st_ino;
+
+	return (1);
 }
 
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-void OS_PlayMacro(void)
+int OS_WildcardMatch(char*mask, char*filename)
 {
-	if (macro == DONE) {
-		macro = PLAY;
-		macroIndex = 0;
-	}
+	return (WildcardMatch(mask, filename));
 }
 
 /*###########################################################################*/
@@ -874,37 +971,64 @@ void OS_PlayMacro(void)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-int OS_Key(int*mode, OS_MOUSE*mouse)
+void*OS_Malloc(long size)
 {
-	int ch, dontSave = 0;
-
-	if (macro == PLAY) {
-		ch = macroBuffer1[macroIndex];
-		*mode = macroBuffer2[macroIndex];
-		macroIndex++;
+	void*data;
 
-		if (macroIndex >= macroSize)
-			macro = DONE;
+	data = malloc(size);
 
-		return (ch);
+	if (!data) {
+		OS_Printf("ProEdit MP: Out of memory (%d)\n", size);
+		OS_Exit();
 	}
 
-	ch = OS_GetKey(mode, mouse);
+	return (data);
+}
 
-	if (*mode && ch == ED_F1)
-		dontSave = 1; /* Avoid Macros getting into macros */
 
-	if (*mode && ch == ED_F2)
-		dontSave = 1; /* Avoid Macros getting into macros */
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_Free(void*ptr)
+{
+	free(ptr);
+}
 
-	if (macro == RECORD && !dontSave) {
-		macroBuffer1[macroIndex] = ch;
-		macroBuffer2[macroIndex] = *mode;
-		macroIndex++;
-		if (macroIndex >= MAX_MACRO_SIZE)
-			macro = STOP;
-	}
-	return (ch);
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_Printf(char*fmt, ...)
+{
+	EXIT_MESSAGE*msg;
+
+	va_list args;
+	char*buffer;
+
+	buffer = OS_Malloc(1024);
+	va_start(args, fmt);
+	vsprintf(buffer, fmt, args);
+	va_end(args);
+
+	#if 1
+	msg = (EXIT_MESSAGE*)OS_Malloc(sizeof(EXIT_MESSAGE));
+	msg->next = 0;
+	msg->prev = 0;
+	msg->string = OS_Malloc(strlen(buffer) + 1);
+	strcpy(msg->string, buffer);
+
+	OS_Free(buffer);
+
+	AddMessage(msg);
+	#else
+	printf("%s\n", buffer);
+	OS_Free(buffer);
+	#endif
 }
 
 /*###########################################################################*/
@@ -990,6 +1114,230 @@ long OS_Filesize(FILE_HANDLE*fp)
 	return (size);
 }
 
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void*OS_MapFile(FILE_HANDLE*fp, long size)
+{
+	void*data;
+
+	if (size <= 0)
+		return (0);
+
+	data = mmap(0, size, PROT_READ, MAP_PRIVATE, fileno((FILE*)fp), 0);
+
+	if (data == MAP_FAILED)
+		return (0);
+
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	return (data);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_UnmapFile(void*data, long size)
+{
+	if (data)
+		munmap(data, size);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void*ThreadEntry(void*arg)
+{
+	UNIX_THREAD*thread = (UNIX_THREAD*)arg;
+
+	thread->pfn(thread->arg);
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_THREAD*OS_CreateThread(OS_THREAD_PFN*pfn, void*arg)
+{
+	UNIX_THREAD*thread;
+
+	thread = OS_Malloc(sizeof(UNIX_THREAD));
+
+	thread->pfn = pfn;
+	thread->arg = arg;
+
+	if (pthread_create(&thread->thread, 0, ThreadEntry, thread)) {
+		OS_Free(thread);
+		return (0);
+	}
+
+	return (thread);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_JoinThread(OS_THREAD*thread)
+{
+	pthread_join(((UNIX_THREAD*)thread)->thread, 0);
+
+	OS_Free(thread);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_MUTEX*OS_CreateMutex(void)
+{
+	pthread_mutex_t*mutex;
+
+	mutex = OS_Malloc(sizeof(pthread_mutex_t));
+
+	pthread_mutex_init(mutex, 0);
+
+	return (mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_DestroyMutex(OS_MUTEX*mutex)
+{
+	pthread_mutex_destroy((pthread_mutex_t*)mutex);
+
+	OS_Free(mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_LockMutex(OS_MUTEX*mutex)
+{
+	pthread_mutex_lock((pthread_mutex_t*)mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_UnlockMutex(OS_MUTEX*mutex)
+{
+	pthread_mutex_unlock((pthread_mutex_t*)mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_NumProcessors(void)
+{
+	long count;
+
+	count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (count > 0 ? (int)count : 1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_SEMAPHORE*OS_CreateSemaphore(void)
+{
+	UNIX_SEMAPHORE*semaphore;
+
+	semaphore = OS_Malloc(sizeof(UNIX_SEMAPHORE));
+
+	pthread_mutex_init(&semaphore->mutex, 0);
+	pthread_cond_init(&semaphore->cond, 0);
+	semaphore->count = 0;
+
+	return (semaphore);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_DestroySemaphore(OS_SEMAPHORE*semaphore)
+{
+	UNIX_SEMAPHORE*unixSemaphore = (UNIX_SEMAPHORE*)semaphore;
+
+	pthread_cond_destroy(&unixSemaphore->cond);
+	pthread_mutex_destroy(&unixSemaphore->mutex);
+
+	OS_Free(semaphore);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PostSemaphore(OS_SEMAPHORE*semaphore)
+{
+	UNIX_SEMAPHORE*unixSemaphore = (UNIX_SEMAPHORE*)semaphore;
+
+	pthread_mutex_lock(&unixSemaphore->mutex);
+	unixSemaphore->count++;
+	pthread_cond_signal(&unixSemaphore->cond);
+	pthread_mutex_unlock(&unixSemaphore->mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_WaitSemaphore(OS_SEMAPHORE*semaphore)
+{
+	UNIX_SEMAPHORE*unixSemaphore = (UNIX_SEMAPHORE*)semaphore;
+
+	pthread_mutex_lock(&unixSemaphore->mutex);
+
+	while (!unixSemaphore->count)
+		pthread_cond_wait(&unixSemaphore->cond, &unixSemaphore->mutex);
+
+	unixSemaphore->count--;
+	pthread_mutex_unlock(&unixSemaphore->mutex);
+}
+
 /*##########################################################################*/
 /*#                                                                        #*/
 /*#                                                                        #*/
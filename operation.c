@@ -514,11 +514,11 @@ static void CenterJustify(EDIT_FILE*file, int op, EDIT_CLIPBOARD*clipboard)
 	while (walk) {
 		if (walk->len) {
 			for (left = 0; left < walk->len; left++)
-				if (walk->line[left] > 32)
+				if ((unsigned char)walk->line[left] > 32)
 					break;
 
 			for (right = walk->len - 1; right >= 0; right--)
-				if (walk->line[right] > 32)
+				if ((unsigned char)walk->line[right] > 32)
 					break;
 
 			if (left <= right) {
@@ -923,7 +923,7 @@ static void StripAllWhitespace(EDIT_CLIPBOARD*clipboard)
 
 	while (walk) {
 		for (newLen = 0, i = 0; i < walk->len; i++) {
-			if (walk->line[i] <= ED_KEY_SPACE)
+			if ((unsigned char)walk->line[i] <= ED_KEY_SPACE)
 				continue;
 
 			walk->line[newLen++] = walk->line[i];
@@ -1070,7 +1070,7 @@ static void Retabulate(EDIT_CLIPBOARD*clipboard)
 	while (walk) {
 		offset = 0;
 		for (i = 0; i < walk->len; i++) {
-			if (walk->line[i] > ED_KEY_SPACE)
+			if ((unsigned char)walk->line[i] > ED_KEY_SPACE)
 				break;
 			if (walk->line[i] == ED_KEY_TAB)
 				offset += tabsize;
@@ -1142,12 +1142,13 @@ static void ConvertStrings(EDIT_CLIPBOARD*clipboard)
 		newLine[index++] = '"';
 
 		/* Skip trailing space. */
-		while (walk->len && (walk->line[walk->len - 1] <= ED_KEY_SPACE))
+		while (walk->len && ((unsigned char)walk->line[walk->len - 1] <=
+		    ED_KEY_SPACE))
 			walk->len--;
 
 		/* Skip leading space. */
 		for (i = 0; i < walk->len; i++)
-			if (walk->line[i] > ED_KEY_SPACE)
+			if ((unsigned char)walk->line[i] > ED_KEY_SPACE)
 				break;
 
 		for (i = i; i < walk->len; i++) {
@@ -30,7 +30,8 @@
 #ifndef __OSDEP_H__
 #define __OSDEP_H__
 
-#if !defined(WIN32_CONSOLE) && !defined(WIN32_GUI) && !defined(X11_GUI) && !defined(NCURSES)
+#if !defined(WIN32_CONSOLE) && !defined(WIN32_GUI) && !defined(X11_GUI) && \
+    !defined(NCURSES) && !defined(HEADLESS)
 #error You must define WIN32_CONSOLE, WIN32_GUI, or X11_GUI before compiling.
 #endif
 
@@ -50,6 +51,10 @@
 #define SCR_PTR char
 #endif
 
+#ifdef HEADLESS
+#define SCR_PTR char
+#endif
+
 #ifdef WIN32_GUI
 #define _CRT_SECURE_NO_DEPRECATE
 #define SCR_PTR char
@@ -63,6 +68,12 @@
 #define SCR_PTR_SIZE (sizeof(SCR_PTR)*2)
 
 typedef void FILE_HANDLE;
+typedef void OS_DIR;
+typedef void OS_THREAD;
+typedef void OS_MUTEX;
+typedef void OS_SEMAPHORE;
+
+typedef void OS_THREAD_PFN(void*arg);
 
 #define OS_BUTTON_PRESSED  1
 #define OS_BUTTON_RELEASED 0
@@ -85,10 +96,29 @@ typedef struct osShell_t
 typedef struct fileInfo_t
 {
 	long fileSize;
+	long modTime;
 	char asciidate[64];
 	int file_type;
 }OS_FILE_INFO;
 
+#define OS_MAX_DIR_ENTRY 256
+
+typedef struct dirEntry_t
+{
+	char name[OS_MAX_DIR_ENTRY];
+	int file_type;  /* For a link, the type of the link's target */
+	int link;       /* Symbolic link or reparse point */
+	long fileSize;  /* -1 until OS_DirEntryInfo() has filled it in */
+	long modTime;
+}OS_DIR_ENTRY;
+
+/* Identifies a directory however it was reached, to catch link loops. */
+typedef struct dirId_t
+{
+	unsigned long long volume;
+	unsigned long long file;
+}OS_DIR_ID;
+
 typedef struct mouseInput_t
 {
 	int buttonStatus;
@@ -139,13 +169,17 @@ int OS_Getch(void);
 void OS_SetCursorType(int overstrike, int visible);
 void OS_SetTextPosition(int x_position, int y_position);
 void OS_Time(char*string); /* 12:12:12 */
+unsigned long OS_Clock(void); /* milliseconds */
 int OS_ScreenSize(int*xd, int*yd);
 void OS_PaintScreen(char*buffer);
 void OS_PaintStatus(char*buffer);
+void OS_PaintRows(char*buffer, int*rows, int numRows);
+int OS_ScrollRows(char*buffer, int x, int y, int columns, int rows, int shift);
 void*OS_Malloc(long size);
 void OS_Free(void*data);
 int OS_Key(int*mode, OS_MOUSE*mouse);
 int OS_PeekKey(int*mode, OS_MOUSE*mouse);
+int OS_InputPending(void);
 OS_SHELL*OS_ShellCommand(char*cmd);
 void OS_ShellGetPath(char*path);
 void OS_ShellSetPath(char*path);
@@ -164,6 +198,19 @@ char OS_Frame(int index);
 int OS_Strcasecmp(char*str1, char*str2);
 int OS_ReadDirectory(char*path, char*mask, char**dirs, int max, int opts);
 void OS_DeallocDirs(char**dirs, int numDirs);
+
+/* Directory streams. Each OS_DIR is independent and never touches the     */
+/* current directory, so separate threads may walk separate streams.       */
+/* Streams are opened by path, so a walk can close each one before it      */
+/* descends and hold a single descriptor however deep the tree goes.       */
+/* Links are reported with link set; dangling links are never reported,    */
+/* and a walk that follows links should check OS_DirIdentity() for loops.  */
+OS_DIR*OS_OpenDir(char*path);
+int OS_ReadDir(OS_DIR*dir, OS_DIR_ENTRY*entry);
+void OS_CloseDir(OS_DIR*dir);
+int OS_DirEntryInfo(OS_DIR*dir, OS_DIR_ENTRY*entry);
+int OS_DirIdentity(OS_DIR*dir, OS_DIR_ID*id);
+int OS_WildcardMatch(char*mask, char*filename);
 int OS_PathDepth(char*filename);
 void OS_JoinPath(char*pathname, char*dir, char*filename);
 void OS_SetWindowTitle(char*pathname);
@@ -186,9 +233,28 @@ long OS_Read(void*buffer, long blkSize, long numBlks, FILE_HANDLE*fp);
 long OS_ReadLine(char*buffer, int len, FILE_HANDLE*fp);
 long OS_Write(void*buffer, long blkSize, long numBlks, FILE_HANDLE*fp);
 long OS_Filesize(FILE_HANDLE*fp);
+void*OS_MapFile(FILE_HANDLE*fp, long size);
+void OS_UnmapFile(void*data, long size);
 void OS_PutByte(char ch, FILE_HANDLE*fp);
 void OS_Delete(char*filename);
 
+/* Threads and locks. OS_CreateThread returns 0 when no thread could be */
+/* started, in which case the caller does the work itself.              */
+OS_THREAD*OS_CreateThread(OS_THREAD_PFN*pfn, void*arg);
+void OS_JoinThread(OS_THREAD*thread);
+OS_MUTEX*OS_CreateMutex(void);
+void OS_DestroyMutex(OS_MUTEX*mutex);
+void OS_LockMutex(OS_MUTEX*mutex);
+void OS_UnlockMutex(OS_MUTEX*mutex);
+int OS_NumProcessors(void);
+
+/* A counting semaphore that starts at 0. OS_WaitSemaphore blocks until */
+/* the count is above 0 and takes one. Create returns 0 on failure.     */
+OS_SEMAPHORE*OS_CreateSemaphore(void);
+void OS_DestroySemaphore(OS_SEMAPHORE*semaphore);
+void OS_PostSemaphore(OS_SEMAPHORE*semaphore);
+void OS_WaitSemaphore(OS_SEMAPHORE*semaphore);
+
 #define SESSION_CONFIG    0    //  "config"
 #define SESSION_FILES     1    //  "sessions"
 #define SESSION_HISTORY   2    //  "history"
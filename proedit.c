@@ -101,6 +101,7 @@ int EditorInit(int argv, char**argc)
 int EditorMain(int argv, char**argc)
 {
 	EDIT_FILE*file;
+	unsigned long lastPaint = 0;
 
 	if (!ProcessCmdLine(argv, argc, 0)) {
 		CloseDisplay();
@@ -124,9 +125,15 @@ int EditorMain(int argv, char**argc)
 	}
 
 	while (file) {
-		Paint(file);
+		/* Queued keys are all applied before the next paint, but a long */
+		/* run of them still shows progress every PAINT_INTERVAL.        */
+		if (!OS_InputPending() || OS_Clock() - lastPaint >= PAINT_INTERVAL) {
+			Paint(file);
 
-		UpdateStatusBar(file);
+			UpdateStatusBar(file);
+
+			lastPaint = OS_Clock();
+		}
 
 		file = ProcessUserInput(file, 0);
 	}
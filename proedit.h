@@ -70,6 +70,8 @@
 #define COPY_SELECT   0x08   /* Clipboard data is select-mode */
 #define COPY_UPDATE   0x10   /* Clipboard data is active      */
 
+#define COPY_TO_END   0x7fffffff
+
 #define LOAD_FILE_NORMAL      0x00
 #define LOAD_FILE_CMDLINE     0x01
 #define LOAD_FILE_EXISTS      0x02
@@ -85,6 +87,11 @@
 #define LINE_FLAG_WRAPPED   0x20
 #define LINE_FLAG_HIGHLIGHT 0x40
 #define LINE_FLAG_CUSTOM    0x80
+#define LINE_FLAG_UTF8      0x100 /* Has bytes past ASCII */
+
+#define GUTTER_ADDED   1
+#define GUTTER_CHANGED 2
+#define GUTTER_DELETED 3
 
 #define FILE_FLAG_MERGED      0x01
 #define FILE_FLAG_NONFILE     0x04
@@ -145,7 +152,9 @@
 #define CONFIG_INT_AUTO_SAVE_BUILD      40
 #define CONFIG_INT_HEX_COLS             41
 #define CONFIG_INT_XML_COMMENTS_COLOR   42
-#define CONFIG_INT_TOTAL                43
+#define CONFIG_INT_SPELL_BACKGROUND     43
+#define CONFIG_INT_SPELL_BG_COLOR       44
+#define CONFIG_INT_TOTAL                45
 
 #define MAINTAIN_CRLF                   1
 #define FORCE_CRLF                      2
@@ -169,6 +178,7 @@ typedef struct editLines
 	int allocSize;
 	int len;
 	int flags;
+	int lexState;
 	struct editLines*prev;
 	struct editLines*next;
 }EDIT_LINE;
@@ -262,6 +272,9 @@ typedef struct editUndos
 #define CURSOR_FLAG   0x02   /* Paint cursor on screen       */
 #define FRAME_FLAG    0x04   /* Paint frame with title       */
 
+/* While input is queued, paint at most this often (milliseconds) */
+#define PAINT_INTERVAL 33
+
 #define HEX_MODE_HEX  1
 #define HEX_MODE_TEXT 2
 
@@ -272,8 +285,8 @@ typedef struct editUndos
 #define LINE_OP_LOSING_FOCUS  0x10
 #define LINE_OP_INSERT_CHAR   0x20
 
-typedef void COLORIZE_PFN(EDIT_LINE*line, int pan, int len, SCR_PTR*screen,
-    int address, char attr);
+typedef void COLORIZE_PFN(void*file, EDIT_LINE*line, int pan, int len, SCR_PTR
+    *screen, int address, char attr);
 
 typedef int LINE_PFN(void*file, EDIT_LINE*line, int op, int arg);
 
@@ -285,6 +298,31 @@ typedef struct lineCallbacks
 	struct lineCallbacks*prev;
 }LINE_CALLBACK;
 
+/* Where the characters of a line with UTF-8 in it fall on the screen. */
+/* Each character takes one column, whatever its length in bytes.      */
+typedef struct columnMap
+{
+	EDIT_LINE*line;
+	char*text;     /* line->line and len the map was built from, */
+	int len;       /* len is -1 once the line has been edited     */
+	int columns;
+	int*column;    /* Column of each byte, then of the end        */
+	int*offset;    /* First byte of each column, then len         */
+	char*glyphs;   /* What each column shows                      */
+}COLUMN_MAP;
+
+typedef void LINE_CACHE_PFN(void*entry);
+
+/* Per-line data found by the line pointer. Every entry starts with its */
+/* EDIT_LINE pointer, and the whole cache empties when half full.       */
+typedef struct lineCache
+{
+	char*slots;
+	int entrySize;
+	int used;
+	LINE_CACHE_PFN*freeEntry;  /* Frees what an entry points at, or 0 */
+}LINE_CACHE;
+
 typedef struct editFile
 {
 	char*title;
@@ -317,6 +355,8 @@ typedef struct editFile
 	int hex_columns;
 	int forceHex;
 	int forceText;
+	long diskSize;
+	long diskTime;
 	char*hexData;
 	EDIT_BOOKMARK*bookmarks;
 	EDIT_BOOKMARK*bookmark_walk;
@@ -331,6 +371,12 @@ typedef struct editFile
 	COLORIZE_PFN*colorize;
 	LINE_CALLBACK*linePfns;
 	int callbackMask;
+	LINE_CACHE*diffSpans;
+	struct mergeGutter*gutter;
+	LINE_CACHE*spellSpans;
+	LINE_CACHE*columnMaps;
+	struct lexLanguage*language;
+	struct lexFile*lexer;
 	int userArg;
 	struct editFile*prev;
 	struct editFile*next;
@@ -417,6 +463,8 @@ void PaintFrame(EDIT_FILE*file);
 void MouseCommand(EDIT_FILE*file);
 void PaintCursor(EDIT_FILE*file);
 void PaintContent(EDIT_FILE*file);
+void InvalidateContent(void);
+void InvalidateLine(EDIT_LINE*line);
 void KeyHome(EDIT_FILE*file);
 void KeyEnd(EDIT_FILE*file);
 void InsertText(EDIT_FILE*file, char*text, int len, int options);
@@ -488,7 +536,7 @@ void InitClipboard(EDIT_CLIPBOARD*clipboard);
 void InitBookmarks(void);
 void Overstrike(EDIT_FILE*file);
 void CutLine(EDIT_FILE*file, int offset, int options);
-int CopyCheck(EDIT_FILE*file, EDIT_LINE*line, int x, int y);
+int CopySpan(EDIT_FILE*file, EDIT_LINE*line, int y, int*from, int*to);
 void ReallocLine(EDIT_LINE*line, int allocLen);
 void IndentLine(EDIT_FILE*file);
 void InitFileIndenting(EDIT_FILE*file);
@@ -507,6 +555,20 @@ void TabulateLine(EDIT_LINE*line, char*buf, int len);
 int InsertTabulate(int offset, char*buf, int len);
 
 char*TabulateString(char*string, int len, int*newLen);
+
+int AsciiText(char*text, int len);
+COLUMN_MAP*FindColumnMap(EDIT_FILE*file, EDIT_LINE*line);
+int LineColumn(EDIT_FILE*file, EDIT_LINE*line, int offset);
+int LineOffset(EDIT_FILE*file, EDIT_LINE*line, int column);
+int CharacterLength(EDIT_FILE*file, EDIT_LINE*line, int offset);
+void FreeColumnMaps(EDIT_FILE*file);
+
+LINE_CACHE*CreateLineCache(int entrySize, LINE_CACHE_PFN*freeEntry);
+void FreeLineCache(LINE_CACHE*cache);
+void*FindLineEntry(LINE_CACHE*cache, EDIT_LINE*line);
+void*AddLineEntry(LINE_CACHE*cache, EDIT_LINE*line);
+void ClearLineCache(LINE_CACHE*cache);
+
 void DeleteLine(EDIT_FILE*file);
 void UpdateStatusBar(EDIT_FILE*file);
 
@@ -545,6 +607,9 @@ void Calculator(EDIT_FILE*file);
 void CloseCalculator(void);
 COLORIZE_PFN*ConfigColorize(EDIT_FILE*file, char*pathname);
 void SetupColorizers(void);
+void FreeLexer(EDIT_FILE*file);
+void ResolveLexStates(EDIT_FILE*file, int last);
+void LexIdle(EDIT_FILE*file);
 EDIT_FILE*Utilities(EDIT_FILE*file);
 
 int CursorHexLeft(EDIT_FILE*file);
@@ -566,7 +631,7 @@ int PickList(char*windowTitle, int count, int width, char*title, char*list[],
     int start);
 
 void ProcessContent(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, int
-    line_number, int address);
+    address);
 void SaveCursor(EDIT_FILE*file, CURSOR_SAVE*);
 int TabulateLength(char*buf, int index, int len, int max);
 void ReleaseClipboard(EDIT_CLIPBOARD*clipboard);
@@ -627,6 +692,12 @@ void SetRegionFile(EDIT_FILE*file);
 void DisplayClipboard(EDIT_CLIPBOARD*clipboard);
 int SpellCheck(EDIT_FILE*file, EDIT_CLIPBOARD*clipboard);
 void FreeWordLists(void);
+void SpellHighlight(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, SCR_PTR
+    *screen, int address, SCR_PTR attr);
+int SpellResults(EDIT_FILE*file);
+void PollSpellCheck(void);
+void SpellIdle(EDIT_FILE*file);
+void FreeSpellSpans(EDIT_FILE*file);
 
 void AddClipboardLine(EDIT_CLIPBOARD*clipboard, char*buffer, int len,
     int status);
@@ -638,6 +709,14 @@ int ConvertToHex(char*hexString, char*hexData);
 
 
 EDIT_FILE*Merge(EDIT_FILE*current);
+EDIT_FILE*MergeTrees(EDIT_FILE*current);
+void MergeHighlight(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, SCR_PTR
+    *screen, int address, SCR_PTR attr);
+void FreeMergeSpans(EDIT_FILE*file);
+void ResetChangeGutter(EDIT_FILE*file);
+void FreeChangeGutter(EDIT_FILE*file);
+void ChangeGutter(EDIT_FILE*file, EDIT_LINE*top, int number, int rows, char
+    *marks);
 
 EDIT_CLIPBOARD*GetClipboard(void);
 void CopyFileClipboard(EDIT_FILE*file, EDIT_CLIPBOARD*clipboard);
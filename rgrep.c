@@ -32,6 +32,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "rgrep.h"
+#include "trigram.h"
+#include "multisearch.h"
 #include <unistd.h>
 
 #define TAB_SIZE 4
@@ -57,22 +59,124 @@
 
 #define DEFAULT_PROEDIT_EXE "pe"
 
+#define DIR_LIST_CHUNK 64
+
+#define MAX_EXCLUDE_EXT 64
+
+/* Files at or above this size are mapped rather than read. */
+#define MMAP_THRESHOLD (256*1024)
+
+/* Leading block inspected to decide whether a file is binary. */
+#define BINARY_BLOCK 4096
+
+#define OUTPUT_INTERACTIVE 0
+#define OUTPUT_TEXT        1
+#define OUTPUT_JSON        2
+
+/* Batch mode queues up to BATCH_JOBS files ahead of the oldest one not */
+/* yet written, so output stays in walk order without holding the walk. */
+#define BATCH_JOBS    256
+#define MAX_WORKERS   64
+#define OUTPUT_CHUNK  4096
+#define STDOUT_BUFFER (1024*1024)
+
+typedef struct searchData_t
+{
+	char*buffer;
+	long size;
+	int mapped;
+	int allocated;
+}SEARCH_DATA;
+
+typedef struct outputBuffer_t
+{
+	char*buffer;
+	long len;
+	long max;
+}OUTPUT_BUFFER;
+
+typedef struct searchWorker_t
+{
+	MULTI_HITS hits;
+	char*readBuffer;
+	unsigned char*trigramSeen;
+}SEARCH_WORKER;
+
+typedef struct searchJob_t
+{
+	char*filename;
+	OS_DIR_ENTRY entry;
+	int indexFile;
+	int done;
+	OUTPUT_BUFFER output;
+}SEARCH_JOB;
+
+typedef struct dirList_t
+{
+	char**names;
+	int count;
+	int max;
+}DIR_LIST;
+
+/* The directories above the one being read, while links are followed. */
+typedef struct dirChain_t
+{
+	OS_DIR_ID id;
+	struct dirChain_t*parent;
+}DIR_CHAIN;
+
 #ifdef WIN32_CONSOLE
 #include <windows.h>
 #endif
 
 static void DisplayHelp(void);
 static void ShowUsage(void);
+static int ParseOption(char*arg);
+static long ParseSize(char*string);
+static void ParseExtensions(char*list);
+static int ExcludedFile(char*name);
+static int LoadPatternFile(char*filename);
+static void AddSearchPattern(char*text);
+static int LoadSearchData(char*filename, SEARCH_DATA*data,
+    SEARCH_WORKER*worker);
+static void ReleaseSearchData(SEARCH_DATA*data);
+static int BinaryData(char*buffer, long size);
 static int SearchFileWildcard(char*pathname);
 static int SearchFileRecurse(char*pathname);
-static int SearchFile(char*filename);
+static int SearchTree(char*pathname, int recurse);
+static int SearchDirectory(char*dirPath, char*mask, int recurse,
+    DIR_CHAIN*parent);
+static char*JoinDirPath(char*dirPath, char*name);
+static void InitDirList(DIR_LIST*list);
+static void AddDirList(DIR_LIST*list, char*name);
+static void FreeDirList(DIR_LIST*list);
+static int SearchFile(char*filename, OS_DIR_ENTRY*indexEntry);
+static long ScanFile(char*filename, OS_DIR_ENTRY*indexEntry, SEARCH_WORKER*
+    worker, SEARCH_DATA*data, int*hexMode);
+static void QueueSearchFile(char*filename, OS_DIR_ENTRY*indexEntry);
+static void StartBatch(void);
+static void FinishBatch(void);
+static void WaitBatch(void);
+static void WriteBatch(void);
+static void BatchWorker(void*arg);
+static void BatchLock(void);
+static void BatchUnlock(void);
+static void BatchSearchFile(SEARCH_JOB*job, SEARCH_WORKER*worker);
+static void OutputHit(OUTPUT_BUFFER*output, char*filename, char*buffer,
+    long size, long index, long line, long lineStart, int hexMode,
+    MULTI_PATTERN*pattern);
+static void OutputCount(OUTPUT_BUFFER*output, char*filename, long count);
+static void AppendOutput(OUTPUT_BUFFER*output, char*data, long len);
+static void AppendJson(OUTPUT_BUFFER*output, char*data, long len);
+static int Utf8Length(unsigned char*data, long len);
 static void ViewFile(char*filename, int line, int index, int offset, int len,
-    int hexMode);
+    int hexMode, char*pattern);
 static int DisplayHit(char*filename, char*buffer, int index, int len, int line,
-    int offset, int bufLen);
+    int offset, int bufLen, int hexMode, char*pattern);
 static void ShowText(char*filename, char*buffer, int offset, int len, int size,
-    int line, int column);
-static void ShowHex(char*filename, char*buffer, int index, int len, int size);
+    int line, int column, char*pattern);
+static void ShowHex(char*filename, char*buffer, int index, int len, int size,
+    char*pattern);
 static void DisplayBanner(void);
 static void SearchBanner(char*search);
 
@@ -89,10 +193,33 @@ static int verboseMode = 0;
 static int tabsize = TAB_SIZE;
 static int debugMode = 0;
 static int hitsOnly = 0;
+static int binaryMode = 0;
+static int followLinks = 0;
+static long maxFileSize = 0;
+static int numExcludeExt = 0;
+static char*excludeExt[MAX_EXCLUDE_EXT];
+static int indexMode = 0;
+static int indexRootLen = 0;
+static TRIGRAM_INDEX*trigramIndex = 0;
+static OS_MUTEX*indexLock = 0;
+static int outputMode = OUTPUT_INTERACTIVE;
+static int countOnly = 0;
+static int numWorkers = 0;
+static SEARCH_WORKER workers[MAX_WORKERS];
+static SEARCH_JOB batchJobs[BATCH_JOBS];
+static int numJobs = 0;    /* Jobs queued so far in this walk      */
+static int nextJob = 0;    /* Next job for a worker to take        */
+static int doneJobs = 0;   /* Jobs written; the queue starts here  */
+static int walkDone = 0;
+static OS_MUTEX*batchLock = 0;
+static OS_SEMAPHORE*jobsQueued = 0;
+static OS_SEMAPHORE*jobsFinished = 0;
+static OS_THREAD*threads[MAX_WORKERS];
+static int numThreads = 0;
 static int _path_offset = 0;
 static int _cols = 0;
 
-static char searchString[MAX_SEARCH_STRING];
+static MULTI_SEARCH*patterns;
 
 #ifdef WIN32_CONSOLE
 WORD originalScreenAttrs;
@@ -117,6 +244,8 @@ int EditorInit(int argv, char**argc)
 	exeName = argc[0];
 
 	strcpy(proedit, DEFAULT_PROEDIT_EXE);
+
+	patterns = CreateMultiSearch();
 	return (1);
 }
 
@@ -146,7 +275,7 @@ void SetupBaseDir(char*search)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-void ParseSearchString(void)
+void ParseSearchString(char*searchString)
 {
 	int len;
 	int i;
@@ -174,154 +303,1084 @@ void ParseSearchString(void)
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int ParseOption(char*arg)
+{
+
+	if (!OS_Strcasecmp(arg, "-r")) {
+		recursiveLoad = 0;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-h")) {
+		hitsOnly = 1;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-debug")) {
+		debugMode = 1;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-v")) {
+		verboseMode = 1;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-i")) {
+		ignoreCase = 0;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-b")) {
+		binaryMode = 1;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-index")) {
+		indexMode = 1;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-follow")) {
+		followLinks = 1;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-o")) {
+		outputMode = OUTPUT_TEXT;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-json")) {
+		outputMode = OUTPUT_JSON;
+		return (1);
+	}
+
+	if (!OS_Strcasecmp(arg, "-c")) {
+		countOnly = 1;
+
+		if (outputMode == OUTPUT_INTERACTIVE)
+			outputMode = OUTPUT_TEXT;
+		return (1);
+	}
+
+	if (arg[0] != '-')
+		return (0);
+
+	if (arg[1] == 't' || arg[1] == 'T') {
+		tabsize = atol(&arg[2]);
+		return (1);
+	}
+
+	if (arg[1] == 'e' || arg[1] == 'E') {
+		strcpy(proedit, &arg[2]);
+		return (1);
+	}
+
+	if (arg[1] == 'j' || arg[1] == 'J') {
+		numWorkers = MIN(atol(&arg[2]), MAX_WORKERS);
+		return (1);
+	}
+
+	if (arg[1] == 'm' || arg[1] == 'M') {
+		maxFileSize = ParseSize(&arg[2]);
+		return (1);
+	}
+
+	if (arg[1] == 'x' || arg[1] == 'X') {
+		ParseExtensions(&arg[2]);
+		return (1);
+	}
+
+	if (arg[1] == 'p' || arg[1] == 'P') {
+		AddSearchPattern(&arg[2]);
+		return (1);
+	}
+
+	if (arg[1] == 'f' || arg[1] == 'F') {
+		if (!LoadPatternFile(&arg[2]))
+			printf("Unable to read pattern file \"%s\"\n", &arg[2]);
+		return (1);
+	}
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static long ParseSize(char*string)
+{
+	long size;
+	char*ptr;
+
+	size = strtol(string, &ptr, 10);
+
+	if (*ptr == 'k' || *ptr == 'K')
+		size *= 1024;
+	else
+		if (*ptr == 'm' || *ptr == 'M')
+			size *= 1024*1024;
+		else
+			if (*ptr == 'g' || *ptr == 'G')
+				size *= 1024*1024*1024;
+
+	return (size);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ParseExtensions(char*list)
+{
+	char*ext;
+
+	for (ext = strtok(list, ",;"); ext; ext = strtok(0, ",;")) {
+		if (numExcludeExt == MAX_EXCLUDE_EXT)
+			break;
+
+		if (*ext == '.')
+			ext++;
+
+		if (*ext)
+			excludeExt[numExcludeExt++] = ext;
+	}
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int ExcludedFile(char*name)
+{
+	int i;
+	char*ext;
+
+	if (!numExcludeExt)
+		return (0);
+
+	ext = strrchr(name, '.');
+
+	if (!ext)
+		return (0);
+
+	for (i = 0; i < numExcludeExt; i++)
+		if (!OS_Strcasecmp(ext + 1, excludeExt[i]))
+			return (1);
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int LoadPatternFile(char*filename)
+{
+	FILE_HANDLE*fp;
+	char*buffer;
+	long size, i, start, len;
+
+	fp = OS_Open(filename, "rb");
+
+	if (!fp)
+		return (0);
+
+	size = OS_Filesize(fp);
+
+	if (size < 0) {
+		OS_Close(fp);
+		return (0);
+	}
+
+	buffer = OS_Malloc(size + 1);
+
+	if (size && !OS_Read(buffer, size, 1, fp)) {
+		OS_Free(buffer);
+		OS_Close(fp);
+		return (0);
+	}
+
+	OS_Close(fp);
+
+	buffer[size] = 10;
+
+	/* One pattern per line, with the same escapes as the command line. */
+	for (start = i = 0; i <= size; i++) {
+		if (buffer[i] != 10)
+			continue;
+
+		len = i - start;
+
+		if (len && buffer[start + len - 1] == 13)
+			len--;
+
+		buffer[start + len] = 0;
+
+		AddSearchPattern(&buffer[start]);
+
+		start = i + 1;
+	}
+
+	OS_Free(buffer);
+
+	return (1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AddSearchPattern(char*text)
+{
+	char searchString[MAX_SEARCH_STRING];
+
+	strncpy(searchString, text, MAX_SEARCH_STRING - 1);
+	searchString[MAX_SEARCH_STRING - 1] = 0;
+
+	ParseSearchString(searchString);
+	AddMultiPattern(patterns, searchString);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int EditorMain(int argv, char**argc)
+{
+	int i, file_search = 0;
+	int retCode;
+	#if 0
+	#ifndef WIN32_CONSOLE
+	struct winsize ws;
+
+	if (isatty(fileno(stdout))) {
+		ioctl(fileno(stdout), TIOCGWINSZ, &ws);
+		_cols = ws.ws_col;
+	}
+	#endif
+	#endif
+
+	if (_cols < 80)
+		_cols = 80;
+
+	if (argv < 2) {
+		DisplayHelp();
+		return (0);
+	}
+
+	for (i = 1; i < argv; i++) {
+		if (!OS_Strcasecmp(argc[i], "-?") || !OS_Strcasecmp(argc[i], "-help") ||
+		    !OS_Strcasecmp(argc[i], "--?") || !OS_Strcasecmp(argc[i],
+		    "--help")) {
+			DisplayHelp();
+			break;
+		}
+
+		if (ParseOption(argc[i]))
+			continue;
+
+		if (!patterns->numPatterns)
+			AddSearchPattern(argc[i]);
+		else {
+			file_search = 1;
+
+			SearchBanner(argc[i]);
+
+			if (recursiveLoad)
+				retCode = SearchFileRecurse(argc[i]);
+			else
+				retCode = SearchFileWildcard(argc[i]);
+
+			if (retCode == SEARCH_QUIT)
+				break;
+		}
+	}
+
+	if (!patterns->numPatterns)
+		ShowUsage();
+	else {
+		if (!file_search) {
+			SearchBanner("*");
+			if (recursiveLoad)
+				SearchFileRecurse("*");
+			else
+				SearchFileWildcard("*");
+		}
+	}
+
+	OS_Exit();
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SearchBanner(char*search)
+{
+	static int first = 0;
+	int i;
+
+	if (first == 0) {
+		first = 1;
+
+		/* Batch output is for other programs: no banner, big buffer. */
+		if (outputMode == OUTPUT_INTERACTIVE)
+			DisplayBanner();
+		else
+			setvbuf(stdout, 0, _IOFBF, STDOUT_BUFFER);
+
+		SetupBaseDir(search);
+
+		if (verboseMode) {
+			printf("File Search      : \"%s\"\n", search);
+			if (patterns->numPatterns == 1)
+				printf("Search String    : \"%s\"\n", patterns->patterns[0].text);
+			else
+				for (i = 0; i < patterns->numPatterns; i++)
+					printf("Search Pattern %-2d: \"%s\"\n", i + 1, patterns->
+					    patterns[i].text);
+			printf("Tab Size         : %d\n", tabsize);
+			printf("Case Sensitive   : %s\n", ignoreCase ? "No" : "Yes");
+			printf("Recursive Mode   : %s\n", recursiveLoad ? "Yes" : "No");
+			printf("Binary Files     : %s\n", binaryMode ? "Hex" : "Skipped");
+			printf("Trigram Index    : %s\n", indexMode ? "Yes" : "No");
+			printf("ProEdit filename : \"%s\"\n", proedit);
+			printf("\n");
+		}
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void DisplayHelp(void)
+{
+	DisplayBanner();
+	ShowUsage();
+	printf("Command line options:\n\n");
+	printf(" -i . . . . . . . . . . . . . . . . Don't Ignore Case\n");
+	printf(
+	    " -r . . . . . . . . . . . . . . . . Don't Recurse into directories\n");
+	printf(" -v . . . . . . . . . . . . . . . . Verbose Mode\n");
+	printf(
+	    " -b . . . . . . . . . . . . . . . . Search binary files (hits shown in hex)\n");
+	printf(
+	    " -p<pattern>. . . . . . . . . . . . Add a search pattern (repeatable)\n");
+	printf(
+	    " -f<pattern_file> . . . . . . . . . Add search patterns, one per line\n");
+	printf(
+	    " -o . . . . . . . . . . . . . . . . Batch output: file:line:column:match\n");
+	printf(
+	    " -json. . . . . . . . . . . . . . . Batch output as JSON lines\n");
+	printf(
+	    " -c . . . . . . . . . . . . . . . . Batch output of per-file hit counts\n");
+	printf(
+	    " -j<threads>. . . . . . . . . . . . Batch worker threads [all processors]\n");
+	printf(
+	    " -index . . . . . . . . . . . . . . Use/update trigram index in search root\n");
+	printf(
+	    " -follow. . . . . . . . . . . . . . Follow symbolic links (loops are skipped)\n");
+	printf(
+	    " -m<max_size>[k|m|g]. . . . . . . . Skip files larger than max_size\n");
+	printf(
+	    " -x<ext>[,<ext>...] . . . . . . . . Skip files with these extensions\n");
+	printf(" -t<tab_size> . . . . . . . . . . . Change default [%d] tab size\n",
+	    tabsize);
+	printf(
+	    " -e<ProEdit Filename> . . . . . . . Change default [\"%s\"] ProEdit filename\n", proedit);
+	printf(" -help. . . . . . . . . . . . . . . Display this help\n");
+	printf(" -debug . . . . . . . . . . . . . . Enable Debug Mode\n");
+	printf(" Note: [...] are optional <...> are required\n");
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void DisplayBanner(void)
+{
+	printf("\n%s Multi-Platform File searching utility", RGREP_MP_VERSION);
+	printf("\nDesigned/Developed/Produced by Adrian J. Michaud");
+	printf("\nLast %s Core Build: %s %s", RGREP_MP_VERSION, __DATE__, __TIME__);
+	printf("\nEMail: adrian@gnuxtools.com");
+	printf("\n\n");
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ShowUsage(void)
+{
+	printf("Usage: %s <search> [options] <filename>\n", exeName);
+	printf("       %s -p<search> [-p<search>...] [options] <filename>\n\n",
+	    exeName);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SearchFileWildcard(char*pathname)
+{
+	return (SearchTree(pathname, 0));
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SearchFileRecurse(char*pathname)
+{
+	return (SearchTree(pathname, 1));
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SearchTree(char*pathname, int recurse)
+{
+	int i, len, retCode;
+	char**texts;
+	char*path;
+	char*mask;
+	char*dirPath;
+
+	path = OS_Malloc(MAX_FILENAME);
+	mask = OS_Malloc(MAX_FILENAME);
+	dirPath = OS_Malloc(MAX_FILENAME);
+
+	if (debugMode)
+		printf("OS_GetFilename(%s)\n", pathname);
+
+	OS_GetFilename(pathname, path, mask);
+
+	if (!strlen(mask))
+		strcpy(mask, "*");
+
+	/* Joined names get their own separator, so drop the trailing one. */
+	strcpy(dirPath, path);
+
+	len = strlen(dirPath);
+
+	if (len && (dirPath[len - 1] == '/' || dirPath[len - 1] == '\\'))
+		dirPath[len - 1] = 0;
+
+	if (debugMode)
+		printf("path='%s' mask='%s'\n", path, mask);
+
+	CompileMultiSearch(patterns, ignoreCase);
+
+	if (indexMode) {
+		trigramIndex = OpenTrigramIndex(dirPath);
+		indexRootLen = strlen(dirPath);
+
+		texts = OS_Malloc(patterns->numPatterns*sizeof(char*));
+
+		for (i = 0; i < patterns->numPatterns; i++)
+			texts[i] = patterns->patterns[i].text;
+
+		/* '?' and '^' match a class of characters, so only the literal */
+		/* runs between them narrow the candidate files.                */
+		TrigramQuery(trigramIndex, texts, patterns->numPatterns, "?^");
+
+		OS_Free(texts);
+	}
+
+	if (outputMode != OUTPUT_INTERACTIVE)
+		StartBatch();
+
+	retCode = SearchDirectory(dirPath, mask, recurse, 0);
+
+	if (outputMode != OUTPUT_INTERACTIVE)
+		FinishBatch();
+
+	if (trigramIndex) {
+		/* Entries for files the walk did not visit can only be dropped */
+		/* when the walk covered the whole tree.                         */
+		SaveTrigramIndex(trigramIndex, recurse && !strcmp(mask, "*") &&
+		    !numExcludeExt && !maxFileSize && retCode != SEARCH_QUIT);
+
+		CloseTrigramIndex(trigramIndex);
+		trigramIndex = 0;
+	}
+
+	OS_Free(dirPath);
+	OS_Free(mask);
+	OS_Free(path);
+
+	return (retCode);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SearchDirectory(char*dirPath, char*mask, int recurse,
+    DIR_CHAIN*parent)
+{
+	int i, state, skipFiles = 0, retCode = 0;
+	char*pathname;
+	OS_DIR*dir;
+	OS_DIR_ENTRY entry;
+	DIR_LIST subdirs;
+	DIR_CHAIN chain;
+	DIR_CHAIN*up;
+
+	/* Only the root loses everything to the dropped trailing separator. */
+	dir = OS_OpenDir(*dirPath ? dirPath : "/");
+
+	if (!dir)
+		return (0);
+
+	/* A followed link can lead back to a directory above it, which would */
+	/* be searched forever, so each directory is checked against the ones */
+	/* it was reached through.                                            */
+	if (followLinks) {
+		if (!OS_DirIdentity(dir, &chain.id)) {
+			OS_CloseDir(dir);
+			return (0);
+		}
+
+		for (up = parent; up; up = up->parent) {
+			if (up->id.volume == chain.id.volume && up->id.file ==
+			    chain.id.file) {
+				if (verboseMode)
+					printf("Skipping link loop: %s\n", dirPath);
+
+				OS_CloseDir(dir);
+				return (0);
+			}
+		}
+
+		chain.parent = parent;
+	}
+
+	InitDirList(&subdirs);
+
+	while (OS_ReadDir(dir, &entry)) {
+		if (entry.link && !followLinks)
+			continue;
+
+		if (entry.file_type == FILE_TYPE_DIR) {
+			if (recurse)
+				AddDirList(&subdirs, entry.name);
+			continue;
+		}
+
+		if (skipFiles || !OS_WildcardMatch(mask, entry.name))
+			continue;
+
+		/* Prune on name and size before the file is ever opened. */
+		if (ExcludedFile(entry.name))
+			continue;
+
+		if (maxFileSize && OS_DirEntryInfo(dir, &entry) &&
+		    entry.fileSize > maxFileSize)
+			continue;
+
+		if (trigramIndex && !strncmp(entry.name, TRIGRAM_INDEX_NAME, strlen(
+		    TRIGRAM_INDEX_NAME)))
+			continue;
+
+		pathname = JoinDirPath(dirPath, entry.name);
+
+		state = TRIGRAM_STALE;
+
+		if (trigramIndex && OS_DirEntryInfo(dir, &entry)) {
+			if (!entry.fileSize) {
+				OS_Free(pathname);
+				continue;
+			}
+
+			state = TrigramCheckFile(trigramIndex, &pathname[indexRootLen + 1],
+			    entry.fileSize, entry.modTime);
+
+			if (state == TRIGRAM_SKIP || (state == TRIGRAM_BINARY &&
+			    !binaryMode)) {
+				OS_Free(pathname);
+				continue;
+			}
+		}
+
+		if (verboseMode)
+			printf("Searching %s\n", pathname);
+
+		if (outputMode != OUTPUT_INTERACTIVE)
+			QueueSearchFile(pathname, (trigramIndex && state == TRIGRAM_STALE
+			    && entry.fileSize >= 0) ? &entry : 0);
+		else
+			retCode = SearchFile(pathname, (trigramIndex && state ==
+			    TRIGRAM_STALE && entry.fileSize >= 0) ? &entry : 0);
+
+		OS_Free(pathname);
+
+		if (retCode == SEARCH_QUIT)
+			break;
+
+		if (retCode == SEARCH_SKIP_DIR)
+			skipFiles = 1;
+	}
+
+	/* Close before descending so only one directory is ever held open, */
+	/* however deep the tree goes.                                      */
+	OS_CloseDir(dir);
+
+	for (i = 0; i < subdirs.count && retCode != SEARCH_QUIT; i++) {
+		pathname = JoinDirPath(dirPath, subdirs.names[i]);
+
+		if (verboseMode)
+			printf("Searching in directory: %s\n", pathname);
+
+		retCode = SearchDirectory(pathname, mask, recurse, &chain);
+
+		OS_Free(pathname);
+	}
+
+	FreeDirList(&subdirs);
+
+	return (retCode == SEARCH_QUIT ? SEARCH_QUIT : 0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static char*JoinDirPath(char*dirPath, char*name)
+{
+	char*pathname;
+
+	pathname = OS_Malloc(strlen(dirPath) + strlen(name) + 2);
+
+	OS_JoinPath(pathname, dirPath, name);
+
+	return (pathname);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void InitDirList(DIR_LIST*list)
+{
+	list->names = 0;
+	list->count = 0;
+	list->max = 0;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AddDirList(DIR_LIST*list, char*name)
+{
+	char**names;
+
+	if (list->count == list->max) {
+		list->max = list->max ? list->max*2 : DIR_LIST_CHUNK;
+
+		names = OS_Malloc(list->max*sizeof(char*));
+
+		if (list->names) {
+			memcpy(names, list->names, list->count*sizeof(char*));
+			OS_Free(list->names);
+		}
+
+		list->names = names;
+	}
+
+	list->names[list->count] = OS_Malloc(strlen(name) + 1);
+	strcpy(list->names[list->count], name);
+	list->count++;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeDirList(DIR_LIST*list)
+{
+	int i;
+
+	for (i = 0; i < list->count; i++)
+		OS_Free(list->names[i]);
+
+	if (list->names)
+		OS_Free(list->names);
+
+	InitDirList(list);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SearchFile(char*filename, OS_DIR_ENTRY*indexEntry)
+{
+	long i, h, numHits, line = 0, offset = -1, scan = 0;
+	int retCode = 0;
+	int hexMode;
+	MULTI_PATTERN*pattern;
+	MULTI_HIT*hits;
+	SEARCH_DATA data;
+
+	numHits = ScanFile(filename, indexEntry, &workers[0], &data, &hexMode);
+
+	if (numHits < 0)
+		return (0);
+
+	hits = workers[0].hits.hits;
+
+	for (h = 0; h < numHits; h++) {
+		i = hits[h].offset;
+		pattern = &patterns->patterns[hits[h].pattern];
+
+		/* Bring the line/column count forward to the start of the hit. */
+		for (; scan <= i; scan++) {
+			offset++;
+
+			if (data.buffer[scan] == 9)
+				offset += (tabsize - (offset%tabsize));
+
+			if (data.buffer[scan] == 10) {
+				line++;
+				offset = 0;
+			}
+		}
+
+		retCode = DisplayHit(filename, data.buffer, i, pattern->len, line,
+		    offset, data.size, hexMode, pattern->text);
+
+		if (retCode)
+			break;
+	}
+
+	ReleaseSearchData(&data);
+
+	return (retCode);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static long ScanFile(char*filename, OS_DIR_ENTRY*indexEntry, SEARCH_WORKER*
+    worker, SEARCH_DATA*data, int*hexMode)
+{
+	unsigned int*trigrams;
+	int flags, count;
+
+	if (!LoadSearchData(filename, data, worker))
+		return (-1);
+
+	*hexMode = BinaryData(data->buffer, MIN(data->size, BINARY_BLOCK));
+
+	/* Index the whole file now; the search below may stop early. Only  */
+	/* adding the collected trigrams needs the index to itself.          */
+	if (indexEntry) {
+		flags = *hexMode ? TRIGRAM_FILE_BINARY : 0;
+
+		count = TrigramCollect(&worker->trigramSeen, data->buffer, data->
+		    size, &flags, &trigrams);
+
+		if (indexLock)
+			OS_LockMutex(indexLock);
+
+		TrigramAddFile(trigramIndex, &filename[indexRootLen + 1], indexEntry->
+		    fileSize, indexEntry->modTime, flags, trigrams, count);
+
+		if (indexLock)
+			OS_UnlockMutex(indexLock);
+	}
+
+	if (*hexMode && !binaryMode) {
+		if (verboseMode)
+			printf("Skipping binary file %s\n", filename);
+
+		ReleaseSearchData(data);
+		return (-1);
+	}
+
+	/* Every pattern is matched in one pass; hits come back in file order. */
+	return (MultiSearchBuffer(patterns, &worker->hits, data->buffer, data->
+	    size));
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void QueueSearchFile(char*filename, OS_DIR_ENTRY*indexEntry)
+{
+	SEARCH_JOB*job;
+
+	/* The oldest job has to be written before its slot is used again */
+	while (numJobs - doneJobs == BATCH_JOBS)
+		WaitBatch();
+
+	job = &batchJobs[numJobs % BATCH_JOBS];
+
+	job->filename = OS_Malloc(strlen(filename) + 1);
+	strcpy(job->filename, filename);
+
+	job->indexFile = indexEntry != 0;
+
+	if (indexEntry)
+		job->entry = *indexEntry;
+
+	job->output.buffer = 0;
+	job->output.len = 0;
+	job->output.max = 0;
+	job->done = 0;
+
+	BatchLock();
+	numJobs++;
+	BatchUnlock();
+
+	if (numThreads)
+		OS_PostSemaphore(jobsQueued);
+
+	WriteBatch();
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Start the workers for a walk. They stay up until FinishBatch, taking    #*/
+/*# files as the walk queues them, so the walk never waits for a group of   #*/
+/*# files to finish before it can go on.                                    #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void StartBatch(void)
+{
+	int i;
+
+	numJobs = 0;
+	nextJob = 0;
+	doneJobs = 0;
+	walkDone = 0;
+	numThreads = 0;
+
+	if (numWorkers <= 0)
+		numWorkers = MIN(OS_NumProcessors(), MAX_WORKERS);
+
+	if (numWorkers < 2)
+		return ;
+
+	if (!batchLock) {
+		batchLock = OS_CreateMutex();
+		indexLock = OS_CreateMutex();
+	}
+
+	jobsQueued = OS_CreateSemaphore();
+	jobsFinished = OS_CreateSemaphore();
+
+	/* The walking thread is worker 0 and searches too when the queue fills */
+	if (jobsQueued && jobsFinished) {
+		for (i = 1; i < numWorkers; i++) {
+			threads[numThreads] = OS_CreateThread(BatchWorker, &workers[i]);
+
+			if (threads[numThreads])
+				numThreads++;
+		}
+	}
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Search whatever is still queued, write it out and stop the workers.     #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FinishBatch(void)
+{
+	int i;
+
+	BatchLock();
+	walkDone = 1;
+	BatchUnlock();
+
+	for (i = 0; i < numThreads; i++)
+		OS_PostSemaphore(jobsQueued);
+
+	while (doneJobs < numJobs)
+		WaitBatch();
+
+	for (i = 0; i < numThreads; i++)
+		OS_JoinThread(threads[i]);
+
+	numThreads = 0;
+
+	if (jobsQueued)
+		OS_DestroySemaphore(jobsQueued);
+
+	if (jobsFinished)
+		OS_DestroySemaphore(jobsFinished);
+
+	jobsQueued = 0;
+	jobsFinished = 0;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Called by the walking thread when it can't go on until the oldest job   #*/
+/*# is written. It searches a queued file itself if there is one left, or   #*/
+/*# else waits for a worker to finish one.                                  #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-int EditorMain(int argv, char**argc)
+static void WaitBatch(void)
 {
-	int i, file_search = 0;
-	int retCode;
-	#if 0
-	#ifndef WIN32_CONSOLE
-	struct winsize ws;
+	SEARCH_JOB*job;
+	int number = -1;
 
-	if (isatty(fileno(stdout))) {
-		ioctl(fileno(stdout), TIOCGWINSZ, &ws);
-		_cols = ws.ws_col;
-	}
-	#endif
-	#endif
+	BatchLock();
 
-	if (_cols < 80)
-		_cols = 80;
+	if (nextJob < numJobs)
+		number = nextJob++;
 
-	if (argv < 2) {
-		DisplayHelp();
-		return (0);
-	}
+	BatchUnlock();
 
-	for (i = 1; i < argv; i++) {
-		if (!OS_Strcasecmp(argc[i], "-?") || !OS_Strcasecmp(argc[i], "-help") ||
-		    !OS_Strcasecmp(argc[i], "--?") || !OS_Strcasecmp(argc[i],
-		    "--help")) {
-			DisplayHelp();
-			break;
-		} else
-			if (!OS_Strcasecmp(argc[i], "-r")) {
-				recursiveLoad = 0;
-			} else
-				if (!OS_Strcasecmp(argc[i], "-h")) {
-					hitsOnly = 1;
-				} else
-					if (!OS_Strcasecmp(argc[i], "-debug")) {
-						debugMode = 1;
-					} else
-						if (!OS_Strcasecmp(argc[i], "-v")) {
-							verboseMode = 1;
-						} else
-							if (!OS_Strcasecmp(argc[i], "-i")) {
-								ignoreCase = 0;
-							} else
-								if (argc[i][0] == '-' && (argc[i][1] == 't' ||
-								    argc[i][1] == 'T')) {
-									tabsize = atol(&argc[i][2]);
-								} else
-									if (argc[i][0] == '-' && (argc[i][1] ==
-									    'e' || argc[i][1] == 'E')) {
-										strcpy(proedit, &argc[i][2]);
-									} else {
-										if (!strlen(searchString)) {
-											strcpy(searchString, argc[i]);
-											ParseSearchString();
-										} else {
-											file_search = 1;
-
-											SearchBanner(argc[i]);
-
-											if (recursiveLoad)
-												retCode = SearchFileRecurse(argc
-												    [i]);
-											else
-												retCode = SearchFileWildcard(
-												    argc[i]);
-
-											if (retCode == SEARCH_QUIT)
-												break;
-										}
-									}
-	}
-
-	if (!strlen(searchString))
-		ShowUsage();
-	else {
-		if (!file_search) {
-			SearchBanner("*");
-			if (recursiveLoad)
-				SearchFileRecurse("*");
-			else
-				SearchFileWildcard("*");
-		}
-	}
+	if (number >= 0) {
+		job = &batchJobs[number % BATCH_JOBS];
 
-	OS_Exit();
-	return (1);
-}
+		BatchSearchFile(job, &workers[0]);
 
+		BatchLock();
+		job->done = 1;
+		BatchUnlock();
+	} else
+		OS_WaitSemaphore(jobsFinished);
+
+	WriteBatch();
+}
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# Results leave in the order the walk found the files, however the        #*/
+/*# workers happened to finish. Only the walking thread writes.             #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void SearchBanner(char*search)
+static void WriteBatch(void)
 {
-	static int first = 0;
+	SEARCH_JOB*job;
+	int done;
 
-	if (first == 0) {
-		first = 1;
-		DisplayBanner();
+	while (doneJobs < numJobs) {
+		job = &batchJobs[doneJobs % BATCH_JOBS];
 
-		SetupBaseDir(search);
+		BatchLock();
+		done = job->done;
+		BatchUnlock();
 
-		if (verboseMode) {
-			printf("File Search      : \"%s\"\n", search);
-			printf("Search String    : \"%s\"\n", searchString);
-			printf("Tab Size         : %d\n", tabsize);
-			printf("Case Sensitive   : %s\n", ignoreCase ? "No" : "Yes");
-			printf("Recursive Mode   : %s\n", recursiveLoad ? "Yes" : "No");
-			printf("ProEdit filename : \"%s\"\n", proedit);
-			printf("\n");
-		}
+		if (!done)
+			break;
+
+		if (job->output.len)
+			fwrite(job->output.buffer, 1, job->output.len, stdout);
+
+		if (job->output.buffer)
+			OS_Free(job->output.buffer);
+
+		OS_Free(job->filename);
+
+		doneJobs++;
 	}
 }
 
-
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# A wake with no job left means the walking thread took it, or, once      #*/
+/*# the walk is done, that it is time to stop.                              #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void DisplayHelp(void)
+static void BatchWorker(void*arg)
 {
-	DisplayBanner();
-	ShowUsage();
-	printf("Command line options:\n\n");
-	printf(" -i . . . . . . . . . . . . . . . . Don't Ignore Case\n");
-	printf(
-	    " -r . . . . . . . . . . . . . . . . Don't Recurse into directories\n");
-	printf(" -v . . . . . . . . . . . . . . . . Verbose Mode\n");
-	printf(" -t<tab_size> . . . . . . . . . . . Change default [%d] tab size\n",
-	    tabsize);
-	printf(
-	    " -e<ProEdit Filename> . . . . . . . Change default [\"%s\"] ProEdit filename\n", proedit);
-	printf(" -help. . . . . . . . . . . . . . . Display this help\n");
-	printf(" -debug . . . . . . . . . . . . . . Enable Debug Mode\n");
-	printf(" Note: [...] are optional <...> are required\n");
-}
+	SEARCH_WORKER*worker = (SEARCH_WORKER*)arg;
+	SEARCH_JOB*job;
+	int number, stop;
+
+	for (; ; ) {
+		OS_WaitSemaphore(jobsQueued);
+
+		OS_LockMutex(batchLock);
+
+		number = nextJob < numJobs ? nextJob++ : -1;
+		stop = number < 0 && walkDone;
+
+		OS_UnlockMutex(batchLock);
 
+		if (stop)
+			break;
+
+		if (number < 0)
+			continue;
+
+		job = &batchJobs[number % BATCH_JOBS];
+
+		BatchSearchFile(job, worker);
+
+		OS_LockMutex(batchLock);
+		job->done = 1;
+		OS_UnlockMutex(batchLock);
+
+		OS_PostSemaphore(jobsFinished);
+	}
+}
 
 /*###########################################################################*/
 /*#                                                                         #*/
@@ -329,71 +1388,126 @@ static void DisplayHelp(void)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void DisplayBanner(void)
+static void BatchLock(void)
 {
-	printf("\n%s Multi-Platform File searching utility", RGREP_MP_VERSION);
-	printf("\nDesigned/Developed/Produced by Adrian J. Michaud");
-	printf("\nLast %s Core Build: %s %s", RGREP_MP_VERSION, __DATE__, __TIME__);
-	printf("\nEMail: adrian@gnuxtools.com");
-	printf("\n\n");
+	if (batchLock)
+		OS_LockMutex(batchLock);
 }
 
-
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void ShowUsage(void)
+static void BatchUnlock(void)
 {
-	printf("Usage: %s <search> [options] <filename>\n\n", exeName);
+	if (batchLock)
+		OS_UnlockMutex(batchLock);
 }
 
-
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static int SearchFileWildcard(char*pathname)
+static void BatchSearchFile(SEARCH_JOB*job, SEARCH_WORKER*worker)
 {
-	int retCode = 0;
-	char*filename;
-	char*fullpath;
+	long h, numHits, index, line = 1, lineStart = 0, scan = 0;
+	MULTI_HIT*hits;
+	SEARCH_DATA data;
+	int hexMode;
 
-	filename = OS_Malloc(MAX_FILENAME);
-	fullpath = OS_Malloc(MAX_FILENAME);
+	numHits = ScanFile(job->filename, job->indexFile ? &job->entry : 0, worker,
+	    &data, &hexMode);
 
-	if (debugMode)
-		printf("OS_GetFullPathname(%s)\n", pathname);
+	if (numHits < 0)
+		return ;
+
+	if (countOnly) {
+		if (numHits)
+			OutputCount(&job->output, &job->filename[_path_offset], numHits);
 
-	if (OS_GetFullPathname(pathname, fullpath, MAX_FILENAME)) {
-		if (debugMode)
-			printf("fullpath='%s'\n", fullpath);
+		ReleaseSearchData(&data);
+		return ;
+	}
 
-		OS_DosFindFirst(fullpath, filename);
+	hits = worker->hits.hits;
 
-		while (strlen(filename)) {
-			if (verboseMode)
-				printf("Searching %s\n", filename);
+	for (h = 0; h < numHits; h++) {
+		index = hits[h].offset;
+
+		for (; scan < index; scan++)
+			if (data.buffer[scan] == 10) {
+				line++;
+				lineStart = scan + 1;
+			}
 
-			retCode = SearchFile(filename);
+		OutputHit(&job->output, &job->filename[_path_offset], data.buffer,
+		    data.size, index, line, lineStart, hexMode, &patterns->patterns[
+		    hits[h].pattern]);
+	}
 
-			if (retCode == SEARCH_QUIT || retCode == SEARCH_SKIP_DIR)
-				break;
+	ReleaseSearchData(&data);
+}
 
-			OS_DosFindNext(filename);
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void OutputHit(OUTPUT_BUFFER*output, char*filename, char*buffer,
+    long size, long index, long line, long lineStart, int hexMode,
+    MULTI_PATTERN*pattern)
+{
+	char number[64];
+	long end;
+
+	if (outputMode == OUTPUT_JSON) {
+		AppendOutput(output, "{\"file\":\"", 9);
+		AppendJson(output, filename, strlen(filename));
+
+		if (hexMode)
+			sprintf(number, "\",\"offset\":%ld", index);
+		else
+			sprintf(number, "\",\"line\":%ld,\"column\":%ld", line, index -
+			    lineStart + 1);
+
+		AppendOutput(output, number, strlen(number));
+		AppendOutput(output, ",\"pattern\":\"", 12);
+		AppendJson(output, pattern->text, pattern->len);
+		AppendOutput(output, "\",\"match\":\"", 11);
+		AppendJson(output, &buffer[index], pattern->len);
+
+		if (!hexMode) {
+			for (end = lineStart; end < size && buffer[end] != 10; end++)
+				;
+
+			if (end > lineStart && buffer[end - 1] == 13)
+				end--;
+
+			AppendOutput(output, "\",\"text\":\"", 10);
+			AppendJson(output, &buffer[lineStart], end - lineStart);
 		}
 
-		OS_DosFindEnd();
+		AppendOutput(output, "\"}\n", 3);
+		return ;
 	}
 
-	OS_Free(filename);
-	OS_Free(fullpath);
+	AppendOutput(output, filename, strlen(filename));
 
-	return (retCode);
+	/* Binary hits have no line; they report line 0 and the byte offset. */
+	if (hexMode)
+		sprintf(number, ":0:%ld:", index);
+	else
+		sprintf(number, ":%ld:%ld:", line, index - lineStart + 1);
+
+	/* Like grep -o, just the bytes that matched */
+	AppendOutput(output, number, strlen(number));
+	AppendOutput(output, &buffer[index], pattern->len);
+	AppendOutput(output, "\n", 1);
 }
 
 /*###########################################################################*/
@@ -402,83 +1516,139 @@ static int SearchFileWildcard(char*pathname)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static int SearchFileRecurse(char*pathname)
+static void OutputCount(OUTPUT_BUFFER*output, char*filename, long count)
 {
-	int i, numDirs, retCode;
-	char*filename;
-	char*path;
-	char*mask;
-	char*orgDir;
-	char**dirs;
+	char number[64];
+
+	if (outputMode == OUTPUT_JSON) {
+		AppendOutput(output, "{\"file\":\"", 9);
+		AppendJson(output, filename, strlen(filename));
+		sprintf(number, "\",\"count\":%ld}\n", count);
+	} else {
+		AppendOutput(output, filename, strlen(filename));
+		sprintf(number, ":%ld\n", count);
+	}
 
-	filename = OS_Malloc(MAX_FILENAME);
-	orgDir = OS_Malloc(MAX_FILENAME);
-	path = OS_Malloc(MAX_FILENAME);
-	mask = OS_Malloc(MAX_FILENAME);
-	dirs = OS_Malloc(MAX_LIST_FILES*sizeof(char*));
+	AppendOutput(output, number, strlen(number));
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AppendOutput(OUTPUT_BUFFER*output, char*data, long len)
+{
+	char*grow;
 
-	OS_GetCurrentDir(orgDir);
+	if (output->len + len > output->max) {
+		output->max = (output->len + len + OUTPUT_CHUNK)&~(OUTPUT_CHUNK - 1);
 
-	retCode = SearchFileWildcard(pathname);
+		grow = OS_Malloc(output->max);
 
-	if (retCode != SEARCH_QUIT) {
-		OS_GetFilename(pathname, path, mask);
+		if (output->buffer) {
+			memcpy(grow, output->buffer, output->len);
+			OS_Free(output->buffer);
+		}
 
-		if (!strlen(mask))
-			strcpy(mask, "*");
+		output->buffer = grow;
+	}
 
-		numDirs = OS_ReadDirectory(path, "*", dirs, MAX_LIST_FILES,
-		    OS_NO_SPECIAL_DIR);
+	memcpy(&output->buffer[output->len], data, len);
+	output->len += len;
+}
 
-		for (i = 0; i < numDirs; i++) {
-			OS_JoinPath(filename, dirs[i], mask);
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AppendJson(OUTPUT_BUFFER*output, char*data, long len)
+{
+	char escape[8];
+	unsigned char ch;
+	long i, start = 0;
+	int size;
 
-			if (verboseMode)
-				printf("Searching in directory: %s\n", filename);
+	for (i = 0; i < len; i++) {
+		ch = (unsigned char)data[i];
 
-			retCode = SearchFileRecurse(filename);
+		if (ch >= 32 && ch < 0x80 && ch != '"' && ch != '\\')
+			continue;
 
-			if (retCode == SEARCH_QUIT)
-				break;
+		if (ch >= 0x80 && (size = Utf8Length((unsigned char*)&data[i], len -
+		    i)) > 0) {
+			i += size - 1;
+			continue;
 		}
 
-		OS_DeallocDirs(dirs, numDirs);
-	}
+		/* A byte that isn't part of a UTF-8 character is taken as Latin-1, */
+		/* so binary and Latin-1 text still make valid JSON.                */
 
-	OS_SetCurrentDir(orgDir);
+		AppendOutput(output, &data[start], i - start);
+		start = i + 1;
 
-	OS_Free(orgDir);
-	OS_Free(path);
-	OS_Free(mask);
-	OS_Free(dirs);
-	OS_Free(filename);
+		if (ch == '"' || ch == '\\')
+			sprintf(escape, "\\%c", ch);
+		else
+			if (ch == 9)
+				strcpy(escape, "\\t");
+			else
+				sprintf(escape, "\\u%04x", ch);
 
-	return (retCode);
+		AppendOutput(output, escape, strlen(escape));
+	}
+
+	AppendOutput(output, &data[start], len - start);
 }
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# Length of the well formed UTF-8 character at data, or 0. Overlong       #*/
+/*# forms, surrogates and code points past U+10FFFF are refused.            #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static int FunctionCheck(char ch)
+static int Utf8Length(unsigned char*data, long len)
 {
-	if (ch >= 'a' && ch <= 'z')
-		return (1);
+	int i, size, low = 0x80, high = 0xbf;
 
-	if (ch >= 'A' && ch <= 'Z')
-		return (1);
+	if (data[0] < 0xc2 || data[0] > 0xf4)
+		return (0);
 
-	if (ch == '_')
-		return (1);
+	if (data[0] < 0xe0)
+		size = 2;
+	else
+		if (data[0] < 0xf0) {
+			size = 3;
+
+			if (data[0] == 0xe0)
+				low = 0xa0;
+			if (data[0] == 0xed)
+				high = 0x9f;
+		} else {
+			size = 4;
+
+			if (data[0] == 0xf0)
+				low = 0x90;
+			if (data[0] == 0xf4)
+				high = 0x8f;
+		}
 
-	if (ch >= '0' && ch <= '9')
-		return (1);
+	if (size > len)
+		return (0);
 
-	return (0);
-}
+	for (i = 1; i < size; i++) {
+		if (data[i] < low || data[i] > high)
+			return (0);
+
+		low = 0x80;
+		high = 0xbf;
+	}
 
+	return (size);
+}
 
 /*###########################################################################*/
 /*#                                                                         #*/
@@ -486,14 +1656,10 @@ static int FunctionCheck(char ch)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static int SearchFile(char*filename)
+static int LoadSearchData(char*filename, SEARCH_DATA*data,
+    SEARCH_WORKER*worker)
 {
 	FILE_HANDLE*fp;
-	long filesize, i, j, line = 0, offset = 0, len, searchLen;
-	char*buffer;
-	int retCode = 0;
-	char ch;
-	char ch2;
 
 	if (debugMode)
 		printf("OS_Open(%s)\n", filename);
@@ -503,72 +1669,100 @@ static int SearchFile(char*filename)
 	if (!fp)
 		return (0);
 
-	filesize = OS_Filesize(fp);
+	data->size = OS_Filesize(fp);
+	data->mapped = 0;
+	data->allocated = 0;
+	data->buffer = 0;
+
+	if (data->size <= 0) {
+		if (data->size < 0)
+			printf("Filesize for %s is bad..  %ld\n", filename, data->size);
 
-	if (filesize == -1) {
 		OS_Close(fp);
 		return (0);
 	}
-	if (debugMode)
-		printf("Before OS_Read(size=%ld)\n", filesize);
 
-	if (filesize < 0) {
-		printf("Filesize for %s is bad..  %ld\n", filename, filesize);
+	if (data->size >= MMAP_THRESHOLD) {
+		data->buffer = OS_MapFile(fp, data->size);
+
+		if (data->buffer)
+			data->mapped = 1;
+		else {
+			data->buffer = OS_Malloc(data->size);
+			data->allocated = 1;
+		}
+	} else {
+		/* Small files share one buffer per worker, sized for the largest. */
+		if (!worker->readBuffer)
+			worker->readBuffer = OS_Malloc(MMAP_THRESHOLD);
+
+		data->buffer = worker->readBuffer;
 	}
 
-	buffer = OS_Malloc(filesize);
+	if (debugMode)
+		printf("Before OS_Read(size=%ld, mapped=%d)\n", data->size,
+		    data->mapped);
 
-	if (OS_Read(buffer, filesize, 1, fp)) {
-		searchLen = strlen(searchString);
+	if (!data->mapped && !OS_Read(data->buffer, data->size, 1, fp)) {
+		OS_Close(fp);
+		ReleaseSearchData(data);
+		return (0);
+	}
 
-		len = (filesize - searchLen) + 1;
+	OS_Close(fp);
 
-		for (i = 0; i < len; i++, offset++) {
-			if (buffer[i] == 9)
-				offset += (tabsize - (offset%tabsize));
+	return (1);
+}
 
-			if (buffer[i] == 10) {
-				line++;
-				offset = 0;
-			}
-			for (j = 0; j < searchLen; j++) {
-				ch = buffer[i + j];
-				ch2 = searchString[j];
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ReleaseSearchData(SEARCH_DATA*data)
+{
+	if (data->mapped)
+		OS_UnmapFile(data->buffer, data->size);
 
-				if (ch2 == '?')
-					continue;
+	if (data->allocated)
+		OS_Free(data->buffer);
 
-				// check for identifier
-				if (ch2 == '^' && !FunctionCheck(ch))
-					continue;
+	data->buffer = 0;
+	data->mapped = 0;
+	data->allocated = 0;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int BinaryData(char*buffer, long size)
+{
+	long i;
+	int count = 0;
+	unsigned char ch;
 
-				if (ignoreCase) {
-					if (ch >= 'a' && ch <= 'z')
-						ch -= 32;
+	// A NUL, or more than 1% control characters, marks a binary file. High
+	// bytes are left alone so UTF-8 and Latin-1 text still count as text.
+	for (i = 0; i < size; i++) {
+		ch = (unsigned char)buffer[i];
 
-					if (ch2 >= 'a' && ch2 <= 'z')
-						ch2 -= 32;
-				}
+		if (!ch)
+			return (1);
 
-				if (ch != ch2)
-					break;
-			}
-			if (j == searchLen) {
-				retCode = DisplayHit(filename, buffer, i, searchLen, line,
-				    offset, filesize);
+		if (ch == 10 || ch == 13 || ch == 9 || ch == 12 || ch == 27)
+			continue;
 
-				if (retCode)
-					break;
-			}
+		if (ch < 32 || ch == 127) {
+			if (++count > size / 100)
+				return (1);
 		}
 	}
-	if (debugMode)
-		printf("After OS_Read()\n");
-
-	OS_Free(buffer);
-	OS_Close(fp);
 
-	return (retCode);
+	return (0);
 }
 
 /*###########################################################################*/
@@ -578,30 +1772,15 @@ static int SearchFile(char*filename)
 /*#                                                                         #*/
 /*###########################################################################*/
 static int DisplayHit(char*filename, char*buffer, int index, int len, int line,
-    int offset, int buflen)
+    int offset, int buflen, int hexMode, char*pattern)
 {
 	int ch;
-	int i;
-	int hexMode = 0;
-	int count = 0;
-
-	// If file has more than 1% non displayable characters, consider it a binary file
-	for (i = 0; i < buflen; i++) {
-		if (buffer[i] == 10 || buffer[i] == 13 || buffer[i] == 9)
-			continue;
-
-		if ((unsigned char)buffer[i] > 127 || buffer[i] < 32) {
-			if (++count > buflen / 100) {
-				hexMode = 1;
-				break;
-			}
-		}
-	}
 
 	if (hexMode)
-		ShowHex(filename, buffer, index, len, buflen);
+		ShowHex(filename, buffer, index, len, buflen, pattern);
 	else
-		ShowText(filename, buffer, index, len, buflen, line, offset);
+		ShowText(filename, buffer, index, len, buflen, line, offset,
+		    pattern);
 
 	if (hitsOnly)
 		return (0);
@@ -624,7 +1803,7 @@ static int DisplayHit(char*filename, char*buffer, int index, int len, int line,
 
 		if (ch == 'l' || ch == 'L') {
 			printf("\n");
-			ViewFile(filename, line, index, offset, len, hexMode);
+			ViewFile(filename, line, index, offset, len, hexMode, pattern);
 			return (0);
 		}
 
@@ -648,17 +1827,17 @@ static int DisplayHit(char*filename, char*buffer, int index, int len, int line,
 /*#                                                                         #*/
 /*###########################################################################*/
 static void ViewFile(char*filename, int line, int index, int offset, int len,
-    int hexMode)
+    int hexMode, char*pattern)
 {
 	char cmd[512];
 
 	if (hexMode)
 		sprintf(cmd, "%s -tab%d -hex \"%s\" -g%d -h%d,%d \"-f%s\"", proedit,
-		    tabsize, filename, index + len, index, len - 1, searchString);
+		    tabsize, filename, index + len, index, len - 1, pattern);
 	else
 		sprintf(cmd, "%s -tab%d -text \"%s\" -g%d,%d -h%d,%d,%d \"-f%s\"",
 		    proedit, tabsize, filename, line + 1, offset + len, line + 1,
-		    offset, offset + len - 1, searchString);
+		    offset, offset + len - 1, pattern);
 
 	if (verboseMode)
 		printf("Launching ProEdit: %s\n\n", cmd);
@@ -674,15 +1853,20 @@ static void ViewFile(char*filename, int line, int index, int offset, int len,
 /*#                                                                         #*/
 /*###########################################################################*/
 void ShowText(char*filename, char*buffer, int index, int len, int size,
-    int line, int column)
+    int line, int column, char*pattern)
 {
 	int i, counter = 0, j, col, foundLine;
 	int color = 0;
+	char ch;
 
 	foundLine = line;
 
 	if (hitsOnly) {
 		printf("%s: (%d:%d) ", &filename[_path_offset], line, column);
+
+		if (patterns->numPatterns > 1)
+			printf("[%s] ", pattern);
+
 		for (j = index; j > 0; j--)
 			if (buffer[j] == 10) {
 				j++;
@@ -751,8 +1935,10 @@ void ShowText(char*filename, char*buffer, int index, int len, int size,
 			if (buffer[j] == 10)
 				break;
 
-			if (buffer[j] <= 32)
-				buffer[j] = 32;
+			ch = buffer[j];
+
+			if (ch <= 32)
+				ch = 32;
 
 			if (col < (_cols - 1)) {
 				if ((j >= index) && (j < (index + len))) {
@@ -760,7 +1946,7 @@ void ShowText(char*filename, char*buffer, int index, int len, int size,
 					SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE),
 					    FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY
 					    | BACKGROUND_BLUE);
-					printf("%c", buffer[j]);
+					printf("%c", ch);
 					SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE),
 					    originalScreenAttrs);
 					#else
@@ -769,7 +1955,7 @@ void ShowText(char*filename, char*buffer, int index, int len, int size,
 						if (isatty(fileno(stdout)))
 							printf(BOLDBLUE);
 					}
-					printf("%c", buffer[j]);
+					printf("%c", ch);
 					#endif
 				} else {
 					#ifndef WIN32_CONSOLE
@@ -780,7 +1966,7 @@ void ShowText(char*filename, char*buffer, int index, int len, int size,
 					}
 					#endif
 
-					printf("%c", buffer[j]);
+					printf("%c", ch);
 				}
 			}
 		}
@@ -793,7 +1979,11 @@ void ShowText(char*filename, char*buffer, int index, int len, int size,
 		#endif
 	}
 	printf("\n");
-	printf("\n(Found on Line %d, Column %d)\n", foundLine + 1, column);
+	if (patterns->numPatterns > 1)
+		printf("\n(Found \"%s\" on Line %d, Column %d)\n", pattern, foundLine + 1,
+		    column);
+	else
+		printf("\n(Found on Line %d, Column %d)\n", foundLine + 1, column);
 }
 
 
@@ -803,17 +1993,25 @@ void ShowText(char*filename, char*buffer, int index, int len, int size,
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void ShowHex(char*filename, char*buffer, int index, int len, int size)
+static void ShowHex(char*filename, char*buffer, int index, int len, int size,
+    char*pattern)
 {
 	int offset, count = 0, i, j, addr = 0;
 	int color = 0;
 
 	if (hitsOnly) {
-		printf("%s (offset %d)\n", &filename[_path_offset], index);
+		if (patterns->numPatterns > 1)
+			printf("%s (offset %d) [%s]\n", &filename[_path_offset], index,
+			    pattern);
+		else
+			printf("%s (offset %d)\n", &filename[_path_offset], index);
 		return ;
 	}
 
-	printf("\nFound in %s:\n", filename);
+	if (patterns->numPatterns > 1)
+		printf("\nFound \"%s\" in %s:\n", pattern, filename);
+	else
+		printf("\nFound in %s:\n", filename);
 
 	offset = (index&0xfffffff0) - 0x30;
 
@@ -37,9 +37,10 @@
 #define RGREP_MP_VERSION "RecursiveGrep MP 2.0"
 
 #define MAX_FILENAME      256
-#define MAX_LIST_FILES    4096
 #define MAX_SEARCH_STRING 1024
 
+#define MIN(a,b) (((a)<(b))?(a):(b))
+
 #ifdef DEBUG_MEMORY
 #define OS_Malloc(size) DebugMalloc((size),__FILE__,__LINE__);
 #define OS_Free(ptr)    DebugFree((ptr),__FILE__,__LINE__);
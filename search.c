@@ -31,11 +31,13 @@
 #include <string.h>
 #include <stdio.h>
 #include "proedit.h"
+#include "trigram.h"
 
 static int ReplaceText(EDIT_FILE*file);
 static int SearchLine(EDIT_FILE*file, char*source, char*dest, int destLen, int
     offset, int line);
 static EDIT_FILE*SearchHexAgain(EDIT_FILE*file);
+static int IndexedMiss(EDIT_FILE*file);
 
 extern char last_search[MAX_SEARCH];
 extern char last_replace[MAX_SEARCH];
@@ -242,9 +244,10 @@ EDIT_FILE*SearchAgain(EDIT_FILE*file)
 			/* Get the next file. */
 			newFile = NextFile(file);
 
-			/* If next file is a Hex mode file, or a NONFILE, keep switching */
-			/* until we get non-hex mode/valid file.                         */
-			while (newFile->hexMode || (newFile->file_flags&FILE_FLAG_NONFILE))
+			/* If next file is a Hex mode file, a NONFILE, or one the search */
+			/* index rules out, keep switching until we get a file to search. */
+			while (newFile->hexMode || (newFile->file_flags&FILE_FLAG_NONFILE) ||
+			    (newFile != origin && IndexedMiss(newFile)))
 				newFile = NextFile(newFile);
 
 			/* Is there only one file loaded? */
@@ -278,6 +281,24 @@ EDIT_FILE*SearchAgain(EDIT_FILE*file)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int IndexedMiss(EDIT_FILE*file)
+{
+	/* Only a buffer that still matches its file on disk can be judged by */
+	/* the index built from that file.                                    */
+	if (FileModified(file) || !file->diskTime)
+		return (0);
+
+	return (TrigramExcludesFile(file->pathname, file->diskSize, file->diskTime,
+	    last_search));
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
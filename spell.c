@@ -36,7 +36,6 @@
 
 #define MAX_WORD_LEN       32
 #define MIN_WORD_LEN       2
-#define MAX_COMPRESSED_LEN 64
 
 #define SPELL_IGNORE   3
 #define SPELL_FIXED    2
@@ -48,7 +47,13 @@
 
 #define MAX_CACHED_SCANS 128
 
-#define HASH_TABLE_SIZE 0x8000
+#define MAX_SUGGEST_DISTANCE 3
+
+#define MAX_SPELL_SPANS  32
+#define MAX_SPELL_JOBS   256
+
+/* Only the words the user adds are hashed at run time */
+#define HASH_TABLE_SIZE 0x1000
 
 typedef struct wordChoices_t
 {
@@ -63,6 +68,15 @@ typedef struct scanCache_t
 	WORD_LIST choices;
 }SPELL_SCAN_CACHE;
 
+typedef struct suggestions_t
+{
+	unsigned long long pattern[256];
+	char*words[MAX_WORDS];
+	int distance[MAX_WORDS];
+	int weight[MAX_WORDS];
+	int total;
+}SPELL_SUGGEST;
+
 static int scanCacheIndex;
 static SPELL_SCAN_CACHE*scanCache[MAX_CACHED_SCANS];
 
@@ -111,22 +125,108 @@ static void FullWordScan(char*word, int, WORD_LIST*choices);
 static int CheckScanCache(char*word, WORD_LIST*choices);
 static void AddScanCache(char*word, WORD_LIST*choices);
 static void FlushScanCache(int index);
-static void HashDictionary(void);
+static int LookupDictionary(char*word, int len);
+static unsigned int DictionaryHash(char*word, int len, unsigned int seed);
 static void HashWord(char*word, int len);
 static void AddNewWord(char*word);
 static void AddUserWords(void);
 
 static char insertChars[] = {"esianjrtqolcdugmphbyfvkwzx"};
 
+/* Once a suggestion is needed, every word is also put in a BK-tree */
+/* through child/sibling. Each child is kept at its edit distance   */
+/* from the parent.                                                 */
+typedef struct suggestNode_t
+{
+	char*word;
+	int len;
+	int distance;
+	struct suggestNode_t*child;
+	struct suggestNode_t*sibling;
+}SPELL_NODE;
+
+/* Words the user added. The dictionary itself is a read only perfect */
+/* hash image generated by speller/make_dict.                          */
 typedef struct dictionaryList
 {
 	char*word;
 	struct dictionaryList*next;
+	SPELL_NODE node;
 }SPELL_WORD;
 
 static SPELL_WORD*dictionary_hash[HASH_TABLE_SIZE];
 
-static int hashedDictionary;
+static SPELL_NODE*suggestNodes;
+static SPELL_NODE*suggestRoot;
+
+static void BuildSuggestTree(void);
+static void SuggestInsert(SPELL_NODE*word);
+static void SuggestWords(SPELL_NODE*node, char*word, int len, int limit,
+    SPELL_SUGGEST*best);
+static void AddSuggestion(SPELL_SUGGEST*best, char*word, int distance, int
+    weight);
+static void SetPattern(unsigned long long*pattern, char*word, int len);
+static void ClearPattern(unsigned long long*pattern, char*word, int len);
+static int EditDistance(unsigned long long*pattern, int len1, char*word2, int
+    len2);
+
+static int loadedUserWords;
+
+int spell_background;
+
+typedef struct spellSpans_t
+{
+	EDIT_LINE*line;
+	char*text;   /* line->line and len when the line was queued */
+	int len;
+	int serial;  /* wordSerial when the line was queued */
+	int edit;    /* spellEdits when the line was last edited or queued */
+	int*spans;   /* Misspelled start/end columns ended by -1, or 0 for none */
+}SPELL_SPANS;
+
+/* A copy of one line waiting for, or finished by, the spell thread. */
+/* The thread only ever sees the copy, never the EDIT_LINE.          */
+typedef struct spellJob_t
+{
+	struct spellJob_t*next;
+	LINE_CACHE*cache;  /* 0 once the file is closed */
+	EDIT_LINE*line;
+	char*text;
+	int len;
+	int serial;
+	int edit;
+	char*copy;
+	int*spans;
+}SPELL_JOB;
+
+/* spellLock guards the job lists and the user word and ignore lists */
+static OS_MUTEX*spellLock;
+static OS_THREAD*spellThread;
+static int spellRunning;
+static int spellQueued;
+static SPELL_JOB*spellQueue;
+static SPELL_JOB*spellDone;
+static SPELL_JOB*spellActive;
+
+/* Bumped whenever a word is added or ignored so cached lines recheck */
+static int wordSerial;
+
+/* Bumped on every edit and queue. The text pointer and length alone */
+/* can match a newer version of the line, as after overstrike.       */
+static int spellEdits;
+
+static EDIT_FILE*idleFile;
+
+static int SpellLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+static SPELL_SPANS*QueueSpellLine(LINE_CACHE*cache, EDIT_LINE*line, int clear);
+static void StartSpellThread(void);
+static void SpellWorker(void*arg);
+static int*FindMisspelled(char*text, int len);
+static int KnownWord(char*word, int len);
+static void FreeSpellJob(SPELL_JOB*job);
+static void FreeSpans(SPELL_SPANS*entry);
+static void SpellLock(void);
+static void SpellUnlock(void);
 
 typedef struct swapGroups_t
 {
@@ -174,87 +274,6 @@ static SPELL_SWAP_GROUPS swapGroups[] = {
 #define NUM_SWAP_GROUPS ((sizeof(swapGroups)/sizeof(SPELL_SWAP_GROUPS)))
 
 
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void HashDictionary(void)
-{
-	char prev[MAX_COMPRESSED_LEN];
-	char decompressed[MAX_COMPRESSED_LEN];
-	char affix[MAX_COMPRESSED_LEN];
-	char*ptr;
-	int i, newLen, baseLen;
-	int numNibbles = 0;
-	char*nibbles;
-	int index = 0;
-
-	nibbles = OS_Malloc(sizeof(dictionary_words)*2);
-
-	for (i = 0; i < (int)sizeof(dictionary_words); i++) {
-		nibbles[numNibbles] = (dictionary_words[i] >> 4);
-		nibbles[numNibbles + 1] = (dictionary_words[i]&0x0f);
-		numNibbles += 2;
-	}
-
-	while (index < numNibbles - 1) {
-		newLen = 0;
-
-		if (nibbles[index]) {
-			memcpy(&decompressed[newLen], prev, nibbles[index]);
-			newLen += nibbles[index];
-		}
-		index++;
-
-		while (nibbles[index] != 0x0f) {
-			if (nibbles[index] == 0x0d) {
-				index++;
-				decompressed[newLen++] =
-				compressedL2[(unsigned char)nibbles[index++]];
-			} else
-				if (nibbles[index] == 0x0e) {
-					index++;
-					decompressed[newLen++] =
-					compressedL3[(unsigned char)nibbles[index++]];
-				} else {
-					decompressed[newLen++] =
-					compressedL1[(unsigned char)nibbles[index++]];
-				}
-		}
-
-		index++;
-
-		decompressed[newLen] = 0;
-		memcpy(prev, decompressed, newLen + 1);
-
-		ptr = strstr(decompressed, "+");
-
-		if (ptr)
-			HashWord(decompressed, ptr - decompressed);
-		else
-			ptr = strstr(decompressed, "/");
-
-		if (ptr) {
-			baseLen = ptr - decompressed;
-
-			strcpy(affix, ptr + 1);
-
-			for (i = 0; i < (newLen - baseLen) - 1; i++) {
-				strcpy(ptr, suffixes[affix[i]-'a']);
-				HashWord(decompressed, baseLen + strlen(ptr));
-			}
-		} else
-			HashWord(decompressed, newLen);
-	}
-	OS_Free(nibbles);
-
-	/* Add user words. */
-	AddUserWords();
-}
-
-
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -272,13 +291,27 @@ static void HashWord(char*word, int len)
 	newWord->word[0] = (char)len;
 	memcpy(newWord->word + 1, word, len);
 	newWord->word[1 + len] = 0;
+	newWord->node.word = newWord->word + 1;
+	newWord->node.len = len;
+	newWord->node.child = 0;
+	newWord->node.sibling = 0;
 
 	for (i = 0; i < len; i++)
 		hash = ((hash << 5) + hash) + word[i];
 
+	SpellLock();
+
 	newWord->next = dictionary_hash[hash%HASH_TABLE_SIZE];
 
 	dictionary_hash[hash%HASH_TABLE_SIZE] = newWord;
+
+	SpellUnlock();
+
+	wordSerial++;
+
+	/* Words added after the suggestion tree is built go straight in. */
+	if (suggestRoot)
+		SuggestInsert(&newWord->node);
 }
 
 
@@ -295,10 +328,9 @@ int SpellCheck(EDIT_FILE*file, EDIT_CLIPBOARD*clipboard)
 	int selOffset;
 
 
-	if (!hashedDictionary) {
-		CenterBottomBar(0, "[+] One Moment, Preparing Dictionary [+]");
-		HashDictionary();
-		hashedDictionary = 1;
+	if (!loadedUserWords) {
+		AddUserWords();
+		loadedUserWords = 1;
 	}
 
 	if (file->copyStatus&COPY_BLOCK)
@@ -698,6 +730,10 @@ static void AddWordList(int list, char*word, char*fixed)
 {
 	SAVED_WORDS*add, *walk;
 
+	wordSerial++;
+
+	SpellLock();
+
 	walk = wordLists[list];
 
 	/* If Word already exists, just update the fixed component. */
@@ -706,6 +742,7 @@ static void AddWordList(int list, char*word, char*fixed)
 			OS_Free(walk->fixed);
 			walk->fixed = OS_Malloc(strlen(fixed) + 1);
 			strcpy(walk->fixed, fixed);
+			SpellUnlock();
 			return ;
 		}
 		walk = walk->next;
@@ -722,6 +759,8 @@ static void AddWordList(int list, char*word, char*fixed)
 	add->next = wordLists[list];
 
 	wordLists[list] = add;
+
+	SpellUnlock();
 }
 
 
@@ -737,6 +776,18 @@ void FreeWordLists(void)
 	SPELL_WORD*base, *next;
 	int i;
 
+	if (spellThread) {
+		OS_JoinThread(spellThread);
+		spellThread = 0;
+	}
+
+	SpellResults(0);
+
+	if (spellLock) {
+		OS_DestroyMutex(spellLock);
+		spellLock = 0;
+	}
+
 	for (i = 0; i < NUM_WORD_LISTS; i++)
 		FreeWordList(i);
 
@@ -754,7 +805,15 @@ void FreeWordLists(void)
 
 			base = next;
 		}
+
+		dictionary_hash[i] = 0;
 	}
+
+	if (suggestNodes)
+		OS_Free(suggestNodes);
+
+	suggestNodes = 0;
+	suggestRoot = 0;
 }
 
 
@@ -800,6 +859,9 @@ static int LookupWord(char*word, int len)
 	int i;
 	SPELL_WORD*base;
 
+	if (LookupDictionary(word, len))
+		return (1);
+
 	for (i = 0; i < len; i++)
 		hash = ((hash << 5) + hash) + word[i];
 
@@ -817,6 +879,53 @@ static int LookupWord(char*word, int len)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# One probe into the perfect hash. The bucket's seed either picks the     #*/
+/*# slot directly or is rehashed with the word to find it.                  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int LookupDictionary(char*word, int len)
+{
+	unsigned int seed, slot, offset;
+
+	seed = dictionary_seeds[DictionaryHash(word, len, 0) % DICTIONARY_BUCKETS];
+
+	if (seed&DICTIONARY_DIRECT)
+		slot = seed&~DICTIONARY_DIRECT;
+	else
+		slot = DictionaryHash(word, len, seed) % DICTIONARY_WORDS;
+
+	offset = dictionary_offsets[slot];
+
+	if ((int)(dictionary_offsets[slot + 1] - offset) != len + 1)
+		return (0);
+
+	return (!memcmp(&dictionary_pool[offset], word, len));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Must match DictionaryHash in speller/make_dict.c.                       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned int DictionaryHash(char*word, int len, unsigned int seed)
+{
+	unsigned int hash = 2166136261U ^ (seed*0x9e3779b9U);
+	int i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (unsigned char)word[i])*16777619U;
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+
+	return (hash);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -1056,10 +1165,9 @@ static int AddWordChoice(char*word, WORD_LIST*choices)
 /*###########################################################################*/
 static void FullWordScan(char*word, int len, WORD_LIST*choices)
 {
-	WORD_LIST words[MAX_WEIGHTS*2];
-	int weight;
-	int i, j;
-	SPELL_WORD*base;
+	SPELL_SUGGEST best;
+	char lower[MAX_WORD_LEN];
+	int i, limit, maxLimit;
 
 	/* Was this word recently scanned? If so, pull the choices from cache. */
 	if (CheckScanCache(word, choices))
@@ -1069,37 +1177,245 @@ static void FullWordScan(char*word, int len, WORD_LIST*choices)
 
 	choices->fullscan = 1;
 
-	memset(words, 0, sizeof(words));
+	if (!suggestRoot)
+		BuildSuggestTree();
 
-	for (i = 0; i < HASH_TABLE_SIZE; i++) {
-		base = dictionary_hash[i];
+	for (i = 0; i < len; i++)
+		lower[i] = (word[i] >= 'A' && word[i] <= 'Z') ? word[i] + 32 : word[i];
 
-		if (!base)
-			continue;
+	lower[len] = 0;
 
-		while (base) {
-			weight = WeightWord(word, len, base->word + 1, *base->word) +
-			MAX_WEIGHTS;
+	memset(best.pattern, 0, sizeof(best.pattern));
+	SetPattern(best.pattern, lower, len);
+
+	/* Widen the neighborhood one edit at a time until there is a fair    */
+	/* choice of words. Each step visits a much larger part of the tree,  */
+	/* and short words stop early, or every short word would be a match.  */
+	maxLimit = MAX(1, MIN(MAX_SUGGEST_DISTANCE, len - 1));
+
+	for (limit = 1; limit <= maxLimit; limit++) {
+		best.total = 0;
+
+		SuggestWords(suggestRoot, lower, len, limit, &best);
+
+		if (best.total >= MAX_WORDS/2)
+			break;
+	}
+
+	for (i = 0; i < best.total; i++)
+		AddWordChoice(best.words[i], choices);
+
+	AddScanCache(word, choices);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Thread every dictionary word into the BK-tree. This is only done the   #*/
+/*# first time a suggestion is needed.                                      #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void BuildSuggestTree(void)
+{
+	SPELL_WORD*base;
+	SPELL_NODE*node;
+	int i;
+
+	CenterBottomBar(0, "[+] One Moment, Preparing Suggestions [+]");
 
-			if (weight >= MAX_WEIGHTS*2)
-				weight = (MAX_WEIGHTS*2) - 1;
+	suggestNodes = (SPELL_NODE*)OS_Malloc(DICTIONARY_WORDS*sizeof(SPELL_NODE));
 
-			if (weight >= 0)
-				words[weight].words[words[weight].total++%MAX_WORDS] =
-				base->word + 1;
+	/* Slot order is hash order, which keeps the tree well balanced. */
+	for (i = 0; i < DICTIONARY_WORDS; i++) {
+		node = &suggestNodes[i];
+		node->word = (char*)&dictionary_pool[dictionary_offsets[i]];
+		node->len = dictionary_offsets[i + 1] - dictionary_offsets[i] - 1;
+		node->child = 0;
+		node->sibling = 0;
+
+		SuggestInsert(node);
+	}
+
+	for (i = 0; i < HASH_TABLE_SIZE; i++)
+		for (base = dictionary_hash[i]; base; base = base->next)
+			SuggestInsert(&base->node);
+}
 
-			base = base->next;
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SuggestInsert(SPELL_NODE*word)
+{
+	static unsigned long long pattern[256];
+	SPELL_NODE*node, *child;
+	int distance;
+
+	if (!suggestRoot) {
+		suggestRoot = word;
+		return ;
+	}
+
+	SetPattern(pattern, word->word, word->len);
+
+	for (node = suggestRoot; ; node = child) {
+		distance = EditDistance(pattern, word->len, node->word, node->len);
+
+		/* Duplicate words are already reachable through the first copy. */
+		if (!distance)
+			break;
+
+		for (child = node->child; child; child = child->sibling)
+			if (child->distance == distance)
+				break;
+
+		if (!child) {
+			word->distance = distance;
+			word->sibling = node->child;
+			node->child = word;
+			break;
 		}
 	}
 
-	for (i = (MAX_WEIGHTS*2) - 1; i >= 0; i--) {
-		for (j = 0; j < MAX_WORDS; j++) {
-			if (words[i].words[j])
-				AddWordChoice(words[i].words[j], choices);
+	ClearPattern(pattern, word->word, word->len);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Collect the words within limit edits of word. By the triangle          #*/
+/*# inequality only children within limit of the distance to this node can #*/
+/*# hold a match, which prunes most of the tree.                            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SuggestWords(SPELL_NODE*node, char*word, int len, int limit,
+    SPELL_SUGGEST*best)
+{
+	SPELL_NODE*child;
+	int distance;
+
+	distance = EditDistance(best->pattern, len, node->word, node->len);
+
+	if (distance && distance <= limit)
+		AddSuggestion(best, node->word, distance, WeightWord(word, len,
+		    node->word, node->len));
+
+	for (child = node->child; child; child = child->sibling)
+		if (child->distance >= distance - limit && child->distance <= distance +
+		    limit)
+			SuggestWords(child, word, len, limit, best);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Keep the best MAX_WORDS suggestions, fewest edits first, with ties      #*/
+/*# broken by WeightWord.                                                   #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void AddSuggestion(SPELL_SUGGEST*best, char*word, int distance, int
+    weight)
+{
+	int i;
+
+	for (i = best->total; i > 0; i--) {
+		if (best->distance[i - 1] < distance || (best->distance[i - 1] ==
+		    distance && best->weight[i - 1] >= weight))
+			break;
+
+		if (i < MAX_WORDS) {
+			best->words[i] = best->words[i - 1];
+			best->distance[i] = best->distance[i - 1];
+			best->weight[i] = best->weight[i - 1];
 		}
 	}
 
-	AddScanCache(word, choices);
+	if (i >= MAX_WORDS)
+		return ;
+
+	best->words[i] = word;
+	best->distance[i] = distance;
+	best->weight[i] = weight;
+
+	if (best->total < MAX_WORDS)
+		best->total++;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Build the bit masks EditDistance uses for word: bit i of the mask for a #*/
+/*# character is set when word[i] is that character.                       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SetPattern(unsigned long long*pattern, char*word, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		pattern[(unsigned char)word[i]] |= 1ULL << i;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ClearPattern(unsigned long long*pattern, char*word, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		pattern[(unsigned char)word[i]] = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Levenshtein distance from the word in pattern, of length len1, to       #*/
+/*# word2. This is Myers' bit-parallel method: a whole column of the edit   #*/
+/*# table is kept as vertical deltas in two masks, so each character of     #*/
+/*# word2 costs a handful of word operations. Words are under 64 bytes.     #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int EditDistance(unsigned long long*pattern, int len1, char*word2, int
+    len2)
+{
+	unsigned long long plusV, minusV, plusH, minusH, eq, xv, xh, last;
+	int i, distance = len1;
+
+	if (!len1)
+		return (len2);
+
+	plusV = ~0ULL;
+	minusV = 0;
+	last = 1ULL << (len1 - 1);
+
+	for (i = 0; i < len2; i++) {
+		eq = pattern[(unsigned char)word2[i]];
+		xv = eq | minusV;
+		xh = (((eq & plusV) + plusV) ^ plusV) | eq;
+		plusH = minusV | ~(xh | plusV);
+		minusH = plusV & xh;
+
+		if (plusH & last)
+			distance++;
+		else
+			if (minusH & last)
+				distance--;
+
+		plusH = (plusH << 1) | 1;
+		minusH <<= 1;
+		plusV = minusH | ~(xv | plusH);
+		minusV = plusH & xv;
+	}
+
+	return (distance);
 }
 
 
@@ -1215,3 +1531,482 @@ static int WeightWord(char*misspelled, int misspelledLen, char*test,
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Mark the words of a visible line that aren't in the dictionary. A line  #*/
+/*# that hasn't been checked yet is copied to the spell thread and painted  #*/
+/*# without marks, so typing never waits on the dictionary.                 #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void SpellHighlight(EDIT_FILE*file, EDIT_LINE*line, int pan, int len, SCR_PTR
+    *screen, int address, SCR_PTR attr)
+{
+	SPELL_SPANS*entry;
+	int i, column, end;
+
+	if (!(file->file_flags&FILE_FLAG_NORMAL) || !line->len)
+		return ;
+
+	if (!file->spellSpans) {
+		if (!loadedUserWords) {
+			AddUserWords();
+			loadedUserWords = 1;
+		}
+
+		file->spellSpans = CreateLineCache(sizeof(SPELL_SPANS),
+		    (LINE_CACHE_PFN*)FreeSpans);
+
+		AddLineCallback(file, (LINE_PFN*)SpellLineHandler, LINE_OP_EDIT |
+		    LINE_OP_DELETE | LINE_OP_INSERT_CHAR);
+	}
+
+	entry = (SPELL_SPANS*)FindLineEntry(file->spellSpans, line);
+
+	if (!entry || entry->text != line->line || entry->len != line->len)
+		entry = QueueSpellLine(file->spellSpans, line, 1);
+	else
+		if (entry->serial != wordSerial)
+			entry = QueueSpellLine(file->spellSpans, line, 0);
+
+	for (i = 0; entry->spans && entry->spans[i] >= 0; i += 2) {
+		column = MAX(entry->spans[i], pan);
+		end = MIN(entry->spans[i + 1], pan + len);
+
+		for (; column < end; column++)
+			screen[address + (column - pan)*2] = (SCR_PTR)((screen[address +
+			    (column - pan)*2]&0x0f) | attr);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Move the lines the spell thread has finished into their file's cache.   #*/
+/*# Returns nonzero if the marks of file changed.                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int SpellResults(EDIT_FILE*file)
+{
+	SPELL_JOB*job, *next;
+	SPELL_SPANS*entry;
+	int changed = 0;
+
+	SpellLock();
+
+	job = spellDone;
+	spellDone = 0;
+
+	SpellUnlock();
+
+	for (; job; job = next) {
+		next = job->next;
+
+		entry = job->cache ? (SPELL_SPANS*)FindLineEntry(job->cache,
+		    job->line) : 0;
+
+		/* Lines edited since they were queued are already queued again */
+		if (entry && entry->text == job->text && entry->len == job->len &&
+		    entry->serial == job->serial && entry->edit == job->edit) {
+			if (entry->spans || job->spans) {
+				if (file && file->spellSpans == job->cache)
+					changed = 1;
+
+				InvalidateLine(job->line);
+			}
+
+			if (entry->spans)
+				OS_Free(entry->spans);
+
+			entry->spans = job->spans;
+			job->spans = 0;
+		}
+
+		FreeSpellJob(job);
+	}
+
+	return (changed);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Called from the clock while the editor waits for a key. Repaints the    #*/
+/*# file being edited if new marks came in, and without a spell thread this #*/
+/*# is where the queued lines get checked.                                  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void PollSpellCheck(void)
+{
+	if (!spell_background)
+		return ;
+
+	if (!spellThread && spellQueue)
+		SpellWorker(0);
+
+	if (SpellResults(idleFile)) {
+		idleFile->paint_flags |= CONTENT_FLAG | CURSOR_FLAG;
+		Paint(idleFile);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The top level loop sets the file it is waiting on input for, and 0      #*/
+/*# once the key arrives, so PollSpellCheck never paints under a dialog.    #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void SpellIdle(EDIT_FILE*file)
+{
+	idleFile = file;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeSpellSpans(EDIT_FILE*file)
+{
+	LINE_CACHE*cache = file->spellSpans;
+	SPELL_JOB**walk;
+	SPELL_JOB*job;
+
+	if (!cache)
+		return ;
+
+	if (idleFile == file)
+		idleFile = 0;
+
+	SpellLock();
+
+	for (walk = &spellQueue; *walk; ) {
+		job = *walk;
+
+		if (job->cache == cache) {
+			*walk = job->next;
+			spellQueued--;
+			FreeSpellJob(job);
+		} else
+			walk = &job->next;
+	}
+
+	for (job = spellDone; job; job = job->next)
+		if (job->cache == cache)
+			job->cache = 0;
+
+	if (spellActive && spellActive->cache == cache)
+		spellActive->cache = 0;
+
+	SpellUnlock();
+
+	FreeLineCache(cache);
+	file->spellSpans = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int SpellLineHandler(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
+{
+	SPELL_SPANS*entry;
+
+	op = op;
+	arg = arg;
+
+	if (file->spellSpans) {
+		entry = (SPELL_SPANS*)FindLineEntry(file->spellSpans, line);
+
+		if (entry) {
+			entry->text = 0;
+			entry->edit = ++spellEdits;
+		}
+	}
+
+	return (0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Hand a copy of line to the spell thread. The newest lines are taken     #*/
+/*# first so the lines on screen now win over ones scrolled past, and once  #*/
+/*# the queue is full the oldest line is dropped to be queued again when    #*/
+/*# it is next painted.                                                     #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static SPELL_SPANS*QueueSpellLine(LINE_CACHE*cache, EDIT_LINE*line, int clear)
+{
+	SPELL_SPANS*entry, *other;
+	SPELL_JOB*job, *dropped = 0;
+	SPELL_JOB**walk;
+
+	entry = (SPELL_SPANS*)AddLineEntry(cache, line);
+
+	if (clear && entry->spans) {
+		OS_Free(entry->spans);
+		entry->spans = 0;
+	}
+
+	entry->text = line->line;
+	entry->len = line->len;
+	entry->serial = wordSerial;
+	entry->edit = ++spellEdits;
+
+	job = (SPELL_JOB*)OS_Malloc(sizeof(SPELL_JOB));
+
+	job->cache = cache;
+	job->line = line;
+	job->text = line->line;
+	job->len = line->len;
+	job->serial = wordSerial;
+	job->edit = entry->edit;
+	job->spans = 0;
+	job->copy = OS_Malloc(line->len);
+	memcpy(job->copy, line->line, line->len);
+
+	SpellLock();
+
+	job->next = spellQueue;
+	spellQueue = job;
+
+	if (++spellQueued > MAX_SPELL_JOBS) {
+		for (walk = &spellQueue; (*walk)->next; walk = &(*walk)->next)
+			;
+
+		dropped = *walk;
+		*walk = 0;
+		spellQueued--;
+	}
+
+	SpellUnlock();
+
+	if (dropped) {
+		other = (SPELL_SPANS*)FindLineEntry(dropped->cache, dropped->line);
+
+		if (other && other->edit == dropped->edit)
+			other->text = 0;
+
+		FreeSpellJob(dropped);
+	}
+
+	StartSpellThread();
+
+	return (entry);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The thread exits when the queue runs dry and is started again by the    #*/
+/*# next line queued. Without threads or a lock the lines are checked by    #*/
+/*# PollSpellCheck instead.                                                 #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void StartSpellThread(void)
+{
+	int running;
+
+	if (!spellLock)
+		spellLock = OS_CreateMutex();
+
+	if (!spellLock)
+		return ;
+
+	if (spellThread) {
+		SpellLock();
+		running = spellRunning;
+		SpellUnlock();
+
+		if (running)
+			return ;
+
+		OS_JoinThread(spellThread);
+		spellThread = 0;
+	}
+
+	spellRunning = 1;
+
+	spellThread = OS_CreateThread((OS_THREAD_PFN*)SpellWorker, 0);
+
+	if (!spellThread)
+		spellRunning = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SpellWorker(void*arg)
+{
+	SPELL_JOB*job;
+
+	arg = arg;
+
+	for (; ; ) {
+		SpellLock();
+
+		job = spellQueue;
+
+		if (job) {
+			spellQueue = job->next;
+			spellQueued--;
+		} else
+			spellRunning = 0;
+
+		spellActive = job;
+
+		SpellUnlock();
+
+		if (!job)
+			return ;
+
+		job->spans = FindMisspelled(job->copy, job->len);
+
+		SpellLock();
+
+		job->next = spellDone;
+		spellDone = job;
+		spellActive = 0;
+
+		SpellUnlock();
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Split a line into words the same way SpellCheckLine does. Returns the   #*/
+/*# start/end columns of the unknown words ended by -1, or 0 for none.      #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int*FindMisspelled(char*text, int len)
+{
+	int found[MAX_SPELL_SPANS*2];
+	int*spans;
+	int i, index, total = 0;
+
+	for (i = 0; i < len && total < MAX_SPELL_SPANS*2; i++) {
+		if (WordText(text[i])) {
+			index = i;
+
+			while (i < len && WordText(text[i]))
+				i++;
+
+			if (!KnownWord(&text[index], i - index)) {
+				found[total++] = index;
+				found[total++] = i;
+			}
+		}
+	}
+
+	if (!total)
+		return (0);
+
+	spans = (int*)OS_Malloc((total + 1)*sizeof(int));
+	memcpy(spans, found, total*sizeof(int));
+	spans[total] = -1;
+
+	return (spans);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The same words CheckSpelling lets through. The dictionary image is read #*/
+/*# only, so only the user's words need the lock.                           #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int KnownWord(char*word, int len)
+{
+	char test[MAX_WORD_LEN];
+	int i, known;
+
+	if (len >= MAX_WORD_LEN || len < MIN_WORD_LEN || word[0] == '\'')
+		return (1);
+
+	for (i = 0; i < len; i++)
+		if (word[i] >= 'A' && word[i] <= 'Z')
+			test[i] = (char)(word[i] + 32);
+		else
+			test[i] = word[i];
+
+	test[len] = 0;
+
+	if (LookupDictionary(test, len))
+		return (1);
+
+	SpellLock();
+
+	known = LookupWord(test, len) || CheckWordList(WORD_LIST_IGNORE, test);
+
+	SpellUnlock();
+
+	return (known);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeSpellJob(SPELL_JOB*job)
+{
+	if (job->spans)
+		OS_Free(job->spans);
+
+	OS_Free(job->copy);
+	OS_Free(job);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeSpans(SPELL_SPANS*entry)
+{
+	if (entry->spans)
+		OS_Free(entry->spans);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SpellLock(void)
+{
+	if (spellLock)
+		OS_LockMutex(spellLock);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void SpellUnlock(void)
+{
+	if (spellLock)
+		OS_UnlockMutex(spellLock);
+}
+
+
@@ -31,132 +31,42 @@
 #include <string.h>
 #include <stdlib.h>
 
-#if 0
-#define DEBUG
-#endif
-
-static char*suffixList[] = {
-	"ness's",
-	"ion's",
-	"ions",
-	"ness",
-	"able",
-	"ings",
-	"ive",
-	"ion",
-	"ing",
-	"ers",
-	"ies",
-	"ier",
-	"ant",
-	"e's",
-	"y's",
-	"r's",
-	"'s",
-	"en",
-	"ry",
-	"ly",
-	"ed",
-	"er",
-	"st",
-	"rs",
-	"es",
-	"r",
-	"d",
-	"s",
-	"y",
-	"e",
-};
-
 #define MAX_WORD_LEN       32
 
-#define NUM_CHAR_FREQ 256
-
-typedef struct characterFrequency
-{
-	char ch;
-	int occurances;
-}CHAR_FREQ;
-
-typedef struct suffixFrequency
-{
-	char ch;
-	int suffix;
-	int occurances;
-}SUFFIX_FREQ;
-
-static char compressedL1[16];
-static char compressedL2[16];
-static char compressedL3[16];
-
-static CHAR_FREQ charFreq[NUM_CHAR_FREQ];
-
-static int charLevel[256];
-static char charLookup[256];
-
-#define NUM_SFX (sizeof(suffixList)/sizeof(char *))
+#define HASH_TABLE_SIZE 160000
 
-#define ALPHA_LOW    'a'
-#define ALPHA_HIGH   '~'
+/* Average words per perfect hash bucket */
+#define BUCKET_LOAD 4
 
-#define HASH_TABLE_SIZE 160000
+/* Seeds with this bit set hold the slot of a single word bucket directly */
+#define SEED_DIRECT 0x80000000U
 
 typedef struct dictionaryList
 {
 	char*word;
-	char suffix;
 	struct dictionaryList*next;
 }SPELL_WORD;
 
-static int nibbleIndex;
-static char*nibbles;
 static int numSorted;
-static int allocSize;
+static int numBuckets;
 
-static SUFFIX_FREQ suffixFreq[NUM_SFX];
-static SPELL_WORD*suffix_hash[HASH_TABLE_SIZE];
 static SPELL_WORD*word_hash[HASH_TABLE_SIZE];
 static SPELL_WORD*sorted[HASH_TABLE_SIZE];
 
-static void HashSuffix(char*word, int len, int suffix);
+static unsigned int*seeds;
+static int*slots;
+static int*bucketSize;
+
 static void HashWord(char*word, int len);
 static int HashIt(char*word, int len);
-static int SortChar(const void*arg1, const void*arg2);
 static int LoadDict(char*dict);
-static SPELL_WORD*WordLookup(char*word, int len);
-static void OtherSuffixCheck(char*root, int len, int suffix);
 static void SortHash(SPELL_WORD*words);
 static int SortWords(const void*arg1, const void*arg2);
-static void CompressPrefixes(void);
-static void PrintStrings(FILE*fp, SPELL_WORD*words);
-static void CompressLine(char*line, int len);
-static int SortCharFreq(const void*arg1, const void*arg2);
-static void BuildFreqTable(void);
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static SPELL_WORD*WordLookup(char*word, int len)
-{
-	SPELL_WORD*walk;
-
-	/* Check to see if other suffixs match this root word. */
-	walk = word_hash[HashIt(word, len)];
-
-	while (walk) {
-		if (walk->word) {
-			if (!strcmp(walk->word, word))
-				return (walk);
-		}
-		walk = walk->next;
-	}
-
-	return (0);
-}
+static int SortBuckets(const void*arg1, const void*arg2);
+static unsigned int DictionaryHash(char*word, int len, unsigned int seed);
+static int BuildPerfectHash(void);
+static int PlaceBucket(int*members, int count, unsigned int seed, int*trial);
+static void WriteDictionary(char*filename);
 
 
 /*###########################################################################*/
@@ -167,14 +77,7 @@ static SPELL_WORD*WordLookup(char*word, int len)
 /*###########################################################################*/
 int main(int argv, char**argc)
 {
-	int i, j, len, alen;
-	char*word;
-	FILE*fp;
-	char list[50];
-	char item[20];
-	char flag;
-	int total;
-	SPELL_WORD*hashWalk, *hashWalk2;
+	int i;
 
 	if (argv >= 2) {
 		for (i = 1; i < argv; i++)
@@ -182,318 +85,235 @@ int main(int argv, char**argc)
 	} else
 		LoadDict("dictionary.txt");
 
-	printf("Creating wordlist.tmp\n");
+	printf("Sorting words\n");
 
-	fp = fopen("wordlist.tmp", "w");
 	for (i = 0; i < HASH_TABLE_SIZE; i++)
-		PrintStrings(fp, word_hash[i]);
-	fclose(fp);
-
-	printf("Processing suffixes\n");
-
-	/* Walk through all of the hashed words looking for suffixes. */
-	for (j = 0; j < NUM_SFX; j++) {
-		alen = strlen(suffixList[j]);
-
-		for (i = 0; i < HASH_TABLE_SIZE; i++) {
-			hashWalk = word_hash[i];
-
-			while (hashWalk) {
-				if (hashWalk->word && !hashWalk->suffix) {
-					len = strlen(hashWalk->word);
+		SortHash(word_hash[i]);
 
-					if (len > alen) {
-						/* Did we find a suffix in this word? If so, add it to */
-						/* the suffix hash table and remove it from the word   */
-						/* hash table.                                         */
-						if (!strcmp(&hashWalk->word[len - alen],
-						    suffixList[j])) {
-							word = hashWalk->word;
+	qsort(sorted, numSorted, sizeof(SPELL_WORD*), SortWords);
 
-							word[len - alen] = 0;
+	printf("Building perfect hash\n");
 
-							suffixFreq[j].suffix = j;
-							suffixFreq[j].occurances++;
+	if (!BuildPerfectHash()) {
+		printf("\nError, Unable to build a perfect hash for %d words\n",
+		    numSorted);
+		return (1);
+	}
 
-							HashSuffix(word, len - alen, j);
+	printf("Creating dictionary.h\n");
 
-							/* If there is a root word, mark it. */
-							hashWalk2 = WordLookup(word, len - alen);
+	WriteDictionary("dictionary.h");
 
-							if (hashWalk2)
-								hashWalk2->suffix = 1;
+	return (0);
+}
 
-							/* Remove this suffix word from the word list because */
-							/* it's now located on the suffix list.               */
-							hashWalk->word = 0;
 
-							/* Process this suffix, and all other suffixes that */
-							/* use this same root word.                         */
-							OtherSuffixCheck(word, len - alen, j);
-						}
-					}
-				}
-				hashWalk = hashWalk->next;
-			}
-		}
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Hash, and displace. Every word hashes with seed 0 into one of           #*/
+/*# numBuckets buckets, and each bucket gets a seed that sends all of its   #*/
+/*# words to free slots. Big buckets are placed first while the table is    #*/
+/*# still empty, and single word buckets just take whatever slots are left. #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int BuildPerfectHash(void)
+{
+	int*order;
+	int*heads;
+	int*next;
+	int*trial;
+	int*members;
+	int i, j, bucket, count, freeSlot;
+	unsigned int seed;
+
+	numBuckets = numSorted / BUCKET_LOAD + 1;
+
+	seeds = calloc(numBuckets, sizeof(unsigned int));
+	bucketSize = calloc(numBuckets, sizeof(int));
+	order = malloc(numBuckets*sizeof(int));
+	heads = malloc(numBuckets*sizeof(int));
+	next = malloc(numSorted*sizeof(int));
+	slots = malloc(numSorted*sizeof(int));
+	trial = calloc(numSorted, sizeof(int));
+	members = malloc(numSorted*sizeof(int));
+
+	for (i = 0; i < numBuckets; i++) {
+		heads[i] = -1;
+		order[i] = i;
 	}
 
-	printf("Combining suffixes\n");
-
-	/* Find all duplicate root words and combine their suffixes into one */
-	/* word + suffix list.                                               */
-	for (i = 0; i < HASH_TABLE_SIZE; i++) {
-		hashWalk = suffix_hash[i];
-
-		while (hashWalk) {
-			if (hashWalk->word) {
-				sprintf(list, "%c", ALPHA_LOW + hashWalk->suffix);
-				total = 0;
-
-				hashWalk2 = suffix_hash[HashIt(hashWalk->word,
-				    strlen(hashWalk->word))];
-
-				while (hashWalk2) {
-					if (hashWalk2->word) {
-						if (hashWalk2->word != hashWalk->word) {
-							if (!strcmp(hashWalk2->word, hashWalk->word)) {
-								sprintf(item, "%c", ALPHA_LOW + hashWalk2->
-								    suffix);
-								strcat(list, item);
-								hashWalk2->word = 0;
-								total++;
-							}
-						}
-					}
-					hashWalk2 = hashWalk2->next;
-				}
-
-				flag = '/';
-
-				/* Check if this root word exists by itself. If so, them mark */
-				/* the suffix list using a '+' to indicate that the root word */
-				/* is also a word by itself with adding any suffixes to it.   */
-				hashWalk2 = word_hash[HashIt(hashWalk->word, strlen(hashWalk->
-				    word))];
-
-				while (hashWalk2) {
-					/* Is this a root word? */
-					if (hashWalk2->word) {
-						if (!strcmp(hashWalk->word, hashWalk2->word)) {
-							flag = '+';
-							hashWalk2->word = 0;
-							break;
-						}
-					}
-					hashWalk2 = hashWalk2->next;
-				}
-
-				/* Is this a single word with a single suffix?  If the suffix is */
-				/* less than 2 characters, then don't bother because we're not   */
-				/* saving any space by using the suffex.                         */
-				if (!total && (flag == '/') && (strlen(suffixList[(int)
-				    hashWalk->suffix]) <= 2)) {
-					word = (char*)malloc(40);
-					sprintf(word, "%s%s", hashWalk->word, suffixList[(int)
-					    hashWalk->suffix]);
-					hashWalk->word = word;
-				} else {
-					word = (char*)malloc(40);
-					qsort(list, strlen(list), 1, SortChar);
-					sprintf(word, "%s%c%s", hashWalk->word, flag, list);
-					hashWalk->word = word;
-				}
-			}
-			hashWalk = hashWalk->next;
-		}
-	}
+	for (i = 0; i < numSorted; i++) {
+		bucket = DictionaryHash(sorted[i]->word, strlen(sorted[i]->word), 0)
+		    %numBuckets;
 
-	printf("Sorting words\n");
-	for (i = 0; i < HASH_TABLE_SIZE; i++) {
-		SortHash(word_hash[i]);
-		SortHash(suffix_hash[i]);
+		next[i] = heads[bucket];
+		heads[bucket] = i;
+		bucketSize[bucket]++;
+		slots[i] = -1;
 	}
 
-	qsort(sorted, numSorted, sizeof(SPELL_WORD*), SortWords);
+	qsort(order, numBuckets, sizeof(int), SortBuckets);
 
-	printf("Creating suffixes.tmp\n");
+	freeSlot = 0;
 
-	fp = fopen("suffixes.tmp", "w");
-	for (i = 0; i < numSorted; i++)
-		fprintf(fp, "%s\n", sorted[i]->word);
-	fclose(fp);
+	for (i = 0; i < numBuckets; i++) {
+		bucket = order[i];
 
-	printf("Compressing words\n");
+		for (count = 0, j = heads[bucket]; j != -1; j = next[j])
+			members[count++] = j;
 
-	CompressPrefixes();
+		if (!count)
+			continue;
 
-	BuildFreqTable();
+		if (count == 1) {
+			while (slots[freeSlot] != -1)
+				freeSlot++;
 
-	nibbles = malloc(allocSize*2);
-	nibbleIndex = 0;
+			slots[freeSlot] = members[0];
+			seeds[bucket] = SEED_DIRECT | freeSlot;
+			continue;
+		}
 
-	for (i = 0; i < numSorted; i++)
-		CompressLine(sorted[i]->word, strlen(sorted[i]->word));
+		for (seed = 1; seed < SEED_DIRECT; seed++)
+			if (PlaceBucket(members, count, seed, trial))
+				break;
 
-	if (nibbleIndex&1)
-		nibbles[nibbleIndex++] = 0xf;
+		if (seed == SEED_DIRECT)
+			return (0);
 
-	printf("Creating dictionary.h\n");
+		seeds[bucket] = seed;
+	}
 
-	fp = fopen("dictionary.h", "w");
-
-	fprintf(fp,
-	    "/*###########################################################################*/\n");
-	fprintf(fp,
-	    "/*#                                                                         #*/\n");
-	fprintf(fp,
-	    "/*#              ProEdit MP Multi-platform Programming Editor               #*/\n");
-	fprintf(fp,
-	    "/*#                                                                         #*/\n");
-	fprintf(fp,
-	    "/*#           Designed/Developed/Produced by Adrian J. Michaud              #*/\n");
-	fprintf(fp,
-	    "/*#                                                                         #*/\n");
-	fprintf(fp,
-	    "/*#        (C) 2006-2007 by Adrian J. Michaud. All Rights Reserved.         #*/\n");
-	fprintf(fp,
-	    "/*#                                                                         #*/\n");
-	fprintf(fp,
-	    "/*#      Unpublished - rights reserved under the Copyright Laws of the      #*/\n");
-	fprintf(fp,
-	    "/*#      United States.  Use, duplication, or disclosure by the             #*/\n");
-	fprintf(fp,
-	    "/*#      Government is subject to restrictions as set forth in              #*/\n");
-	fprintf(fp,
-	    "/*#      subparagraph (c)(1)(ii) of the Rights in Technical Data and        #*/\n");
-	fprintf(fp,
-	    "/*#      Computer Software clause at 252.227-7013.                          #*/\n");
-	fprintf(fp,
-	    "/*#                                                                         #*/\n");
-	fprintf(fp,
-	    "/*#      This software contains information of a proprietary nature         #*/\n");
-	fprintf(fp,
-	    "/*#      and is classified confidential.                                    #*/\n");
-	fprintf(fp,
-	    "/*#                                                                         #*/\n");
-	fprintf(fp,
-	    "/*#      ALL INFORMATION CONTAINED HEREIN SHALL BE KEPT IN CONFIDENCE.      #*/\n");
-	fprintf(fp,
-	    "/*#                                                                         #*/\n");
-	fprintf(fp,
-	    "/*###########################################################################*/\n");
-
-	fprintf(fp, "\n");
-
-	fprintf(fp, "\nstatic char compressedL1[] = {\n   ");
-	for (i = 0; i < sizeof(compressedL1); i++)
-		if (compressedL1[i])
-			fprintf(fp, "0x%02x,", compressedL1[i]);
-	fprintf(fp, "\n};\n");
+	free(order);
+	free(heads);
+	free(next);
+	free(trial);
+	free(members);
 
-	fprintf(fp, "\nstatic char compressedL2[] = {\n   ");
-	for (i = 0; i < sizeof(compressedL2); i++)
-		if (compressedL2[i])
-			fprintf(fp, "0x%02x,", compressedL2[i]);
-	fprintf(fp, "\n};\n");
+	return (1);
+}
 
-	fprintf(fp, "\nstatic char compressedL3[] = {\n   ");
-	for (i = 0; i < sizeof(compressedL3); i++)
-		if (compressedL3[i])
-			fprintf(fp, "0x%02x,", compressedL3[i]);
-	fprintf(fp, "\n};\n");
 
-	fprintf(fp, "\n");
-	fprintf(fp, "\nstatic char *suffixes[] = {\n");
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Try one seed for a bucket. The slots are only taken if every word in    #*/
+/*# the bucket lands on a different free slot. trial remembers which seed   #*/
+/*# last claimed a slot, so it never needs clearing between attempts.       #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int PlaceBucket(int*members, int count, unsigned int seed, int*trial)
+{
+	int i, slot;
+	static int attempt;
 
-	for (i = 0; i < NUM_SFX; i++) {
-		if (suffixFreq[i].occurances)
-			fprintf(fp, "  \"%s\", \t/* %d hits */\n", suffixList[i],
-			    suffixFreq[i].occurances);
-		else
-			fprintf(fp, "  (char*)0, \t/* \"%s\" */\n", suffixList[i]);
-	}
+	attempt++;
 
-	fprintf(fp, "};\n\n");
+	for (i = 0; i < count; i++) {
+		slot = DictionaryHash(sorted[members[i]]->word, strlen(sorted[
+		    members[i]]->word), seed) % numSorted;
 
+		if (slots[slot] != -1 || trial[slot] == attempt)
+			return (0);
 
-	fprintf(fp, "\nstatic unsigned char dictionary_words[]= {\n");
+		trial[slot] = attempt;
+	}
 
-	total = 0;
-	for (i = 0; i < nibbleIndex; i += 2) {
-		fprintf(fp, "0x%02x,", ((unsigned char)(nibbles[i] << 4) | (unsigned
-		    char)nibbles[i + 1]));
+	for (i = 0; i < count; i++) {
+		slot = DictionaryHash(sorted[members[i]]->word, strlen(sorted[
+		    members[i]]->word), seed) % numSorted;
 
-		if (++total >= 15) {
-			total = 0;
-			fprintf(fp, "\n");
-		}
+		slots[slot] = members[i];
 	}
 
-	fprintf(fp, "\n};\n");
-	fclose(fp);
-	return (0);
+	return (1);
 }
 
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# FNV-1a with a murmur style finish. spell.c and test_dict.c carry the    #*/
+/*# same function and must stay in step with this one.                     #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void PrintStrings(FILE*fp, SPELL_WORD*words)
+static unsigned int DictionaryHash(char*word, int len, unsigned int seed)
 {
-	while (words) {
-		if (words->word)
-			fprintf(fp, "%s\n", words->word);
-		words = words->next;
-	}
+	unsigned int hash = 2166136261U ^ (seed*0x9e3779b9U);
+	int i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (unsigned char)word[i])*16777619U;
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+
+	return (hash);
 }
 
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# The words are written out in slot order, each one null terminated, so  #*/
+/*# a word's length is the gap to the next offset less one.                 #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static void OtherSuffixCheck(char*root, int len, int suffix)
+static void WriteDictionary(char*filename)
 {
-	int i, alen;
-	char newword[64];
-	SPELL_WORD*word;
-
+	FILE*fp;
+	int i, j, len, total, offset;
+	char*word;
 
-	for (i = 0; i < NUM_SFX; i++) {
-		if (i == suffix)
-			continue;
+	fp = fopen(filename, "w");
+
+	fprintf(fp, "/*\n");
+	fprintf(fp, " *\n");
+	fprintf(fp, " * ProEdit MP Multi-platform Programming Editor\n");
+	fprintf(fp, " * Designed/Developed/Produced by Adrian Michaud\n");
+	fprintf(fp, " *\n");
+	fprintf(fp, " * MIT License\n");
+	fprintf(fp, " *\n");
+	fprintf(fp, " * Copyright (c) 2019 Adrian Michaud\n");
+	fprintf(fp, " *\n");
+	fprintf(fp, " * Generated by make_dict, do not edit.\n");
+	fprintf(fp, " *\n");
+	fprintf(fp, " */\n");
+
+	fprintf(fp, "\n#define DICTIONARY_WORDS   %d\n", numSorted);
+	fprintf(fp, "#define DICTIONARY_BUCKETS %d\n", numBuckets);
+	fprintf(fp, "#define DICTIONARY_DIRECT  0x%08xU\n", SEED_DIRECT);
+
+	fprintf(fp, "\nstatic const unsigned int dictionary_seeds[] = {");
+
+	for (i = 0; i < numBuckets; i++) {
+		fprintf(fp, "%s", (i % 8) ? "" : "\n\t");
+		fprintf(fp, (seeds[i]&SEED_DIRECT) ? "0x%x," : "%u,", seeds[i]);
+	}
 
-		alen = strlen(suffixList[i]);
+	fprintf(fp, "\n};\n");
 
-		sprintf(newword, "%s%s", root, suffixList[i]);
+	fprintf(fp, "\nstatic const unsigned int dictionary_offsets[] = {");
 
-		#ifdef DEBUG
-		printf("Checking %s (%s and %s)\n", newword, root, suffixList[i]);
-		#endif
+	for (offset = 0, i = 0; i <= numSorted; i++) {
+		fprintf(fp, "%s%d,", (i % 10) ? "" : "\n\t", offset);
 
-		word = WordLookup(newword, len + alen);
+		if (i < numSorted)
+			offset += strlen(sorted[slots[i]]->word) + 1;
+	}
 
-		if (word) {
-			#ifdef DEBUG
-			printf("Found '%s'\n", newword);
-			#endif
+	fprintf(fp, "\n};\n");
 
-			suffixFreq[i].suffix = i;
-			suffixFreq[i].occurances++;
+	fprintf(fp, "\nstatic const char dictionary_pool[] = {");
 
-			HashSuffix(root, len, i);
+	for (total = 0, i = 0; i < numSorted; i++) {
+		word = sorted[slots[i]]->word;
+		len = strlen(word);
 
-			/* Remove this suffix word from the word list because */
-			/* it's now located on the suffix list.               */
-			word->word = 0;
-		}
+		for (j = 0; j <= len; j++, total++)
+			fprintf(fp, "%s%d,", (total % 24) ? "" : "\n\t", word[j]);
 	}
+
+	fprintf(fp, "\n};\n");
+	fclose(fp);
 }
 
 
@@ -519,40 +339,15 @@ static void SortHash(SPELL_WORD*words)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-static int SortChar(const void*arg1, const void*arg2)
+static int SortBuckets(const void*arg1, const void*arg2)
 {
-	char c1, c2;
+	int bucket1 = *(int*)arg1;
+	int bucket2 = *(int*)arg2;
 
-	c1 = *(char*)arg1;
-	c2 = *(char*)arg2;
-
-	return (c1 - c2);
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void HashSuffix(char*word, int len, int suffix)
-{
-	int index;
-	SPELL_WORD*newWord;
-
-	newWord = malloc(sizeof(SPELL_WORD));
-	newWord->suffix = (char)suffix;
-	newWord->word = malloc(len + 1);
-	memcpy(newWord->word, word, len);
-	newWord->word[len] = 0;
-
-	index = HashIt(word, len);
-
-	newWord->next = suffix_hash[index];
-
-	suffix_hash[index] = newWord;
+	if (bucketSize[bucket1] != bucketSize[bucket2])
+		return (bucketSize[bucket2] - bucketSize[bucket1]);
 
+	return (bucket1 - bucket2);
 }
 
 
@@ -569,7 +364,6 @@ static void HashWord(char*word, int len)
 
 	newWord = malloc(sizeof(SPELL_WORD));
 	newWord->word = malloc(len + 1);
-	newWord->suffix = 0;
 	memcpy(newWord->word, word, len);
 	newWord->word[len] = 0;
 
@@ -697,182 +491,3 @@ static int SortWords(const void*arg1, const void*arg2)
 
 	return (strcmp(word1->word, word2->word));
 }
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static int SortCharFreq(const void*arg1, const void*arg2)
-{
-	CHAR_FREQ*freq1 = (CHAR_FREQ*)arg1;
-	CHAR_FREQ*freq2 = (CHAR_FREQ*)arg2;
-
-	return (freq2->occurances - freq1->occurances);
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void CompressPrefixes(void)
-{
-	int i, j, len;
-
-	char previous[64];
-
-	strcpy(previous, "");
-
-	for (j = 0; j < numSorted; j++) {
-		len = strlen(sorted[j]->word);
-
-		if (strlen(previous)) {
-			for (i = 0; i < len; i++)
-				if (previous[i] != sorted[j]->word[i])
-					break;
-
-			strcpy(previous, sorted[j]->word);
-
-			if (i >= 2) {
-				if (i > 15)
-					i = 15;
-
-				sprintf(sorted[j]->word, "%c%s", (unsigned char)(0xF0 | i), &
-				    previous[i]);
-			}
-		} else
-			strcpy(previous, sorted[j]->word);
-	}
-
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void CompressLine(char*line, int len)
-{
-	int i;
-
-	for (i = 0; i < len; i++) {
-		if (i == 0) {
-			if ((unsigned char)line[i] >= 0xf0) {
-				nibbles[nibbleIndex++] = (unsigned char)line[i]&0xf;
-				continue;
-			} else
-				nibbles[nibbleIndex++] = 0x00;
-		}
-
-		switch (charLevel[(unsigned char)line[i]]) {
-		case 1 :
-			nibbles[nibbleIndex++] = charLookup[(unsigned char)line[i]];
-			break;
-
-		case 2 :
-			nibbles[nibbleIndex++] = 0x0d;
-			nibbles[nibbleIndex++] = charLookup[(unsigned char)line[i]];
-			break;
-
-		case 3 :
-			nibbles[nibbleIndex++] = 0x0e;
-			nibbles[nibbleIndex++] = charLookup[(unsigned char)line[i]];
-			break;
-
-			default :
-			{
-				printf("\nError, Unknown byte '%c' 0x%02x at offset %d\n", (
-				    unsigned char)line[i], (unsigned char)line[i], i);
-				exit(0);
-			}
-		}
-	}
-
-	nibbles[nibbleIndex++] = 0xf;
-}
-
-
-/*###########################################################################*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
-/*###########################################################################*/
-static void BuildFreqTable(void)
-{
-	int i;
-	int len, j;
-	unsigned char ch;
-
-	memset(charFreq, 0, sizeof(charFreq));
-	allocSize = 0;
-
-	for (i = 0; i < numSorted; i++) {
-		len = strlen(sorted[i]->word);
-
-		for (j = 0; j < len; j++) {
-			ch = sorted[i]->word[j];
-
-			if (ch >= 0xf0)
-				continue;
-
-			charFreq[ch].ch = ch;
-			charFreq[ch].occurances++;
-		}
-		allocSize += len;
-	}
-
-	qsort(charFreq, 256, sizeof(CHAR_FREQ), SortCharFreq);
-
-	for (i = 0; i < 13; i++) {
-		ch = charFreq[i].ch;
-		compressedL1[i] = ch;
-		charLevel[ch] = 1;
-		charLookup[ch] = i;
-	}
-
-	for (i = 0; i < 13; i++) {
-		ch = charFreq[i + 13].ch;
-		compressedL2[i] = ch;
-		charLevel[ch] = 2;
-		charLookup[ch] = i;
-	}
-
-	for (i = 0; i < 13; i++) {
-		ch = charFreq[i + 26].ch;
-		compressedL3[i] = ch;
-		charLevel[ch] = 3;
-		charLookup[ch] = i;
-	}
-
-	printf("\nLevel 1:");
-	for (i = 0; i < 13; i++)
-		if (compressedL1[i])
-			printf("%c=%d ", compressedL1[i], i);
-
-	printf("\nLevel 2:");
-	for (i = 0; i < 13; i++)
-		if (compressedL2[i])
-			printf("%c=%d ", compressedL2[i], i);
-
-	printf("\nLevel 3:");
-	for (i = 0; i < 13; i++)
-		if (compressedL3[i])
-			printf("%c=%d ", compressedL3[i], i);
-
-	printf("\n\nFrequency table:\n");
-	for (i = 0; i < 256; i++)
-		if (charFreq[i].occurances)
-			printf("%c = %d occurances\n", charFreq[i].ch, charFreq[i].
-			    occurances);
-
-}
-
-
@@ -33,102 +33,34 @@
 
 #include "dictionary.h"
 
-#define HASH_TABLE_SIZE 0x8000
-
-#define MAX_WORD_LEN       32
-#define MIN_WORD_LEN       2
-#define MAX_COMPRESSED_LEN 64
-
-void HashWord(char*word, int len);
-void DumpHashTable(void);
-
-typedef struct dictionaryList
-{
-	char*word;
-	struct dictionaryList*next;
-}SPELL_WORD;
-
-static SPELL_WORD*dictionary_hash[HASH_TABLE_SIZE];
+static int LookupDictionary(char*word, int len);
+static unsigned int DictionaryHash(char*word, int len, unsigned int seed);
 
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*# compressedL1 [0-15] ASCII value for Top Row                             #*/
-/*# compressedL2 [0-15] ASCII value for Bottom Row                          #*/
-/*# compressedL3 [0-15] ASCII value for Special Row                         #*/
-/*#                                                                         #*/
+/*# Dump every word in the dictionary image, checking that each one is      #*/
+/*# found again through the perfect hash.                                   #*/
 /*#                                                                         #*/
 /*###########################################################################*/
 int main(void)
 {
-	char prev[MAX_COMPRESSED_LEN];
-	char decompressed[MAX_COMPRESSED_LEN];
-	char affix[MAX_COMPRESSED_LEN];
-	char*ptr;
-	int i, newLen, baseLen;
-	int numNibbles = 0;
-	char*nibbles;
-	int index = 0;
-
-	nibbles = malloc(sizeof(dictionary_words)*2);
-
-	for (i = 0; i < (int)sizeof(dictionary_words); i++) {
-		nibbles[numNibbles] = (dictionary_words[i] >> 4);
-		nibbles[numNibbles + 1] = (dictionary_words[i]&0x0f);
-		numNibbles += 2;
-	}
+	char*word;
+	int i, len, missing = 0;
 
-	while (index < numNibbles - 1) {
-		newLen = 0;
+	for (i = 0; i < DICTIONARY_WORDS; i++) {
+		word = (char*)&dictionary_pool[dictionary_offsets[i]];
+		len = dictionary_offsets[i + 1] - dictionary_offsets[i] - 1;
 
-		if (nibbles[index]) {
-			memcpy(&decompressed[newLen], prev, nibbles[index]);
-			newLen += nibbles[index];
+		if (!LookupDictionary(word, len)) {
+			fprintf(stderr, "Missing '%s' from slot %d\n", word, i);
+			missing++;
 		}
-		index++;
-
-		while (nibbles[index] != 0x0f) {
-			if (nibbles[index] == 0x0d) {
-				index++;
-				decompressed[newLen++] =
-				compressedL2[(unsigned char)nibbles[index++]];
-			} else
-				if (nibbles[index] == 0x0e) {
-					index++;
-					decompressed[newLen++] =
-					compressedL3[(unsigned char)nibbles[index++]];
-				} else {
-					decompressed[newLen++] =
-					compressedL1[(unsigned char)nibbles[index++]];
-				}
-		}
-
-		index++;
-
-		decompressed[newLen] = 0;
-		memcpy(prev, decompressed, newLen + 1);
-
-		ptr = strstr(decompressed, "+");
-
-		if (ptr)
-			HashWord(decompressed, ptr - decompressed);
-		else
-			ptr = strstr(decompressed, "/");
 
-		if (ptr) {
-			baseLen = ptr - decompressed;
-
-			strcpy(affix, ptr + 1);
-
-			for (i = 0; i < (newLen - baseLen) - 1; i++) {
-				strcpy(ptr, suffixes[affix[i]-'a']);
-				HashWord(decompressed, baseLen + strlen(ptr));
-			}
-		} else
-			HashWord(decompressed, newLen);
+		printf("%s\n", word);
 	}
-	DumpHashTable();
-	return (0);
+
+	return (missing != 0);
 }
 
 
@@ -138,49 +70,42 @@ int main(void)
 /*#                                                                         #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-void HashWord(char*word, int len)
+static int LookupDictionary(char*word, int len)
 {
-	unsigned int hash = 5137;
-	int i;
-	SPELL_WORD*newWord;
+	unsigned int seed, slot, offset;
 
-	newWord = malloc(sizeof(SPELL_WORD));
-	newWord->word = malloc(len + 2);
-	newWord->word[0] = (char)len;
-	memcpy(newWord->word + 1, word, len);
-	newWord->word[1 + len] = 0;
+	seed = dictionary_seeds[DictionaryHash(word, len, 0) % DICTIONARY_BUCKETS];
 
-	for (i = 0; i < len; i++)
-		hash = ((hash << 5) + hash) + word[i];
+	if (seed&DICTIONARY_DIRECT)
+		slot = seed&~DICTIONARY_DIRECT;
+	else
+		slot = DictionaryHash(word, len, seed) % DICTIONARY_WORDS;
+
+	offset = dictionary_offsets[slot];
 
-	newWord->next = dictionary_hash[hash%HASH_TABLE_SIZE];
+	if ((int)(dictionary_offsets[slot + 1] - offset) != len + 1)
+		return (0);
 
-	dictionary_hash[hash%HASH_TABLE_SIZE] = newWord;
+	return (!memcmp(&dictionary_pool[offset], word, len));
 }
 
 
 /*###########################################################################*/
 /*#                                                                         #*/
-/*#                                                                         #*/
-/*#                                                                         #*/
+/*# Must match DictionaryHash in make_dict.c.                               #*/
 /*#                                                                         #*/
 /*###########################################################################*/
-void DumpHashTable(void)
+static unsigned int DictionaryHash(char*word, int len, unsigned int seed)
 {
+	unsigned int hash = 2166136261U ^ (seed*0x9e3779b9U);
 	int i;
-	SPELL_WORD*base;
 
-	for (i = 0; i < HASH_TABLE_SIZE; i++) {
-		base = dictionary_hash[i];
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (unsigned char)word[i])*16777619U;
 
-		if (!base)
-			continue;
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
 
-		while (base) {
-			printf("%s\n", base->word + 1);
-			base = base->next;
-		}
-	}
+	return (hash);
 }
-
-
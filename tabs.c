@@ -44,6 +44,7 @@ char*TabulateString(char*string, int len, int*newLen)
 {
 	EDIT_LINE line;
 
+	line.flags = 0;
 	line.allocSize = TabulateLength(string, 0, len, len) + 1;
 	line.line = OS_Malloc(line.allocSize);
 
@@ -162,6 +163,12 @@ void TabulateLine(EDIT_LINE*line, char*buf, int len)
 
 	line->len = newlen;
 
+	/* Lines of plain ASCII skip the UTF-8 column maps */
+	if (AsciiText(line->line, line->len))
+		line->flags &= ~LINE_FLAG_UTF8;
+	else
+		line->flags |= LINE_FLAG_UTF8;
+
 	if (alloced)
 		OS_Free(alloced);
 }
@@ -0,0 +1,1039 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "osdep.h" /* Platform dependent interface */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "trigram.h"
+
+#define STATE_SEEN      0x01
+#define STATE_REMOVED   0x02
+#define STATE_CANDIDATE 0x04
+
+#define TRIGRAM_BITS  (1<<24)
+
+#define FOLD(ch) ((ch) >= 'a' && (ch) <= 'z' ? (ch) - 32 : (ch))
+
+static int LoadImage(TRIGRAM_INDEX*index, FILE_HANDLE*fp);
+static void ReleaseImage(TRIGRAM_INDEX*index);
+static void BuildHashTable(TRIGRAM_INDEX*index);
+static unsigned int HashPath(char*path);
+static int FindEntry(TRIGRAM_INDEX*index, char*path);
+static TRIGRAM_KEY*FindKey(TRIGRAM_INDEX*index, unsigned int trigram);
+static void QueryString(TRIGRAM_INDEX*index, char*search, char*wildcards);
+static int QueryTrigrams(char*search, char*wildcards, unsigned int*trigrams);
+static unsigned char*DecodeVarint(unsigned char*ptr, unsigned int*value);
+static int EncodeVarint(unsigned char*ptr, unsigned int value);
+static int ComparePairs(const void*p1, const void*p2);
+static int WritePostings(TRIGRAM_INDEX*index, FILE_HANDLE*fp, int*newIds,
+    int kept, TRIGRAM_KEY**keyList, int*numKeys, unsigned int*postingBytes);
+static unsigned char*GrowScratch(unsigned char*scratch, long len, long*size);
+static void IndexPathname(char*pathname, char*root, char*name);
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+TRIGRAM_INDEX*OpenTrigramIndex(char*root)
+{
+	TRIGRAM_INDEX*index;
+	FILE_HANDLE*fp;
+	OS_FILE_INFO info;
+	char*pathname;
+
+	index = OS_Malloc(sizeof(TRIGRAM_INDEX));
+	memset(index, 0, sizeof(TRIGRAM_INDEX));
+
+	index->root = OS_Malloc(strlen(root) + 1);
+	strcpy(index->root, root);
+
+	pathname = OS_Malloc(strlen(root) + strlen(TRIGRAM_INDEX_NAME) + 2);
+	IndexPathname(pathname, root, TRIGRAM_INDEX_NAME);
+
+	if (OS_GetFileInfo(pathname, &info))
+		index->indexTime = info.modTime;
+
+	index->startTime = (long long)time(0);
+
+	fp = OS_Open(pathname, "rb");
+
+	if (fp) {
+		/* A damaged or foreign image is treated as an empty index. */
+		if (!LoadImage(index, fp))
+			ReleaseImage(index);
+
+		OS_Close(fp);
+	}
+
+	OS_Free(pathname);
+
+	BuildHashTable(index);
+
+	return (index);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void CloseTrigramIndex(TRIGRAM_INDEX*index)
+{
+	int i;
+
+	if (!index)
+		return ;
+
+	ReleaseImage(index);
+
+	for (i = 0; i < index->numAdded; i++) {
+		OS_Free(index->added[i].path);
+
+		if (index->added[i].trigrams)
+			OS_Free(index->added[i].trigrams);
+	}
+
+	if (index->added)
+		OS_Free(index->added);
+
+	OS_Free(index->root);
+	OS_Free(index);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int LoadImage(TRIGRAM_INDEX*index, FILE_HANDLE*fp)
+{
+	TRIGRAM_HEADER*header;
+	unsigned long expected;
+	int i;
+
+	index->imageSize = OS_Filesize(fp);
+
+	if (index->imageSize < (long)sizeof(TRIGRAM_HEADER))
+		return (0);
+
+	index->image = OS_MapFile(fp, index->imageSize);
+
+	if (index->image)
+		index->mapped = 1;
+	else {
+		index->image = OS_Malloc(index->imageSize);
+
+		if (!OS_Read(index->image, index->imageSize, 1, fp))
+			return (0);
+	}
+
+	header = (TRIGRAM_HEADER*)index->image;
+
+	if (header->sig != TRIGRAM_SIG || header->version != TRIGRAM_VERSION)
+		return (0);
+
+	if (header->postingBytes&7)
+		return (0);
+
+	expected = sizeof(TRIGRAM_HEADER) + header->postingBytes + header->numFiles*
+	    sizeof(TRIGRAM_ENTRY) + header->numKeys*sizeof(TRIGRAM_KEY) + header->
+	    pathBytes;
+
+	if (expected != (unsigned long)index->imageSize)
+		return (0);
+
+	index->postings = (unsigned char*)(header + 1);
+	index->entries = (TRIGRAM_ENTRY*)(index->postings + header->postingBytes);
+	index->keys = (TRIGRAM_KEY*)(index->entries + header->numFiles);
+	index->paths = (char*)(index->keys + header->numKeys);
+
+	if (header->pathBytes && index->paths[header->pathBytes - 1])
+		return (0);
+
+	for (i = 0; i < (int)header->numFiles; i++)
+		if (index->entries[i].path >= header->pathBytes)
+			return (0);
+
+	for (i = 0; i < (int)header->numKeys; i++)
+		if (index->keys[i].offset >= header->postingBytes)
+			return (0);
+
+	index->numFiles = header->numFiles;
+	index->numKeys = header->numKeys;
+
+	index->state = OS_Malloc(index->numFiles + 1);
+	memset(index->state, 0, index->numFiles + 1);
+
+	index->hits = OS_Malloc(index->numFiles + 1);
+	memset(index->hits, 0, index->numFiles + 1);
+
+	return (1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void ReleaseImage(TRIGRAM_INDEX*index)
+{
+	if (index->image) {
+		if (index->mapped)
+			OS_UnmapFile(index->image, index->imageSize);
+		else
+			OS_Free(index->image);
+	}
+
+	if (index->hashTable)
+		OS_Free(index->hashTable);
+
+	if (index->state)
+		OS_Free(index->state);
+
+	if (index->hits)
+		OS_Free(index->hits);
+
+	index->image = 0;
+	index->mapped = 0;
+	index->hashTable = 0;
+	index->hashSize = 0;
+	index->state = 0;
+	index->hits = 0;
+	index->numFiles = 0;
+	index->numKeys = 0;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void BuildHashTable(TRIGRAM_INDEX*index)
+{
+	int i, slot;
+
+	if (!index->numFiles)
+		return ;
+
+	for (index->hashSize = 16; index->hashSize < index->numFiles*2; )
+		index->hashSize *= 2;
+
+	index->hashTable = OS_Malloc(index->hashSize*sizeof(int));
+
+	for (i = 0; i < index->hashSize; i++)
+		index->hashTable[i] = -1;
+
+	for (i = 0; i < index->numFiles; i++) {
+		slot = HashPath(&index->paths[index->entries[i].path])&
+		    (index->hashSize - 1);
+
+		while (index->hashTable[slot] != -1)
+			slot = (slot + 1)&(index->hashSize - 1);
+
+		index->hashTable[slot] = i;
+	}
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned int HashPath(char*path)
+{
+	unsigned int hash = 2166136261u;
+
+	while (*path) {
+		hash ^= (unsigned char)*path++;
+		hash *= 16777619;
+	}
+
+	return (hash);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int FindEntry(TRIGRAM_INDEX*index, char*path)
+{
+	int slot, id;
+
+	if (!index->hashSize)
+		return (-1);
+
+	slot = HashPath(path)&(index->hashSize - 1);
+
+	for (; ; ) {
+		id = index->hashTable[slot];
+
+		if (id == -1)
+			return (-1);
+
+		if (!strcmp(&index->paths[index->entries[id].path], path))
+			return (id);
+
+		slot = (slot + 1)&(index->hashSize - 1);
+	}
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static TRIGRAM_KEY*FindKey(TRIGRAM_INDEX*index, unsigned int trigram)
+{
+	int low = 0, high = index->numKeys - 1, mid;
+
+	while (low <= high) {
+		mid = (low + high) / 2;
+
+		if (index->keys[mid].trigram == trigram)
+			return (&index->keys[mid]);
+
+		if (index->keys[mid].trigram < trigram)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int QueryTrigrams(char*search, char*wildcards, unsigned int*trigrams)
+{
+	int i, j, len, count = 0;
+	unsigned int trigram;
+	unsigned char ch;
+
+	len = strlen(search);
+
+	for (i = 0; i + 2 < len && count < TRIGRAM_MAX_QUERY; i++) {
+		trigram = 0;
+
+		/* Only runs of literal characters give usable trigrams. */
+		for (j = 0; j < 3; j++) {
+			ch = (unsigned char)search[i + j];
+
+			if (strchr(wildcards, ch))
+				break;
+
+			trigram = (trigram << 8) | FOLD(ch);
+		}
+
+		if (j < 3)
+			continue;
+
+		for (j = 0; j < count; j++)
+			if (trigrams[j] == trigram)
+				break;
+
+		if (j == count)
+			trigrams[count++] = trigram;
+	}
+
+	return (count);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void TrigramQuery(TRIGRAM_INDEX*index, char**search, int numSearch,
+    char*wildcards)
+{
+	int i;
+
+	index->queryAll = !numSearch;
+
+	for (i = 0; i < index->numFiles; i++)
+		index->state[i] &= ~STATE_CANDIDATE;
+
+	/* A file is a candidate when it may hold any one of the strings. */
+	for (i = 0; i < numSearch && !index->queryAll; i++)
+		QueryString(index, search[i], wildcards);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void QueryString(TRIGRAM_INDEX*index, char*search, char*wildcards)
+{
+	unsigned int trigrams[TRIGRAM_MAX_QUERY];
+	TRIGRAM_KEY*keys[TRIGRAM_MAX_QUERY];
+	TRIGRAM_KEY*key;
+	unsigned char*ptr;
+	unsigned int i, id, delta;
+	int count, j, k;
+
+	count = QueryTrigrams(search, wildcards, trigrams);
+
+	if (!count) {
+		index->queryAll = 1;
+		return ;
+	}
+
+	if (!index->numFiles)
+		return ;
+
+	for (k = 0; k < count; k++) {
+		keys[k] = FindKey(index, trigrams[k]);
+
+		/* No indexed file holds this trigram, so none can match. */
+		if (!keys[k])
+			return ;
+	}
+
+	memset(index->hits, 0, index->numFiles);
+
+	/* Intersect the shortest posting lists first. */
+	for (k = 1; k < count; k++) {
+		key = keys[k];
+
+		for (j = k - 1; j >= 0 && keys[j]->count > key->count; j--)
+			keys[j + 1] = keys[j];
+
+		keys[j + 1] = key;
+	}
+
+	for (k = 0; k < count; k++) {
+		ptr = &index->postings[keys[k]->offset];
+		id = 0;
+
+		for (i = 0; i < keys[k]->count; i++) {
+			ptr = DecodeVarint(ptr, &delta);
+			id += delta;
+
+			if (id < (unsigned int)index->numFiles && index->hits[id] == k)
+				index->hits[id] = k + 1;
+		}
+	}
+
+	for (j = 0; j < index->numFiles; j++)
+		if (index->hits[j] == count)
+			index->state[j] |= STATE_CANDIDATE;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int TrigramCheckFile(TRIGRAM_INDEX*index, char*path, long long size,
+    long long modTime)
+{
+	TRIGRAM_ENTRY*entry;
+	int id;
+
+	id = FindEntry(index, path);
+
+	if (id < 0)
+		return (TRIGRAM_STALE);
+
+	entry = &index->entries[id];
+
+	if (entry->fileSize != (unsigned long long)size || entry->modTime !=
+	    modTime || (entry->flags&TRIGRAM_FILE_RACY))
+		return (TRIGRAM_STALE);
+
+	index->state[id] |= STATE_SEEN;
+
+	if (entry->flags&TRIGRAM_FILE_UNINDEXED)
+		return (TRIGRAM_SEARCH);
+
+	if (entry->flags&TRIGRAM_FILE_BINARY)
+		return (TRIGRAM_BINARY);
+
+	if (index->queryAll || (index->state[id]&STATE_CANDIDATE))
+		return (TRIGRAM_SEARCH);
+
+	return (TRIGRAM_SKIP);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void TrigramAddFile(TRIGRAM_INDEX*index, char*path, long long size,
+    long long modTime, int flags, unsigned int*trigrams, int count)
+{
+	TRIGRAM_ADDED*added;
+	int id;
+
+	id = FindEntry(index, path);
+
+	if (id >= 0)
+		index->state[id] |= STATE_REMOVED;
+
+	if (index->numAdded == index->maxAdded) {
+		index->maxAdded = index->maxAdded ? index->maxAdded*2 : 64;
+
+		added = OS_Malloc(index->maxAdded*sizeof(TRIGRAM_ADDED));
+
+		if (index->added) {
+			memcpy(added, index->added, index->numAdded*sizeof(TRIGRAM_ADDED));
+			OS_Free(index->added);
+		}
+
+		index->added = added;
+	}
+
+	added = &index->added[index->numAdded++];
+
+	added->path = OS_Malloc(strlen(path) + 1);
+	strcpy(added->path, path);
+
+	added->fileSize = (unsigned long long)size;
+	added->modTime = modTime;
+	added->trigrams = trigrams;
+	added->count = count;
+
+	/* Times only resolve to a second, so a file modified within a second */
+	/* of the walk starting could change again without its time moving.  */
+	if (modTime >= index->startTime - 1)
+		flags |= TRIGRAM_FILE_RACY;
+
+	added->flags = flags;
+
+	index->dirty = 1;
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int TrigramCollect(unsigned char**seen, char*data, long len, int*flags,
+    unsigned int**list)
+{
+	unsigned char*buffer = (unsigned char*)data;
+	unsigned int*trigrams = 0;
+	unsigned int*grow;
+	unsigned int trigram;
+	int count = 0, max = 0, i;
+	long pos;
+
+	*list = 0;
+
+	if (len > TRIGRAM_MAX_INDEXED)
+		*flags |= TRIGRAM_FILE_UNINDEXED;
+
+	if (len < 3 || (*flags&(TRIGRAM_FILE_BINARY | TRIGRAM_FILE_UNINDEXED)))
+		return (0);
+
+	/* One bit per possible trigram, cleared again after every file. */
+	if (!*seen) {
+		*seen = OS_Malloc(TRIGRAM_BITS / 8);
+		memset(*seen, 0, TRIGRAM_BITS / 8);
+	}
+
+	trigram = (FOLD(buffer[0]) << 8) | FOLD(buffer[1]);
+
+	for (pos = 2; pos < len; pos++) {
+		trigram = ((trigram << 8) | FOLD(buffer[pos]))&(TRIGRAM_BITS - 1);
+
+		if ((*seen)[trigram >> 3]&(1 << (trigram&7)))
+			continue;
+
+		(*seen)[trigram >> 3] |= (1 << (trigram&7));
+
+		if (count == max) {
+			max = max ? max*2 : 1024;
+
+			grow = OS_Malloc(max*sizeof(unsigned int));
+
+			if (trigrams) {
+				memcpy(grow, trigrams, count*sizeof(unsigned int));
+				OS_Free(trigrams);
+			}
+
+			trigrams = grow;
+		}
+
+		trigrams[count++] = trigram;
+	}
+
+	for (i = 0; i < count; i++)
+		(*seen)[trigrams[i] >> 3] &= ~(1 << (trigrams[i]&7));
+
+	*list = trigrams;
+
+	return (count);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned char*DecodeVarint(unsigned char*ptr, unsigned int*value)
+{
+	unsigned int result = 0;
+	int shift = 0;
+
+	do {
+		result |= (unsigned int)(*ptr&0x7f) << shift;
+		shift += 7;
+	} while (*ptr++&0x80);
+
+	*value = result;
+
+	return (ptr);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int EncodeVarint(unsigned char*ptr, unsigned int value)
+{
+	int len = 0;
+
+	while (value >= 0x80) {
+		ptr[len++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+
+	ptr[len++] = (unsigned char)value;
+
+	return (len);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int ComparePairs(const void*p1, const void*p2)
+{
+	const unsigned int*pair1 = (const unsigned int*)p1;
+	const unsigned int*pair2 = (const unsigned int*)p2;
+
+	if (pair1[0] != pair2[0])
+		return (pair1[0] < pair2[0] ? -1 : 1);
+
+	if (pair1[1] != pair2[1])
+		return (pair1[1] < pair2[1] ? -1 : 1);
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int SaveTrigramIndex(TRIGRAM_INDEX*index, int complete)
+{
+	TRIGRAM_HEADER header;
+	TRIGRAM_ENTRY entry;
+	TRIGRAM_KEY*keyList = 0;
+	FILE_HANDLE*fp;
+	char*pathname;
+	char*tempname;
+	int*newIds = 0;
+	int i, kept = 0, numKeys = 0, retCode = 0;
+	unsigned int postingBytes = 0, pathOffset;
+
+	/* A complete walk saw every file; anything it missed was deleted. */
+	if (complete) {
+		for (i = 0; i < index->numFiles; i++)
+			if (!(index->state[i]&(STATE_SEEN | STATE_REMOVED))) {
+				index->state[i] |= STATE_REMOVED;
+				index->dirty = 1;
+			}
+	}
+
+	if (!index->dirty)
+		return (1);
+
+	if (index->numFiles)
+		newIds = OS_Malloc(index->numFiles*sizeof(int));
+
+	for (i = 0; i < index->numFiles; i++)
+		newIds[i] = (index->state[i]&STATE_REMOVED) ? -1 : kept++;
+
+	pathname = OS_Malloc(strlen(index->root) + strlen(TRIGRAM_INDEX_NAME) + 2);
+	tempname = OS_Malloc(strlen(index->root) + strlen(TRIGRAM_INDEX_TEMP) + 2);
+
+	IndexPathname(pathname, index->root, TRIGRAM_INDEX_NAME);
+	IndexPathname(tempname, index->root, TRIGRAM_INDEX_TEMP);
+
+	fp = OS_Open(tempname, "wb");
+
+	if (fp) {
+		memset(&header, 0, sizeof(header));
+		OS_Write(&header, sizeof(header), 1, fp);
+
+		if (WritePostings(index, fp, newIds, kept, &keyList, &numKeys,
+		    &postingBytes)) {
+			pathOffset = 0;
+
+			for (i = 0; i < index->numFiles; i++) {
+				if (newIds[i] < 0)
+					continue;
+
+				entry = index->entries[i];
+				entry.path = pathOffset;
+				pathOffset += strlen(&index->paths[index->entries[i].path]) + 1;
+				OS_Write(&entry, sizeof(entry), 1, fp);
+			}
+
+			for (i = 0; i < index->numAdded; i++) {
+				entry.path = pathOffset;
+				entry.fileSize = index->added[i].fileSize;
+				entry.modTime = index->added[i].modTime;
+				entry.flags = index->added[i].flags;
+				pathOffset += strlen(index->added[i].path) + 1;
+				OS_Write(&entry, sizeof(entry), 1, fp);
+			}
+
+			if (numKeys)
+				OS_Write(keyList, sizeof(TRIGRAM_KEY), numKeys, fp);
+
+			for (i = 0; i < index->numFiles; i++)
+				if (newIds[i] >= 0)
+					OS_Write(&index->paths[index->entries[i].path], strlen(
+					    &index->paths[index->entries[i].path]) + 1, 1, fp);
+
+			for (i = 0; i < index->numAdded; i++)
+				OS_Write(index->added[i].path, strlen(index->added[i].path) +
+				    1, 1, fp);
+
+			OS_Close(fp);
+
+			/* Fill in the header now the section sizes are known. */
+			header.sig = TRIGRAM_SIG;
+			header.version = TRIGRAM_VERSION;
+			header.numFiles = kept + index->numAdded;
+			header.numKeys = numKeys;
+			header.postingBytes = postingBytes;
+			header.pathBytes = pathOffset;
+
+			fp = OS_Open(tempname, "r+b");
+
+			if (fp) {
+				retCode = OS_Write(&header, sizeof(header), 1, fp) == 1;
+				OS_Close(fp);
+			}
+		} else
+			OS_Close(fp);
+
+		/* The old image must be let go before the file can be replaced. */
+		ReleaseImage(index);
+
+		if (retCode) {
+			OS_Delete(pathname);
+			retCode = !rename(tempname, pathname);
+		}
+
+		if (!retCode)
+			OS_Delete(tempname);
+	}
+
+	if (keyList)
+		OS_Free(keyList);
+
+	if (newIds)
+		OS_Free(newIds);
+
+	OS_Free(tempname);
+	OS_Free(pathname);
+
+	index->dirty = 0;
+
+	return (retCode);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int WritePostings(TRIGRAM_INDEX*index, FILE_HANDLE*fp, int*newIds,
+    int kept, TRIGRAM_KEY**keyList, int*numKeys, unsigned int*postingBytes)
+{
+	unsigned int*pairs = 0;
+	unsigned char*scratch = 0;
+	unsigned char*ptr;
+	TRIGRAM_KEY*keys = 0;
+	TRIGRAM_KEY*grow;
+	unsigned int trigram, id, last, delta, count, offset = 0;
+	long numPairs = 0, pair = 0, scratchSize = 0, len;
+	int i, j, k = 0, maxKeys = 0, newId;
+	static unsigned char padding[8];
+
+	for (i = 0; i < index->numAdded; i++)
+		numPairs += index->added[i].count;
+
+	if (numPairs) {
+		pairs = OS_Malloc(numPairs*2*sizeof(unsigned int));
+
+		for (i = 0; i < index->numAdded; i++)
+			for (j = 0; j < index->added[i].count; j++) {
+				pairs[pair*2] = index->added[i].trigrams[j];
+				pairs[pair*2 + 1] = kept + i;
+				pair++;
+			}
+
+		qsort(pairs, numPairs, 2*sizeof(unsigned int), ComparePairs);
+	}
+
+	pair = 0;
+
+	/* Merge the surviving old lists with the new files, trigram by      */
+	/* trigram. New files sort after every kept file, so ids stay ordered. */
+	while (k < index->numKeys || pair < numPairs) {
+		if (pair >= numPairs || (k < index->numKeys && index->keys[k].trigram <=
+		    pairs[pair*2]))
+			trigram = index->keys[k].trigram;
+		else
+			trigram = pairs[pair*2];
+
+		count = 0;
+		last = 0;
+		len = 0;
+
+		if (k < index->numKeys && index->keys[k].trigram == trigram) {
+			ptr = &index->postings[index->keys[k].offset];
+			id = 0;
+
+			for (i = 0; i < (int)index->keys[k].count; i++) {
+				ptr = DecodeVarint(ptr, &delta);
+				id += delta;
+
+				if (id >= (unsigned int)index->numFiles)
+					break;
+
+				newId = newIds[id];
+
+				if (newId < 0)
+					continue;
+
+				if (len + 5 > scratchSize)
+					scratch = GrowScratch(scratch, len, &scratchSize);
+
+				len += EncodeVarint(&scratch[len], newId - last);
+				last = newId;
+				count++;
+			}
+
+			k++;
+		}
+
+		while (pair < numPairs && pairs[pair*2] == trigram) {
+			newId = pairs[pair*2 + 1];
+
+			if (len + 5 > scratchSize)
+				scratch = GrowScratch(scratch, len, &scratchSize);
+
+			len += EncodeVarint(&scratch[len], newId - last);
+			last = newId;
+			count++;
+			pair++;
+		}
+
+		if (!count)
+			continue;
+
+		if (*numKeys == maxKeys) {
+			maxKeys = maxKeys ? maxKeys*2 : 4096;
+
+			grow = OS_Malloc(maxKeys*sizeof(TRIGRAM_KEY));
+
+			if (keys) {
+				memcpy(grow, keys, *numKeys*sizeof(TRIGRAM_KEY));
+				OS_Free(keys);
+			}
+
+			keys = grow;
+		}
+
+		keys[*numKeys].trigram = trigram;
+		keys[*numKeys].count = count;
+		keys[*numKeys].offset = offset;
+		(*numKeys)++;
+
+		OS_Write(scratch, len, 1, fp);
+		offset += len;
+	}
+
+	/* Entries hold 64-bit fields, so they start on an 8 byte boundary. */
+	if (offset&7)
+		OS_Write(padding, 8 - (offset&7), 1, fp);
+
+	*postingBytes = (offset + 7)&~7;
+	*keyList = keys;
+
+	if (scratch)
+		OS_Free(scratch);
+
+	if (pairs)
+		OS_Free(pairs);
+
+	return (1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static unsigned char*GrowScratch(unsigned char*scratch, long len, long*size)
+{
+	unsigned char*grow;
+
+	*size = *size ? *size*2 : 4096;
+
+	grow = OS_Malloc(*size);
+
+	if (scratch) {
+		memcpy(grow, scratch, len);
+		OS_Free(scratch);
+	}
+
+	return (grow);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void IndexPathname(char*pathname, char*root, char*name)
+{
+	OS_JoinPath(pathname, root, name);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int TrigramExcludesFile(char*pathname, long long size, long long modTime,
+    char*search)
+{
+	static TRIGRAM_INDEX*editorIndex = 0;
+	static char*editorQuery = 0;
+	OS_FILE_INFO info;
+	char*root;
+	char*indexname;
+	int i, found = 0, retCode;
+
+	root = OS_Malloc(strlen(pathname) + 1);
+	indexname = OS_Malloc(strlen(pathname) + strlen(TRIGRAM_INDEX_NAME) + 2);
+
+	strcpy(root, pathname);
+
+	/* The nearest enclosing directory holding an index wins. */
+	for (i = strlen(root) - 1; i >= 0 && !found; i--) {
+		if (root[i] != '/' && root[i] != '\\')
+			continue;
+
+		root[i] = 0;
+		IndexPathname(indexname, root, TRIGRAM_INDEX_NAME);
+
+		if (OS_GetFileInfo(indexname, &info))
+			found = 1;
+	}
+
+	retCode = 0;
+
+	if (found) {
+		if (editorIndex && (strcmp(editorIndex->root, root) ||
+		    editorIndex->indexTime != info.modTime)) {
+			CloseTrigramIndex(editorIndex);
+			editorIndex = 0;
+		}
+
+		if (!editorIndex) {
+			editorIndex = OpenTrigramIndex(root);
+
+			if (editorQuery)
+				OS_Free(editorQuery);
+
+			editorQuery = 0;
+		}
+
+		if (!editorQuery || strcmp(editorQuery, search)) {
+			if (editorQuery)
+				OS_Free(editorQuery);
+
+			editorQuery = OS_Malloc(strlen(search) + 1);
+			strcpy(editorQuery, search);
+
+			TrigramQuery(editorIndex, &editorQuery, 1, "?");
+		}
+
+		retCode = TrigramCheckFile(editorIndex, &pathname[strlen(root) + 1],
+		    size, modTime) == TRIGRAM_SKIP;
+	}
+
+	OS_Free(indexname);
+	OS_Free(root);
+
+	return (retCode);
+}
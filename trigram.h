@@ -0,0 +1,128 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __TRIGRAM_H__
+#define __TRIGRAM_H__
+
+#define TRIGRAM_INDEX_NAME  ".pe_trigram"
+#define TRIGRAM_INDEX_TEMP  ".pe_trigram.tmp"
+
+#define TRIGRAM_SIG         0x54474550   /* "PEGT" */
+#define TRIGRAM_VERSION     2
+
+#define TRIGRAM_MAX_QUERY   32
+#define TRIGRAM_MAX_INDEXED (64L*1024L*1024L)
+
+#define TRIGRAM_FILE_BINARY    0x01   /* Binary content, no trigrams kept   */
+#define TRIGRAM_FILE_UNINDEXED 0x02   /* Too large to index, always search  */
+#define TRIGRAM_FILE_RACY      0x04   /* Too recent to trust its time       */
+
+#define TRIGRAM_SKIP        0   /* Indexed and cannot contain the search */
+#define TRIGRAM_SEARCH      1   /* Indexed and may contain the search    */
+#define TRIGRAM_STALE       2   /* Not indexed, or changed since         */
+#define TRIGRAM_BINARY      3   /* Indexed as a binary file              */
+
+/* On-disk image: header, posting lists (padded to 8 bytes), entries,    */
+/* keys sorted by trigram, then the path pool. Each posting list is a run */
+/* of varint-encoded deltas between ascending file ids.                   */
+typedef struct trigramHeader_t
+{
+	unsigned int sig;
+	unsigned int version;
+	unsigned int numFiles;
+	unsigned int numKeys;
+	unsigned int postingBytes;
+	unsigned int pathBytes;
+}TRIGRAM_HEADER;
+
+typedef struct trigramEntry_t
+{
+	unsigned int path;
+	unsigned int flags;
+	unsigned long long fileSize;
+	long long modTime;
+}TRIGRAM_ENTRY;
+
+typedef struct trigramKey_t
+{
+	unsigned int trigram;
+	unsigned int count;
+	unsigned int offset;
+}TRIGRAM_KEY;
+
+typedef struct trigramAdded_t
+{
+	char*path;
+	unsigned long long fileSize;
+	long long modTime;
+	unsigned int flags;
+	unsigned int*trigrams;
+	int count;
+}TRIGRAM_ADDED;
+
+typedef struct trigramIndex_t
+{
+	char*root;
+	char*image;
+	long imageSize;
+	int mapped;
+	int numFiles;
+	int numKeys;
+	TRIGRAM_ENTRY*entries;
+	TRIGRAM_KEY*keys;
+	char*paths;
+	unsigned char*postings;
+	int*hashTable;
+	int hashSize;
+	unsigned char*state;
+	unsigned char*hits;
+	int queryAll;
+	TRIGRAM_ADDED*added;
+	int numAdded;
+	int maxAdded;
+	long indexTime;
+	long long startTime;
+	int dirty;
+}TRIGRAM_INDEX;
+
+TRIGRAM_INDEX*OpenTrigramIndex(char*root);
+void CloseTrigramIndex(TRIGRAM_INDEX*index);
+int SaveTrigramIndex(TRIGRAM_INDEX*index, int complete);
+void TrigramQuery(TRIGRAM_INDEX*index, char**search, int numSearch,
+    char*wildcards);
+int TrigramCheckFile(TRIGRAM_INDEX*index, char*path, long long size,
+    long long modTime);
+int TrigramCollect(unsigned char**seen, char*data, long len, int*flags,
+    unsigned int**list);
+void TrigramAddFile(TRIGRAM_INDEX*index, char*path, long long size,
+    long long modTime, int flags, unsigned int*trigrams, int count);
+int TrigramExcludesFile(char*pathname, long long size, long long modTime,
+    char*search);
+
+#endif /* __TRIGRAM_H__ */
@@ -0,0 +1,318 @@
+/*
+ *
+ * ProEdit MP Multi-platform Programming Editor
+ * Designed/Developed/Produced by Adrian Michaud
+ *
+ * MIT License
+ *
+ * Copyright (c) 2019 Adrian Michaud
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+#include "osdep.h" /* Platform dependent interface */
+#include <string.h>
+#include <stdio.h>
+#include "proedit.h"
+
+/* The top bit of every byte in an unsigned long */
+#define HIGH_BITS ((~0UL / 0xff)*0x80)
+
+/* Shown for a character beyond the single byte fonts */
+#define GLYPH_UNKNOWN '?'
+
+static int DecodeCharacter(unsigned char*text, int len, int*code);
+static void BuildColumnMap(COLUMN_MAP*map, EDIT_LINE*line);
+static void FreeColumnMap(COLUMN_MAP*map);
+static int ColumnMapPfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg);
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Nonzero if no byte of text has its top bit set. TabulateLine asks this  #*/
+/*# of every line it builds, so the test goes a word at a time.             #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int AsciiText(char*text, int len)
+{
+	unsigned long word, bits = 0;
+	int i;
+
+	for (i = 0; i + (int)sizeof(word) <= len; i += sizeof(word)) {
+		memcpy(&word, &text[i], sizeof(word));
+		bits |= word;
+	}
+
+	for (; i < len; i++)
+		bits |= (unsigned char)text[i];
+
+	return (!(bits&HIGH_BITS));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Where the characters of line fall on the screen, built the first time   #*/
+/*# it's asked for after an edit. Returns 0 for a line that takes one       #*/
+/*# column per byte, which is painted and walked as it is.                  #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+COLUMN_MAP*FindColumnMap(EDIT_FILE*file, EDIT_LINE*line)
+{
+	LINE_CACHE*cache = file->columnMaps;
+	COLUMN_MAP*map;
+
+	if (!(line->flags&LINE_FLAG_UTF8) || !(file->file_flags&FILE_FLAG_NORMAL))
+		return (0);
+
+	if (!cache) {
+		cache = CreateLineCache(sizeof(COLUMN_MAP),
+		    (LINE_CACHE_PFN*)FreeColumnMap);
+		file->columnMaps = cache;
+
+		AddLineCallback(file, (LINE_PFN*)ColumnMapPfn, LINE_OP_EDIT |
+		    LINE_OP_DELETE);
+	}
+
+	map = (COLUMN_MAP*)FindLineEntry(cache, line);
+
+	if (!map) {
+		map = (COLUMN_MAP*)AddLineEntry(cache, line);
+		map->len = -1;
+	}
+
+	if (map->text != line->line || map->len != line->len)
+		BuildColumnMap(map, line);
+
+	return (map->column ? map : 0);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The screen column of the byte at offset. Past the end of the line       #*/
+/*# every column is one byte of virtual space.                              #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int LineColumn(EDIT_FILE*file, EDIT_LINE*line, int offset)
+{
+	COLUMN_MAP*map = FindColumnMap(file, line);
+
+	if (!map)
+		return (offset);
+
+	if (offset >= line->len)
+		return (map->columns + (offset - line->len));
+
+	return (map->column[offset]);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The offset of the first byte of the character at column.                #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int LineOffset(EDIT_FILE*file, EDIT_LINE*line, int column)
+{
+	COLUMN_MAP*map = FindColumnMap(file, line);
+
+	if (!map)
+		return (column);
+
+	if (column >= map->columns)
+		return (line->len + (column - map->columns));
+
+	return (map->offset[column]);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# How many bytes the character at offset takes up.                        #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int CharacterLength(EDIT_FILE*file, EDIT_LINE*line, int offset)
+{
+	COLUMN_MAP*map = FindColumnMap(file, line);
+
+	if (!map || offset >= line->len)
+		return (1);
+
+	return (map->offset[map->column[offset] + 1] - offset);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void FreeColumnMaps(EDIT_FILE*file)
+{
+	if (!file->columnMaps)
+		return ;
+
+	FreeLineCache(file->columnMaps);
+	file->columnMaps = 0;
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# The length of the UTF-8 sequence at text, and its code point in code.   #*/
+/*# A byte that doesn't start a complete, shortest form sequence is a       #*/
+/*# character of its own, so Latin-1 text still shows as it did.            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int DecodeCharacter(unsigned char*text, int len, int*code)
+{
+	int i, size, low = 0x80, high = 0xbf;
+
+	*code = text[0];
+
+	if (text[0] < 0xc2 || text[0] > 0xf4)
+		return (1);
+
+	if (text[0] < 0xe0) {
+		size = 2;
+		*code = text[0]&0x1f;
+	} else
+		if (text[0] < 0xf0) {
+			size = 3;
+			*code = text[0]&0x0f;
+
+			if (text[0] == 0xe0)
+				low = 0xa0;
+			if (text[0] == 0xed)
+				high = 0x9f;
+		} else {
+			size = 4;
+			*code = text[0]&0x07;
+
+			if (text[0] == 0xf0)
+				low = 0x90;
+			if (text[0] == 0xf4)
+				high = 0x8f;
+		}
+
+	if (size > len) {
+		*code = text[0];
+		return (1);
+	}
+
+	for (i = 1; i < size; i++) {
+		if (text[i] < low || text[i] > high) {
+			*code = text[0];
+			return (1);
+		}
+
+		*code = (*code << 6) | (text[i]&0x3f);
+
+		low = 0x80;
+		high = 0xbf;
+	}
+
+	return (size);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Every character takes one column. The column of each byte, the first    #*/
+/*# byte of each column and what each column shows share one allocation,    #*/
+/*# and there are never more columns than bytes.                            #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void BuildColumnMap(COLUMN_MAP*map, EDIT_LINE*line)
+{
+	unsigned char*text = (unsigned char*)line->line;
+	int i, size, code, columns = 0;
+
+	if (map->column)
+		OS_Free(map->column);
+
+	map->column = (int*)OS_Malloc((line->len + 1)*2*sizeof(int) + line->len +
+	    1);
+	map->offset = map->column + line->len + 1;
+	map->glyphs = (char*)(map->offset + line->len + 1);
+
+	for (i = 0; i < line->len; columns++) {
+		size = DecodeCharacter(&text[i], line->len - i, &code);
+
+		map->offset[columns] = i;
+
+		if (size == 1 || code <= 0xff)
+			map->glyphs[columns] = (char)code;
+		else
+			map->glyphs[columns] = GLYPH_UNKNOWN;
+
+		while (size--)
+			map->column[i++] = columns;
+	}
+
+	map->column[line->len] = columns;
+	map->offset[columns] = line->len;
+	map->columns = columns;
+	map->text = line->line;
+	map->len = line->len;
+
+	/* Only stray top bit bytes, as in a Latin-1 file */
+	if (columns == line->len) {
+		OS_Free(map->column);
+		map->column = 0;
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static void FreeColumnMap(COLUMN_MAP*map)
+{
+	if (map->column)
+		OS_Free(map->column);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# An edited line is mapped again when it's next asked for.                #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int ColumnMapPfn(EDIT_FILE*file, EDIT_LINE*line, int op, int arg)
+{
+	COLUMN_MAP*map;
+
+	op = op;
+	arg = arg;
+
+	map = (COLUMN_MAP*)FindLineEntry(file->columnMaps, line);
+
+	if (map)
+		map->len = -1;
+
+	return (0);
+}
@@ -37,8 +37,12 @@
 #include <time.h>
 #include <conio.h>
 #include <stdarg.h>
+#include <io.h>
 
 static int CheckWildcard(char*filename);
+static long UnixFileTime(FILETIME*ft);
+static int HandleInfo(char*path, BY_HANDLE_FILE_INFORMATION*info);
+static DWORD WINAPI ThreadEntry(LPVOID arg);
 
 static HANDLE fHandle = INVALID_HANDLE_VALUE;
 static WIN32_FIND_DATA finfo;
@@ -64,6 +68,21 @@ static void ProcessChdirRequest(char*cmd);
 
 #define WIN95_DELAY 500
 
+typedef struct win32_Dir
+{
+	HANDLE handle;
+	WIN32_FIND_DATA info;
+	int pending;
+	char path[MAX_PATH];
+}WIN32_DIR;
+
+typedef struct win32Thread_t
+{
+	HANDLE handle;
+	OS_THREAD_PFN*pfn;
+	void*arg;
+}WIN32_THREAD;
+
 typedef struct win32_OsShell
 {
 	BOOL windows95;
@@ -273,6 +292,7 @@ int OS_GetFileInfo(char*path, OS_FILE_INFO*info)
 
 	if (GetFileAttributesEx(path, GetFileExInfoStandard, &data)) {
 		info->fileSize = data.nFileSizeLow;
+		info->modTime = UnixFileTime(&data.ftLastWriteTime);
 
 		FileTimeToSystemTime(&data.ftLastWriteTime, &systime);
 
@@ -311,6 +331,17 @@ void OS_Time(char*string)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# Milliseconds from an arbitrary start, for timing paints.                #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+unsigned long OS_Clock(void)
+{
+	return (GetTickCount());
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -527,6 +558,262 @@ void OS_DosFindEnd(void)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_DIR*OS_OpenDir(char*path)
+{
+	WIN32_DIR*dir;
+	char mask[MAX_PATH];
+	int len;
+
+	dir = OS_Malloc(sizeof(WIN32_DIR));
+
+	_snprintf(dir->path, MAX_PATH, "%s", path);
+
+	dir->path[MAX_PATH - 1] = 0;
+
+	len = strlen(dir->path);
+
+	if (len && (dir->path[len - 1] == '\\' || dir->path[len - 1] == '/'))
+		dir->path[len - 1] = 0;
+
+	_snprintf(mask, MAX_PATH, "%s\\*", dir->path);
+	mask[MAX_PATH - 1] = 0;
+
+	dir->handle = FindFirstFile(mask, &dir->info);
+
+	if (dir->handle == INVALID_HANDLE_VALUE) {
+		OS_Free(dir);
+		return (0);
+	}
+
+	dir->pending = 1;
+
+	return ((OS_DIR*)dir);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_ReadDir(OS_DIR*handle, OS_DIR_ENTRY*entry)
+{
+	WIN32_DIR*dir = (WIN32_DIR*)handle;
+
+	for (; ; ) {
+		if (!dir->pending)
+			if (FindNextFile(dir->handle, &dir->info) == FALSE)
+				return (0);
+
+		dir->pending = 0;
+
+		if (DIR(dir->info) || SPECIAL2(dir->info))
+			continue;
+
+		if (strlen(dir->info.cFileName) >= OS_MAX_DIR_ENTRY)
+			continue;
+
+		strcpy(entry->name, dir->info.cFileName);
+
+		if (dir->info.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY)
+			entry->file_type = FILE_TYPE_DIR;
+		else
+			entry->file_type = FILE_TYPE_FILE;
+
+		entry->link = (dir->info.dwFileAttributes&
+		    FILE_ATTRIBUTE_REPARSE_POINT) ? 1 : 0;
+
+		/* The find data describes the link itself, so the target's size */
+		/* and time are left for OS_DirEntryInfo().                      */
+		if (entry->link) {
+			entry->fileSize = -1;
+			entry->modTime = 0;
+		} else {
+			if (dir->info.nFileSizeHigh || dir->info.nFileSizeLow >
+			    0x7fffffff)
+				entry->fileSize = 0x7fffffff;
+			else
+				entry->fileSize = (long)dir->info.nFileSizeLow;
+
+			entry->modTime = UnixFileTime(&dir->info.ftLastWriteTime);
+		}
+
+		return (1);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_CloseDir(OS_DIR*handle)
+{
+	WIN32_DIR*dir = (WIN32_DIR*)handle;
+
+	if (dir) {
+		FindClose(dir->handle);
+		OS_Free(dir);
+	}
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_DirEntryInfo(OS_DIR*dir, OS_DIR_ENTRY*entry)
+{
+	BY_HANDLE_FILE_INFORMATION info;
+	char path[MAX_PATH];
+
+	/* FindNextFile() already reported the size and time unless the */
+	/* entry is a link.                                             */
+	if (entry->fileSize != -1)
+		return (1);
+
+	_snprintf(path, MAX_PATH, "%s\\%s", ((WIN32_DIR*)dir)->path,
+	    entry->name);
+	path[MAX_PATH - 1] = 0;
+
+	if (!HandleInfo(path, &info))
+		return (0);
+
+	if (info.nFileSizeHigh || info.nFileSizeLow > 0x7fffffff)
+		entry->fileSize = 0x7fffffff;
+	else
+		entry->fileSize = (long)info.nFileSizeLow;
+
+	entry->modTime = UnixFileTime(&info.ftLastWriteTime);
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_DirIdentity(OS_DIR*dir, OS_DIR_ID*id)
+{
+	BY_HANDLE_FILE_INFORMATION info;
+
+	if (!HandleInfo(((WIN32_DIR*)dir)->path, &info))
+		return (0);
+
+	id->volume = info.dwVolumeSerialNumber;
+	id->file = ((unsigned long long)info.nFileIndexHigh << 32) |
+	    info.nFileIndexLow;
+
+	return (1);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static int HandleInfo(char*path, BY_HANDLE_FILE_INFORMATION*info)
+{
+	HANDLE handle;
+	int ok;
+
+	/* Opening the path follows links, so this describes the target. */
+	handle = CreateFile(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE |
+	    FILE_SHARE_DELETE, 0, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0);
+
+	if (handle == INVALID_HANDLE_VALUE)
+		return (0);
+
+	ok = GetFileInformationByHandle(handle, info) ? 1 : 0;
+
+	CloseHandle(handle);
+
+	return (ok);
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static long UnixFileTime(FILETIME*ft)
+{
+	ULARGE_INTEGER time;
+
+	time.LowPart = ft->dwLowDateTime;
+	time.HighPart = ft->dwHighDateTime;
+
+	/* 100ns ticks since 1601 to seconds since 1970. */
+	return ((long)(time.QuadPart / 10000000 - 11644473600));
+}
+
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_WildcardMatch(char*mask, char*filename)
+{
+	char ch1, ch2;
+
+	for (; *mask; mask++, filename++) {
+		if (*mask == '*') {
+			while (*mask == '*')
+				mask++;
+
+			if (!*mask)
+				return (1);
+
+			for (; *filename; filename++)
+				if (OS_WildcardMatch(mask, filename))
+					return (1);
+
+			return (0);
+		}
+
+		if (!*filename)
+			return (0);
+
+		if (*mask == '?')
+			continue;
+
+		ch1 = *mask;
+		ch2 = *filename;
+
+		if (ch1 >= 'a' && ch1 <= 'z')
+			ch1 -= 32;
+
+		if (ch2 >= 'a' && ch2 <= 'z')
+			ch2 -= 32;
+
+		if (ch1 != ch2)
+			return (0);
+	}
+
+	return (!*filename);
+}
+
+
 
 /*###########################################################################*/
 /*#                                                                         #*/
@@ -653,6 +940,218 @@ long OS_Filesize(FILE_HANDLE*fp)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void*OS_MapFile(FILE_HANDLE*fp, long size)
+{
+	HANDLE file, mapping;
+	void*data;
+
+	if (size <= 0)
+		return (0);
+
+	file = (HANDLE)_get_osfhandle(_fileno((FILE*)fp));
+
+	if (file == INVALID_HANDLE_VALUE)
+		return (0);
+
+	mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (!mapping)
+		return (0);
+
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+
+	/* The view holds its own reference to the mapping object. */
+	CloseHandle(mapping);
+
+	return (data);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_UnmapFile(void*data, long size)
+{
+	size = size;
+
+	if (data)
+		UnmapViewOfFile(data);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+static DWORD WINAPI ThreadEntry(LPVOID arg)
+{
+	WIN32_THREAD*thread = (WIN32_THREAD*)arg;
+
+	thread->pfn(thread->arg);
+
+	return (0);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_THREAD*OS_CreateThread(OS_THREAD_PFN*pfn, void*arg)
+{
+	WIN32_THREAD*thread;
+
+	thread = OS_Malloc(sizeof(WIN32_THREAD));
+
+	thread->pfn = pfn;
+	thread->arg = arg;
+
+	thread->handle = CreateThread(NULL, 0, ThreadEntry, thread, 0, NULL);
+
+	if (!thread->handle) {
+		OS_Free(thread);
+		return (0);
+	}
+
+	return (thread);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_JoinThread(OS_THREAD*thread)
+{
+	WaitForSingleObject(((WIN32_THREAD*)thread)->handle, INFINITE);
+	CloseHandle(((WIN32_THREAD*)thread)->handle);
+
+	OS_Free(thread);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_MUTEX*OS_CreateMutex(void)
+{
+	CRITICAL_SECTION*mutex;
+
+	mutex = OS_Malloc(sizeof(CRITICAL_SECTION));
+
+	InitializeCriticalSection(mutex);
+
+	return (mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_DestroyMutex(OS_MUTEX*mutex)
+{
+	DeleteCriticalSection((CRITICAL_SECTION*)mutex);
+
+	OS_Free(mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_LockMutex(OS_MUTEX*mutex)
+{
+	EnterCriticalSection((CRITICAL_SECTION*)mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_UnlockMutex(OS_MUTEX*mutex)
+{
+	LeaveCriticalSection((CRITICAL_SECTION*)mutex);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_NumProcessors(void)
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	return (info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+OS_SEMAPHORE*OS_CreateSemaphore(void)
+{
+	return (CreateSemaphore(NULL, 0, 0x7fffffff, NULL));
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_DestroySemaphore(OS_SEMAPHORE*semaphore)
+{
+	CloseHandle((HANDLE)semaphore);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_PostSemaphore(OS_SEMAPHORE*semaphore)
+{
+	ReleaseSemaphore((HANDLE)semaphore, 1, NULL);
+}
+
+/*###########################################################################*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+void OS_WaitSemaphore(OS_SEMAPHORE*semaphore)
+{
+	WaitForSingleObject((HANDLE)semaphore, INFINITE);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
@@ -286,6 +286,52 @@ void OS_PaintStatus(char*buffer)
 }
 
 
+/**************************************************************************/
+/* Invalidate just the rows the editor says have changed, one rectangle  */
+/* for each run of adjacent rows.                                        */
+/**************************************************************************/
+void OS_PaintRows(char*buffer, int*rows, int numRows)
+{
+	RECT rect;
+	int i, end;
+
+	proeditWindow.buffer = buffer;
+
+	old_buffer = buffer;
+
+	rect.left = 0;
+	rect.right = (displayXD*font_size_x) - 1;
+
+	for (i = 0; i < numRows; i = end) {
+		for (end = i + 1; end < numRows && rows[end] == rows[end - 1] + 1; end++)
+			;
+
+		rect.top = rows[i]*font_size_y;
+		rect.bottom = ((rows[end - 1] + 1)*font_size_y);
+
+		if (proeditWindow.hWndDisplay)
+			InvalidateRect(proeditWindow.hWndDisplay, &rect, FALSE);
+	}
+}
+
+
+/**************************************************************************/
+/* WM_PAINT draws straight from the editor's buffer, so there is nothing  */
+/* to move here. The moved rows are invalidated like any other.           */
+/**************************************************************************/
+int OS_ScrollRows(char*buffer, int x, int y, int columns, int rows, int shift)
+{
+	buffer = buffer;
+	x = x;
+	y = y;
+	columns = columns;
+	rows = rows;
+	shift = shift;
+
+	return (0);
+}
+
+
 /**************************************************************************/
 /**************************************************************************/
 /**************************************************************************/
@@ -626,6 +672,19 @@ int OS_PeekKey(int*mode, OS_MOUSE*mouse)
 }
 
 
+/*###########################################################################*/
+/*#                                                                         #*/
+/*# ToAscii keeps dead key state, so a key can't be read ahead and put      #*/
+/*# back. Always paint; WM_PAINT already merges the rows invalidated        #*/
+/*# by several paints into one.                                             #*/
+/*#                                                                         #*/
+/*###########################################################################*/
+int OS_InputPending(void)
+{
+	return (0);
+}
+
+
 /*###########################################################################*/
 /*#                                                                         #*/
 /*#                                                                         #*/
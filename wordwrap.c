@@ -122,7 +122,7 @@ static int WrapLine(EDIT_FILE*file, EDIT_CLIPBOARD*clipboard)
 	line = file->cursor.line->line;
 	wsLen = lineLen;
 
-	while (wsLen && (line[wsLen - 1] <= ED_KEY_SPACE))
+	while (wsLen && ((unsigned char)line[wsLen - 1] <= ED_KEY_SPACE))
 		wsLen--;
 
 	for (; ; ) {
@@ -139,7 +139,7 @@ static int WrapLine(EDIT_FILE*file, EDIT_CLIPBOARD*clipboard)
 			if (line[i] == ED_KEY_TABPAD)
 				continue;
 
-			if (i == 0 || line[i] <= ED_KEY_SPACE) {
+			if (i == 0 || (unsigned char)line[i] <= ED_KEY_SPACE) {
 				if (i < ((file->display.columns) / 4)) {
 					i = (file->display.columns);
 